@@ -0,0 +1,328 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rx/Observable.hpp"
+#include "rx/SafeSubscriber.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/Optional.hpp"
+
+//! Shares a single subscription to a source among all of its subscribers,
+//! created by Observable::publish().
+//!
+//! Subscribing only attaches to the current connection; the source is
+//! subscribed to once, by connect(), and every element it emits is passed
+//! to all subscribers attached at that moment. refCount() connects for the
+//! first subscriber and disconnects when the last one leaves. Once the
+//! source has terminated the next subscriber, or connect(), starts a new
+//! connection.
+template<class T>
+class ConnectableObservable : public Observable<T>
+{
+public:
+   static ConnectableObservable<T> create(Observable<T> source)
+   {
+      return ConnectableObservable(std::make_shared<State>(std::move(source)));
+   }
+
+   //! Subscribes to the source unless the current connection already is.
+   //! Unsubscribing the returned Subscription disconnects.
+   Subscription connect() const
+   {
+      std::weak_ptr<State> weak_state = m_state;
+      auto connection = m_state->connect();
+      return Subscription([weak_state, connection]() {
+         if (auto shared_state = weak_state.lock())
+         {
+            shared_state->disconnect(connection);
+         }
+      });
+   }
+
+   //! Returns an Observable that connects when it gets its first subscriber
+   //! and disconnects when its last subscriber unsubscribes.
+   Observable<T> refCount() const
+   {
+      auto shared_state = m_state;
+      return Observable<T>::create([shared_state](Subscriber<T> subscriber) {
+         shared_state->subscribeCounted(subscriber);
+      });
+   }
+
+private:
+   //! The subscribers of one subscription to the source.
+   //!
+   //! The subscriber array is copied on every change, so an element only
+   //! takes the lock to pick up the current array and is then passed on
+   //! without it, while subscribers come and go from other threads.
+   class Connection
+   {
+   public:
+      typedef std::vector<Subscriber<T>> Subscribers;
+
+      Connection()
+            : m_isConnected(false),
+              m_subscribers(std::make_shared<Subscribers>()),
+              m_isDone(false)
+      {
+      }
+
+      //! Returns false if the connection has terminated already.
+      bool add(Subscriber<T> subscriber)
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_isDone)
+         {
+            return false;
+         }
+         auto subscribers = std::make_shared<Subscribers>(*m_subscribers);
+         subscribers->push_back(std::move(subscriber));
+         m_subscribers = std::move(subscribers);
+         return true;
+      }
+
+      void remove(const Subscriber<T>& subscriber)
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         auto subscribers = std::make_shared<Subscribers>();
+         subscribers->reserve(m_subscribers->size());
+         for (auto& s : *m_subscribers)
+         {
+            if (!(s == subscriber))
+            {
+               subscribers->push_back(s);
+            }
+         }
+         m_subscribers = std::move(subscribers);
+      }
+
+      bool isDone()
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         return m_isDone;
+      }
+
+      void onNext(const T& t)
+      {
+         std::shared_ptr<const Subscribers> subscribers;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            subscribers = m_subscribers;
+         }
+         for (auto& s : *subscribers)
+         {
+            s.getObserver().onNext(t);
+         }
+      }
+
+      void onTerminate(std::exception_ptr e)
+      {
+         std::shared_ptr<const Subscribers> subscribers;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isDone = true;
+            subscribers = m_subscribers;
+            m_subscribers = std::make_shared<Subscribers>();
+         }
+         for (auto& s : *subscribers)
+         {
+            if (e)
+            {
+               s.getObserver().onError(e);
+            }
+            else
+            {
+               s.getObserver().onCompleted();
+            }
+         }
+      }
+
+      //! Guarded by the mutex of the State.
+      bool m_isConnected;
+      Subscription m_upstream;
+
+   private:
+      std::mutex m_mutex;
+      std::shared_ptr<const Subscribers> m_subscribers;
+      bool m_isDone;
+   };
+
+   class State : public Observable<T>::State,
+                 public std::enable_shared_from_this<State>
+   {
+   public:
+      explicit State(Observable<T> source)
+            : m_source(std::move(source)),
+              m_refCount(0)
+      {
+      }
+
+      void onSubscribe(Subscriber<T> subscriber) override
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         attach(subscriber);
+      }
+
+      std::shared_ptr<Connection> connect()
+      {
+         std::shared_ptr<Connection> connection;
+         Optional<Subscriber<T>> upstream;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            connection = currentConnection();
+            upstream = markConnected(connection);
+         }
+         start(upstream);
+         return connection;
+      }
+
+      void disconnect(const std::shared_ptr<Connection>& connection)
+      {
+         Subscription upstream;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            upstream = detach(connection);
+         }
+         upstream.unsubscribe();
+      }
+
+      void subscribeCounted(Subscriber<T> subscriber)
+      {
+         Optional<Subscriber<T>> upstream;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto connection = attach(subscriber);
+            // A connection that terminated without its subscribers leaving
+            // has been replaced by one that is not connected yet.
+            if (m_refCount++ == 0 || connection != m_refConnection)
+            {
+               m_refConnection = connection;
+               upstream = markConnected(connection);
+            }
+         }
+
+         auto shared_state = this->shared_from_this();
+         subscriber.add(Subscription([shared_state]() {
+            shared_state->release();
+         }));
+         start(upstream);
+      }
+
+   private:
+      //! Called with the lock held.
+      std::shared_ptr<Connection> currentConnection()
+      {
+         if (!m_connection || m_connection->isDone())
+         {
+            m_connection = std::make_shared<Connection>();
+         }
+         return m_connection;
+      }
+
+      //! Called with the lock held.
+      std::shared_ptr<Connection> attach(Subscriber<T> subscriber)
+      {
+         auto connection = currentConnection();
+         while (!connection->add(subscriber))
+         {
+            // Terminated since it was looked up.
+            connection = currentConnection();
+         }
+
+         std::weak_ptr<Connection> weak_connection = connection;
+         subscriber.add(Subscription([weak_connection, subscriber]() {
+            if (auto shared_connection = weak_connection.lock())
+            {
+               shared_connection->remove(subscriber);
+            }
+         }));
+         return connection;
+      }
+
+      //! Called with the lock held. Returns the subscriber to subscribe to
+      //! the source with, unless connection is connected already.
+      Optional<Subscriber<T>> markConnected(const std::shared_ptr<Connection>& connection)
+      {
+         Optional<Subscriber<T>> upstream;
+         if (connection->m_isConnected)
+         {
+            return upstream;
+         }
+
+         auto subscriber = createSafeSubscriber(Subscriber<T>(Observer<T>(
+            // onNext
+            [connection](const T& t) {
+               connection->onNext(t);
+            },
+            // onCompleted
+            [connection]() {
+               connection->onTerminate(nullptr);
+            },
+            // onError
+            [connection](std::exception_ptr e) {
+               connection->onTerminate(std::move(e));
+            })));
+
+         connection->m_isConnected = true;
+         connection->m_upstream = subscriber.getSubscription();
+         upstream.set(std::move(subscriber));
+         return upstream;
+      }
+
+      //! Called without the lock, the source may emit right away.
+      void start(Optional<Subscriber<T>>& upstream)
+      {
+         if (upstream.hasValue())
+         {
+            m_source.unsafeSubscribe(upstream.take());
+         }
+      }
+
+      //! Detaches the last subscriber's connection in the same critical
+      //! section that drops the count to zero, so a subscriber arriving
+      //! after it starts a new connection rather than joining the old one
+      //! just before it is unsubscribed.
+      void release()
+      {
+         Subscription upstream;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_refCount == 0 && m_refConnection)
+            {
+               upstream = detach(m_refConnection);
+               m_refConnection.reset();
+            }
+         }
+         upstream.unsubscribe();
+      }
+
+      //! Called with the lock held. Stops connection from being handed to
+      //! new subscribers and returns its subscription to the source, to be
+      //! unsubscribed once unlocked.
+      Subscription detach(const std::shared_ptr<Connection>& connection)
+      {
+         if (m_connection == connection)
+         {
+            m_connection.reset();
+         }
+         return connection->m_upstream;
+      }
+
+      const Observable<T> m_source;
+      std::mutex m_mutex;
+      std::shared_ptr<Connection> m_connection;
+      std::size_t m_refCount;
+      std::shared_ptr<Connection> m_refConnection;
+   };
+
+   ConnectableObservable(std::shared_ptr<State> state)
+         : Observable<T>(state),
+           m_state(std::move(state))
+   {
+   }
+
+   std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "rx/Observable.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+#include "rx/internal/Optional.hpp"
+
+//! Return type of a coroutine that produces the elements of an Observable
+//! with co_yield.
+//!
+//! The coroutine does not start until the Observable created by
+//! fromAsyncGenerator() is subscribed to. Every co_yield calls onNext
+//! directly and the coroutine carries on as soon as onNext returns, so
+//! nothing is buffered and no thread is needed besides the one that
+//! drives the coroutine. Returning completes the Observable, an escaping
+//! exception is passed to onError. The coroutine frame is destroyed at the
+//! first co_yield after the subscriber unsubscribed.
+template<class T>
+class AsyncGenerator
+{
+public:
+   typedef T ValueType;
+
+   class promise_type
+   {
+   public:
+      promise_type()
+            : m_observer(Observer<T>())
+      {
+      }
+
+      AsyncGenerator get_return_object()
+      {
+         return AsyncGenerator(Handle::from_promise(*this));
+      }
+
+      std::suspend_always initial_suspend() const noexcept
+      {
+         return {};
+      }
+
+      std::suspend_never final_suspend() const noexcept
+      {
+         return {};
+      }
+
+      auto yield_value(const T& t)
+      {
+         if (!m_cancellation.isCancelled())
+         {
+            m_observer.onNext(t);
+         }
+         return YieldAwaiter{ m_cancellation.isCancelled() };
+      }
+
+      void return_void()
+      {
+         m_observer.onCompleted();
+      }
+
+      void unhandled_exception()
+      {
+         m_observer.onError(std::current_exception());
+      }
+
+   private:
+      friend class AsyncGenerator;
+
+      //! Lets the coroutine carry on, or destroys it once cancelled.
+      struct YieldAwaiter
+      {
+         bool m_isCancelled;
+
+         bool await_ready() const noexcept
+         {
+            return !m_isCancelled;
+         }
+
+         void await_suspend(std::coroutine_handle<> handle) const noexcept
+         {
+            handle.destroy();
+         }
+
+         void await_resume() const noexcept
+         {
+         }
+      };
+
+      Observer<T> m_observer;
+      CancellationFlag m_cancellation;
+   };
+
+   AsyncGenerator(AsyncGenerator&& other) noexcept
+         : m_handle(std::exchange(other.m_handle, nullptr))
+   {
+   }
+
+   AsyncGenerator(const AsyncGenerator&) = delete;
+   AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+
+   ~AsyncGenerator()
+   {
+      if (m_handle)
+      {
+         m_handle.destroy();
+      }
+   }
+
+   //! Runs the coroutine until its first suspension, emitting to
+   //! subscriber. From then on the coroutine owns its frame.
+   void start(Subscriber<T> subscriber)
+   {
+      auto handle = std::exchange(m_handle, nullptr);
+      auto& promise = handle.promise();
+
+      promise.m_observer = subscriber.getObserver();
+      promise.m_cancellation = CancellationFlag::create(subscriber);
+      handle.resume();
+   }
+
+private:
+   typedef std::coroutine_handle<promise_type> Handle;
+
+   explicit AsyncGenerator(Handle handle)
+         : m_handle(handle)
+   {
+   }
+
+   Handle m_handle;
+};
+
+//! Creates an Observable that calls factory, a coroutine returning an
+//! AsyncGenerator, once per subscription. If factory is a coroutine lambda,
+//! its captures live in the Observable rather than in the coroutine frame.
+template<class Factory,
+         class T = typename std::result_of<Factory()>::type::ValueType>
+Observable<T> fromAsyncGenerator(Factory factory)
+{
+   return Observable<T>::create([factory](Subscriber<T> s) {
+      factory().start(s);
+   });
+}
+
+
+//! Lets a coroutine consume an Observable one element at a time:
+//!
+//!    auto stream = awaitEach(observable);
+//!    while (co_await stream.next())
+//!    {
+//!       use(stream.current());
+//!    }
+//!
+//! The source is subscribed to on the first next(). An element that
+//! arrives while the coroutine waits in next() resumes it on the emitting
+//! thread right away; elements that arrive while it is busy elsewhere are
+//! kept in a deque, which allocates per block rather than per element.
+//! next() rethrows an error of the source. Destroying the stream
+//! unsubscribes from the source.
+template<class T>
+class ObservableStream
+{
+   struct State;
+
+public:
+   class NextAwaiter
+   {
+   public:
+      explicit NextAwaiter(std::shared_ptr<State> state)
+            : m_state(std::move(state))
+      {
+      }
+
+      bool await_ready() const
+      {
+         std::lock_guard<std::mutex> lock(m_state->m_mutex);
+         return m_state->isReady();
+      }
+
+      bool await_suspend(std::coroutine_handle<> handle) const
+      {
+         // The source may resume, and even finish, the coroutine from
+         // within subscribe, taking this awaiter with it, so only locals
+         // are touched from here on.
+         auto state = m_state;
+         {
+            std::lock_guard<std::mutex> lock(state->m_mutex);
+            if (state->isReady())
+            {
+               return false;
+            }
+            state->m_waiting = handle;
+            if (state->m_isSubscribed)
+            {
+               return true;
+            }
+            state->m_isSubscribed = true;
+         }
+
+         auto subscription = state->m_source.subscribe(createObserver(state));
+
+         std::unique_lock<std::mutex> lock(state->m_mutex);
+         if (state->m_isClosed)
+         {
+            lock.unlock();
+            subscription.unsubscribe();
+         }
+         else
+         {
+            state->m_subscription = subscription;
+         }
+         return true;
+      }
+
+      bool await_resume() const
+      {
+         std::lock_guard<std::mutex> lock(m_state->m_mutex);
+         if (!m_state->m_queue.empty())
+         {
+            m_state->m_current.set(std::move(m_state->m_queue.front()));
+            m_state->m_queue.pop_front();
+            return true;
+         }
+         if (m_state->m_error)
+         {
+            std::rethrow_exception(m_state->m_error);
+         }
+         return false;
+      }
+
+   private:
+      std::shared_ptr<State> m_state;
+   };
+
+   explicit ObservableStream(Observable<T> source)
+         : m_state(std::make_shared<State>(std::move(source)))
+   {
+   }
+
+   ObservableStream(ObservableStream&&) = default;
+
+   ObservableStream(const ObservableStream&) = delete;
+   ObservableStream& operator=(const ObservableStream&) = delete;
+
+   ~ObservableStream()
+   {
+      if (!m_state)
+      {
+         return;
+      }
+
+      Subscription subscription;
+      {
+         std::lock_guard<std::mutex> lock(m_state->m_mutex);
+         m_state->m_isClosed = true;
+         m_state->m_queue.clear();
+         subscription = m_state->m_subscription;
+      }
+      subscription.unsubscribe();
+   }
+
+   //! Waits for the next element. Resumes with false once the source has
+   //! completed.
+   NextAwaiter next()
+   {
+      return NextAwaiter(m_state);
+   }
+
+   //! The element of the last next() that resumed with true.
+   const T& current() const
+   {
+      return m_state->m_current.get();
+   }
+
+private:
+   struct State
+   {
+      State(Observable<T> source)
+            : m_source(std::move(source)),
+              m_isSubscribed(false),
+              m_isDone(false),
+              m_isClosed(false)
+      {
+      }
+
+      bool isReady() const
+      {
+         return !m_queue.empty() || m_isDone;
+      }
+
+      Observable<T> m_source;
+      std::mutex m_mutex;
+      std::deque<T> m_queue;
+      Optional<T> m_current;
+      std::coroutine_handle<> m_waiting;
+      Subscription m_subscription;
+      std::exception_ptr m_error;
+      bool m_isSubscribed;
+      bool m_isDone;
+      bool m_isClosed;
+   };
+
+   static std::coroutine_handle<> takeWaiting(State& state)
+   {
+      return std::exchange(state.m_waiting, nullptr);
+   }
+
+   static Observer<T> createObserver(std::shared_ptr<State> state)
+   {
+      return Observer<T>(
+         // onNext
+         [state](const T& t) {
+            std::coroutine_handle<> waiting;
+            {
+               std::lock_guard<std::mutex> lock(state->m_mutex);
+               if (state->m_isClosed)
+               {
+                  return;
+               }
+               state->m_queue.push_back(t);
+               waiting = takeWaiting(*state);
+            }
+            if (waiting)
+            {
+               waiting.resume();
+            }
+         },
+         // onCompleted
+         [state]() {
+            std::coroutine_handle<> waiting;
+            {
+               std::lock_guard<std::mutex> lock(state->m_mutex);
+               state->m_isDone = true;
+               waiting = takeWaiting(*state);
+            }
+            if (waiting)
+            {
+               waiting.resume();
+            }
+         },
+         // onError
+         [state](std::exception_ptr e) {
+            std::coroutine_handle<> waiting;
+            {
+               std::lock_guard<std::mutex> lock(state->m_mutex);
+               state->m_error = e;
+               state->m_isDone = true;
+               waiting = takeWaiting(*state);
+            }
+            if (waiting)
+            {
+               waiting.resume();
+            }
+         });
+   }
+
+   std::shared_ptr<State> m_state;
+};
+
+template<class T>
+ObservableStream<T> awaitEach(Observable<T> source)
+{
+   return ObservableStream<T>(std::move(source));
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//! Asynchronous positional file reads and writes.
+//!
+//! On kernels with io_uring the requests are placed in the submission ring
+//! and handed to the kernel with one syscall per submit(); a single thread
+//! reaps completions. Elsewhere a pool of threads runs pread and pwrite.
+//! Either way requests beyond the queue depth wait in a backlog rather
+//! than blocking the caller.
+class FileIo
+{
+public:
+   struct Request;
+
+   class Handler
+   {
+   public:
+      virtual ~Handler() = default;
+
+      //! result is the byte count, or a negated errno. Runs on an I/O
+      //! thread; with the thread pool on several at once. Requests the
+      //! kernel refuses to take complete with the error inside submit(),
+      //! so it must not be called with a lock the handler takes.
+      virtual void onIoCompleted(Request& request, long result) = 0;
+   };
+
+   //! Owned by the caller and must stay alive, unchanged, until its
+   //! handler has been called.
+   struct Request
+   {
+      int m_fd;
+      bool m_isWrite;
+      char* m_data;
+      std::size_t m_length;
+      std::uint64_t m_offset;
+      Handler* m_handler;
+   };
+
+   struct Stats
+   {
+      std::uint64_t m_syscalls;
+      std::uint64_t m_bytes;
+   };
+
+   //! Uses io_uring if the kernel supports it and the thread pool
+   //! otherwise.
+   static FileIo create(unsigned queueDepth = 64);
+
+   //! Throws std::system_error if io_uring, or its read and write
+   //! operations, are not available.
+   static FileIo createUring(unsigned queueDepth = 64);
+
+   static FileIo createThreadPool(unsigned threadCount = 4);
+
+   static FileIo getDefault();
+
+   //! Queues request without handing it to the kernel yet.
+   void queue(Request& request) const;
+
+   //! Hands every queued request to the kernel.
+   void submit() const;
+
+   bool isUring() const;
+
+   //! Syscalls made to read or write, and bytes transferred, so far.
+   Stats getStats() const;
+
+   class State
+   {
+   public:
+      virtual ~State() = default;
+
+      virtual void queue(Request& request) = 0;
+
+      virtual void submit() = 0;
+
+      virtual bool isUring() const = 0;
+
+      virtual Stats getStats() const = 0;
+   };
+
+private:
+   FileIo(std::shared_ptr<State> state);
+
+   std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "rx/Observable.hpp"
+
+//! An Observable of the elements that share the key it was created for.
+template<class K, class T>
+class GroupedObservable : public Observable<T>
+{
+public:
+   GroupedObservable(K key, Observable<T> source)
+         : Observable<T>(std::move(source)),
+           m_key(std::move(key))
+   {
+   }
+
+   const K& getKey() const
+   {
+      return m_key;
+   }
+
+private:
+   K m_key;
+};
@@ -1,22 +1,46 @@
 #pragma once
 
 #include <functional>
+#include <stdexcept>
+#include <thread>
 
 #include "rx/Observer.hpp"
 #include "rx/Subscription.hpp"
 #include "rx/Subscriber.hpp"
 #include "rx/SafeSubscriber.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/schedulers/ThreadPoolScheduler.hpp"
+#include "rx/schedulers/TimingWheelScheduler.hpp"
+#include "rx/operators/Buffer.hpp"
+#include "rx/operators/ConcatMap.hpp"
+#include "rx/operators/Debounce.hpp"
+#include "rx/operators/Distinct.hpp"
+#include "rx/operators/GroupBy.hpp"
 #include "rx/operators/Map.hpp"
-#include "rx/operators/Range.hpp"
+#include "rx/operators/MapConcurrent.hpp"
+#include "rx/operators/Parallel.hpp"
+#include "rx/operators/Retry.hpp"
+#include "rx/operators/Sample.hpp"
+#include "rx/operators/ThrottleFirst.hpp"
+#include "rx/operators/Timeout.hpp"
+#include "rx/operators/Window.hpp"
 
 template <class T>
 using OnSubscribeFunc = std::function<void(Subscriber<T>)>;
 
+template<class T>
+class ConnectableObservable;
+
+template<class T>
+class ReplaySubject;
+
 template<class T>
 class Observable
 {
 public:
-   Subscription subscribe(Observer<T> observer)
+   typedef T ValueType;
+
+   Subscription subscribe(Observer<T> observer) const
    {
       auto subscriber = Subscriber<T>(observer);
       auto safeSubscriber = createSafeSubscriber(subscriber);
@@ -24,19 +48,28 @@ public:
       return safeSubscriber.getSubscription();
    }
 
-   Subscription subscribe(OnNext<T> onNext)
+   Subscription subscribe(OnNext<T> onNext) const
    {
       auto observer = Observer<T>(std::move(onNext));
       return subscribe(observer);
    }
 
+   //! Subscribes without wrapping subscriber in a SafeSubscriber. Meant for
+   //! operators that manage the subscriber themselves, for example to
+   //! reuse it for several sources.
+   Subscription unsafeSubscribe(Subscriber<T> subscriber) const
+   {
+      m_state->onSubscribe(subscriber);
+      return subscriber.getSubscription();
+   }
+
    static Observable create(OnSubscribeFunc<T> onSubscribe)
    {
       return Observable(std::move(onSubscribe));
    }
 
    template<class R>
-   Observable<R> lift(std::function<Subscriber<T>(Subscriber<R>)> liftFunc)
+   Observable<R> lift(std::function<Subscriber<T>(Subscriber<R>)> liftFunc) const
    {
       auto shared_state = m_state;
       return Observable<R>::create([shared_state, liftFunc](Subscriber<R> o){
@@ -45,7 +78,7 @@ public:
    };
 
    template<class Callable>
-   auto map(Callable transformer)
+   auto map(Callable transformer) const
       -> Observable<typename std::result_of<Callable(T)>::type>
    {
       typedef typename std::result_of<Callable(T)>::type R;
@@ -58,23 +91,357 @@ public:
       });
    }
 
+   //! Like map, but runs transformer on scheduler for up to maxInFlight
+   //! elements at a time and emits the results in the order of the
+   //! source. The source is held up while maxInFlight elements are in
+   //! flight, so it must not emit on the scheduler's threads.
+   template<class Callable>
+   auto mapConcurrent(Callable transformer, std::size_t maxInFlight,
+                      Scheduler scheduler = ThreadPoolScheduler::getDefault()) const
+      -> Observable<typename std::decay<typename std::result_of<Callable(T)>::type>::type>
+   {
+      typedef typename std::decay<
+            typename std::result_of<Callable(T)>::type>::type R;
+
+      return lift<R>([transformer, maxInFlight, scheduler](Subscriber<R> subscriber){
+         return createOperatorMapConcurrent<T, R, Callable>(subscriber, transformer,
+                                                            maxInFlight, scheduler);
+      });
+   }
+
+   //! Maps every element to an Observable and concatenates their elements.
+   template<class Callable>
+   auto concatMap(Callable f) const
+      -> Observable<typename std::decay<
+            typename std::result_of<Callable(T)>::type>::type::ValueType>
+   {
+      typedef typename std::decay<
+            typename std::result_of<Callable(T)>::type>::type::ValueType R;
+
+      return lift<R>([f](Subscriber<R> subscriber){
+         return createOperatorConcatMap<T, R, Callable>(subscriber, f);
+      });
+   }
+
+   //! Splits the elements into one GroupedObservable per distinct key.
+   template<class KeySelector>
+   auto groupBy(KeySelector keySelector) const
+      -> Observable<GroupedObservable<
+            typename std::decay<typename std::result_of<KeySelector(T)>::type>::type, T>>
+   {
+      typedef typename std::decay<
+            typename std::result_of<KeySelector(T)>::type>::type K;
+      typedef GroupedObservable<K, T> R;
+
+      return lift<R>([keySelector](Subscriber<R> subscriber){
+         auto observer = subscriber.getObserver();
+
+         return Subscriber<T>(
+                  createOperatorGroupBy<T, K, KeySelector>(observer, keySelector));
+      });
+   }
+
+   //! Drops the elements that were seen before.
+   Observable<T> distinct() const
+   {
+      return distinct([](const T& t) { return t; });
+   }
+
+   //! Drops the elements whose key was seen before. If maxSize is not zero
+   //! at most maxSize keys are remembered, forgetting the least recently
+   //! seen ones first. The table sizes add up in report if one is given.
+   template<class KeySelector>
+   Observable<T> distinct(KeySelector keySelector, std::size_t maxSize = 0,
+                          std::shared_ptr<DistinctReport> report = nullptr) const
+   {
+      typedef typename std::decay<
+            typename std::result_of<KeySelector(T)>::type>::type K;
+
+      return lift<T>([keySelector, maxSize, report](Subscriber<T> subscriber){
+         auto observer = subscriber.getObserver();
+
+         return Subscriber<T>(createOperatorDistinct<T, K, KeySelector>(
+                  observer, keySelector, maxSize, report));
+      });
+   }
+
+   //! Drops the elements that are equal to the element before them.
+   Observable<T> distinctUntilChanged() const
+   {
+      return distinctUntilChanged([](const T& a, const T& b) { return a == b; });
+   }
+
+   //! Drops the elements for which isEqual(previous, current) is true.
+   template<class Comparator>
+   Observable<T> distinctUntilChanged(Comparator isEqual) const
+   {
+      return lift<T>([isEqual](Subscriber<T> subscriber){
+         auto observer = subscriber.getObserver();
+
+         return Subscriber<T>(
+                  createOperatorDistinctUntilChanged<T, Comparator>(observer, isEqual));
+      });
+   }
+
+   //! Emits the elements in batches of count. The emitted vector is reused
+   //! for the next batch once onNext returns. Throws std::invalid_argument
+   //! if count is 0.
+   Observable<std::vector<T>> buffer(std::size_t count) const
+   {
+      typedef std::vector<T> R;
+
+      if (count == 0)
+      {
+         throw std::invalid_argument("buffer count must not be 0");
+      }
+
+      return lift<R>([count](Subscriber<R> subscriber){
+         auto observer = subscriber.getObserver();
+
+         return Subscriber<T>(createOperatorBuffer<T>(observer, count));
+      });
+   }
+
+   //! Emits the elements collected during every timespan, or as soon as
+   //! maxCount have been collected if maxCount is not zero.
+   Observable<std::vector<T>> buffer(Scheduler::Duration timespan,
+                                     std::size_t maxCount = 0,
+                                     Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      typedef std::vector<T> R;
+
+      return lift<R>([timespan, maxCount, scheduler](Subscriber<R> subscriber){
+         return createOperatorBufferWithTime<T>(subscriber, timespan, maxCount,
+                                                scheduler);
+      });
+   }
+
+   //! Splits the elements into windows of count elements. Throws
+   //! std::invalid_argument if count is 0.
+   Observable<Observable<T>> window(std::size_t count) const
+   {
+      typedef Observable<T> R;
+
+      if (count == 0)
+      {
+         throw std::invalid_argument("window count must not be 0");
+      }
+
+      return lift<R>([count](Subscriber<R> subscriber){
+         auto observer = subscriber.getObserver();
+
+         return Subscriber<T>(createOperatorWindow<T>(observer, count));
+      });
+   }
+
+   //! Opens a new window every timespan.
+   Observable<Observable<T>> window(Scheduler::Duration timespan,
+                                    Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      typedef Observable<T> R;
+
+      return lift<R>([timespan, scheduler](Subscriber<R> subscriber){
+         return createOperatorWindowWithTime<T>(subscriber, timespan, scheduler);
+      });
+   }
+
+   //! Emits an element only if timeout passes without another element.
+   Observable<T> debounce(Scheduler::Duration timeout,
+                          Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return lift<T>([timeout, scheduler](Subscriber<T> subscriber){
+         return createOperatorDebounce<T>(subscriber, timeout, scheduler);
+      });
+   }
+
+   //! Emits the first element of every windowDuration long window.
+   Observable<T> throttleFirst(Scheduler::Duration windowDuration,
+                               Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return lift<T>([windowDuration, scheduler](Subscriber<T> subscriber){
+         auto observer = subscriber.getObserver();
+
+         return Subscriber<T>(
+                  createOperatorThrottleFirst<T>(observer, windowDuration, scheduler));
+      });
+   }
+
+   //! Fails with TimeoutException once timeout passes without an element.
+   Observable<T> timeout(Scheduler::Duration timeout,
+                         Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return lift<T>([timeout, scheduler](Subscriber<T> subscriber){
+         return createOperatorTimeout<T>(subscriber, timeout, true, scheduler, nullptr);
+      });
+   }
+
+   //! Switches to fallback once timeout passes without an element. Every
+   //! element of the source comes before those of fallback.
+   Observable<T> timeout(Scheduler::Duration timeout, Observable<T> fallback,
+                         Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return lift<T>([timeout, fallback, scheduler](Subscriber<T> subscriber){
+         return createOperatorTimeout<T>(subscriber, timeout, true, scheduler,
+               [fallback](Subscriber<T> s) {
+                  fallback.unsafeSubscribe(s);
+               });
+      });
+   }
+
+   //! Fails with TimeoutException unless the stream terminates within
+   //! timeout of the subscription, however many elements it emits.
+   Observable<T> streamTimeout(Scheduler::Duration timeout,
+                               Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return lift<T>([timeout, scheduler](Subscriber<T> subscriber){
+         return createOperatorTimeout<T>(subscriber, timeout, false, scheduler, nullptr);
+      });
+   }
+
+   //! Switches to fallback unless the stream terminates within timeout of
+   //! the subscription. Every element of the source comes before those of
+   //! fallback.
+   Observable<T> streamTimeout(Scheduler::Duration timeout, Observable<T> fallback,
+                               Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return lift<T>([timeout, fallback, scheduler](Subscriber<T> subscriber){
+         return createOperatorTimeout<T>(subscriber, timeout, false, scheduler,
+               [fallback](Subscriber<T> s) {
+                  fallback.unsafeSubscribe(s);
+               });
+      });
+   }
+
+   //! Emits the most recent element once every period.
+   Observable<T> sample(Scheduler::Duration period,
+                        Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return lift<T>([period, scheduler](Subscriber<T> subscriber){
+         return createOperatorSample<T>(subscriber, period, scheduler);
+      });
+   }
+
+   Observable<T> throttleLast(Scheduler::Duration period,
+                              Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return sample(period, scheduler);
+   }
+
+   //! Resubscribes to the source right away whenever it fails, up to count
+   //! times. Elements of failed attempts are passed on as well.
+   Observable<T> retry(std::size_t count) const
+   {
+      return retryWhen(RetryPolicy::immediate(count));
+   }
+
+   //! Resubscribes to the source whenever it fails, after the delay that
+   //! policy decides on, until policy gives up. Delayed attempts subscribe
+   //! on scheduler's thread.
+   Observable<T> retryWhen(RetryPolicy policy,
+                           Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      auto source = *this;
+      return create([source, policy, scheduler](Subscriber<T> subscriber){
+         subscribeWithRetry(source, subscriber, policy, scheduler);
+      });
+   }
+
+   //! Returns an Observable that subscribes to this one only when connected
+   //! and passes its elements to all of its subscribers.
+   ConnectableObservable<T> publish() const
+   {
+      return ConnectableObservable<T>::create(*this);
+   }
+
+   //! Shares one subscription to this Observable among all subscribers,
+   //! subscribing with the first and unsubscribing after the last.
+   Observable<T> share() const
+   {
+      return publish().refCount();
+   }
+
+   //! Subscribes to this Observable with the first subscriber and replays
+   //! the last count elements to every later one.
+   Observable<T> replay(std::size_t count) const
+   {
+      return replayThrough(*this, ReplaySubject<T>::createWithSize(count));
+   }
+
+   //! Subscribes to this Observable with the first subscriber and replays
+   //! the elements of the last window to every later one.
+   Observable<T> replay(Scheduler::Duration window,
+                        Scheduler scheduler = TimingWheelScheduler::getDefault()) const
+   {
+      return replayThrough(*this, ReplaySubject<T>::createWithTime(window, scheduler));
+   }
+
+   //! Subscribes to this Observable with the first subscriber and replays
+   //! every element to every later one.
+   Observable<T> cache() const
+   {
+      return replayThrough(*this, ReplaySubject<T>::create());
+   }
+
+   //! Deals the elements round-robin onto railCount rails, which run the
+   //! stages added to the returned ParallelObservable in parallel.
+   ParallelObservable<T, T> parallel(
+         std::size_t railCount = std::thread::hardware_concurrency()) const
+   {
+      return ParallelObservable<T, T>(*this, railCount, nullptr,
+            [](const T& t, Optional<T>& result) {
+               result.set(t);
+            });
+   }
+
+   //! Deals the elements onto railCount rails by the hash of their key, so
+   //! that all elements of a key go through the same rail in order.
+   template<class KeySelector>
+   ParallelObservable<T, T> parallel(std::size_t railCount,
+                                     KeySelector keySelector) const
+   {
+      typedef typename std::decay<
+            typename std::result_of<KeySelector(T)>::type>::type K;
+
+      return ParallelObservable<T, T>(*this, railCount,
+            [keySelector](const T& t) {
+               return std::hash<K>()(keySelector(t));
+            },
+            [](const T& t, Optional<T>& result) {
+               result.set(t);
+            });
+   }
+
 protected:
+   class State
+   {
+   public:
+      virtual ~State() = default;
+
+      virtual void onSubscribe(Subscriber<T> observer) = 0;
+   };
+
    // Only use if you need to subclass Observable, otherwise use create
    Observable(OnSubscribeFunc<T> onSubscribeFunc)
-         : m_state(std::make_shared<State>(std::move(onSubscribeFunc)))
+         : m_state(std::make_shared<OnSubscribeFuncState>(std::move(onSubscribeFunc)))
+   {
+   }
+
+   //! Lets subclasses keep all of their state in a single allocation.
+   Observable(std::shared_ptr<State> state)
+         : m_state(std::move(state))
    {
    }
 
 private:
-   class State
+   class OnSubscribeFuncState : public State
    {
    public:
-      State(OnSubscribeFunc<T> onSubscribeFunc)
+      OnSubscribeFuncState(OnSubscribeFunc<T> onSubscribeFunc)
             : m_onSubscribeFunc(std::move(onSubscribeFunc))
       {
       }
 
-      void onSubscribe(Subscriber<T> observer)
+      void onSubscribe(Subscriber<T> observer) override
       {
          m_onSubscribeFunc(observer);
       }
@@ -85,3 +452,11 @@ private:
 
    std::shared_ptr<State> m_state;
 };
+
+// Operators that create these need the complete types when they are
+// instantiated, and all of them build on Observable.
+#include "rx/ConnectableObservable.hpp"
+#include "rx/GroupedObservable.hpp"
+#include "rx/ParallelObservable.hpp"
+#include "rx/ReplaySubject.hpp"
+#include "rx/UnicastSubject.hpp"
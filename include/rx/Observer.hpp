@@ -1,7 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 
+#include "rx/internal/ObjectPool.hpp"
+
 template<class T>
 using OnNext = std::function<void(const T&)>;
 
@@ -13,13 +16,26 @@ template<class T>
 class Observer {
 public:
    Observer()
-         : m_state(std::make_shared<State>(nullptr, nullptr, nullptr))
+         : m_state(std::allocate_shared<State>(PoolAllocator<State>(),
+                                               nullptr, nullptr, nullptr))
    {
    }
 
    Observer(OnNext<T> onNext, OnCompleted onCompleted = nullptr, OnError onError = nullptr)
-         : m_state(std::make_shared<State>(std::move(onNext), std::move(onCompleted), std::move(onError)))
+         : m_state(std::allocate_shared<State>(PoolAllocator<State>(), std::move(onNext),
+                                               std::move(onCompleted), std::move(onError)))
+   {
+   }
+
+   //! For callbacks that only capture a pointer into owner, which keeps
+   //! them within the small buffer of std::function. The observer keeps
+   //! owner alive.
+   Observer(std::shared_ptr<void> owner, OnNext<T> onNext, OnCompleted onCompleted,
+            OnError onError)
+         : m_state(std::allocate_shared<State>(PoolAllocator<State>(), std::move(onNext),
+                                               std::move(onCompleted), std::move(onError)))
    {
+      m_state->m_owner = std::move(owner);
    }
 
    void onNext(const T& t) const
@@ -59,6 +75,7 @@ private:
       OnNext<T> m_onNext;
       OnCompleted m_onCompleted;
       OnError m_onError;
+      std::shared_ptr<void> m_owner;
    };
 
    std::shared_ptr<State> m_state;
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "rx/Observable.hpp"
+#include "rx/operators/Parallel.hpp"
+#include "rx/schedulers/ThreadPoolScheduler.hpp"
+
+//! A stream split onto rails, created by Observable::parallel().
+//!
+//! map() and filter() add stages that every rail runs as a task on a
+//! scheduler, so that expensive per element work is spread over as many
+//! cores as there are rails. sequential() and ordered() join the rails
+//! into one Observable again. S is the element type of the source, T that
+//! of the rails.
+template<class S, class T>
+class ParallelObservable
+{
+public:
+   typedef T ValueType;
+   typedef typename ParallelState<S, T>::Chain Chain;
+   typedef typename ParallelState<S, T>::Router Router;
+
+   ParallelObservable(Observable<S> source, std::size_t railCount, Router router,
+                      Chain chain,
+                      Scheduler scheduler = ThreadPoolScheduler::getDefault())
+         : m_source(std::move(source)),
+           m_railCount(railCount == 0 ? 1 : railCount),
+           m_router(std::move(router)),
+           m_chain(std::move(chain)),
+           m_scheduler(std::move(scheduler))
+   {
+   }
+
+   std::size_t getRailCount() const
+   {
+      return m_railCount;
+   }
+
+   //! Runs the rails on scheduler instead of the default ThreadPoolScheduler.
+   ParallelObservable runOn(Scheduler scheduler) const
+   {
+      return ParallelObservable(m_source, m_railCount, m_router, m_chain,
+                                std::move(scheduler));
+   }
+
+   template<class Callable>
+   auto map(Callable transformer) const
+      -> ParallelObservable<S, typename std::decay<
+            typename std::result_of<Callable(T)>::type>::type>
+   {
+      typedef typename std::decay<
+            typename std::result_of<Callable(T)>::type>::type R;
+
+      auto chain = m_chain;
+      return ParallelObservable<S, R>(m_source, m_railCount, m_router,
+            [chain, transformer](const S& s, Optional<R>& r) {
+               Optional<T> t;
+               chain(s, t);
+               if (t.hasValue())
+               {
+                  r.set(transformer(t.get()));
+               }
+            },
+            m_scheduler);
+   }
+
+   template<class Predicate>
+   ParallelObservable filter(Predicate predicate) const
+   {
+      auto chain = m_chain;
+      return ParallelObservable(m_source, m_railCount, m_router,
+            [chain, predicate](const S& s, Optional<T>& t) {
+               chain(s, t);
+               if (t.hasValue() && !predicate(t.get()))
+               {
+                  t.reset();
+               }
+            },
+            m_scheduler);
+   }
+
+   //! Joins the rails, emitting results in the order the rails produce
+   //! them. Elements of the same rail keep their order.
+   Observable<T> sequential() const
+   {
+      return join(false);
+   }
+
+   //! Joins the rails, emitting results in the order of the source. Only
+   //! rails that were dealt round-robin can be ordered; with a key
+   //! selector the elements of each key keep their order anyway, and this
+   //! throws std::logic_error.
+   Observable<T> ordered() const
+   {
+      if (m_router)
+      {
+         throw std::logic_error("ordered() needs round-robin rails");
+      }
+      return join(true);
+   }
+
+private:
+   Observable<T> join(bool isOrdered) const
+   {
+      auto railCount = m_railCount;
+      auto router = m_router;
+      auto chain = m_chain;
+      auto scheduler = m_scheduler;
+
+      return m_source.template lift<T>(
+            [railCount, router, chain, isOrdered, scheduler](Subscriber<T> subscriber) {
+               return createOperatorParallel<S, T>(subscriber, railCount, router,
+                                                   chain, isOrdered, scheduler);
+            });
+   }
+
+   Observable<S> m_source;
+   std::size_t m_railCount;
+   Router m_router;
+   Chain m_chain;
+   Scheduler m_scheduler;
+};
@@ -0,0 +1,420 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rx/Observable.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/Optional.hpp"
+#include "rx/schedulers/TimingWheelScheduler.hpp"
+
+//! Elements stored per chunk of a ReplaySubject.
+const std::size_t REPLAY_CHUNK_SIZE = 64;
+
+//! A Subject that replays the elements it has seen to every subscriber,
+//! all of them, the last maxSize or those of the last window.
+//!
+//! Elements are appended to a linked list of fixed size chunks, which is
+//! never reallocated or copied as it grows. A chunk and its link to the
+//! next are written before the element count that covers them is
+//! published with a release store, so subscribers read the history
+//! without taking a lock: each of them only keeps the chunk it is in and
+//! its position, and walks the chunks on its own, in its own drain loop.
+//! Bounded subjects drop whole chunks from the front once none of their
+//! elements can be replayed any more; a chunk is freed when the last
+//! subscriber still reading it moves on.
+//!
+//! onNext, onCompleted and onError must not be called concurrently.
+template<class T>
+class ReplaySubject : public Observable<T>
+{
+public:
+   //! Replays every element.
+   static ReplaySubject<T> create()
+   {
+      return ReplaySubject(std::make_shared<State>(0, Scheduler::Duration::zero(),
+                                                   nullptr));
+   }
+
+   //! Replays the last maxSize elements.
+   static ReplaySubject<T> createWithSize(std::size_t maxSize)
+   {
+      return ReplaySubject(std::make_shared<State>(maxSize == 0 ? 1 : maxSize,
+                                                   Scheduler::Duration::zero(),
+                                                   nullptr));
+   }
+
+   //! Replays the elements that arrived within the last window.
+   static ReplaySubject<T> createWithTime(
+         Scheduler::Duration window,
+         Scheduler scheduler = TimingWheelScheduler::getDefault())
+   {
+      return ReplaySubject(std::make_shared<State>(
+            0, window, std::make_shared<Scheduler>(std::move(scheduler))));
+   }
+
+   void onNext(const T& t) const
+   {
+      m_state->onNext(t);
+   }
+
+   void onCompleted() const
+   {
+      m_state->onTerminate(nullptr);
+   }
+
+   void onError(std::exception_ptr e) const
+   {
+      m_state->onTerminate(std::move(e));
+   }
+
+private:
+   struct Chunk
+   {
+      struct Slot
+      {
+         Optional<T> m_value;
+         Scheduler::TimePoint m_time;
+      };
+
+      ~Chunk()
+      {
+         // Unlinks the chunks nobody else holds one at a time, instead of
+         // recursing once per chunk.
+         auto next = std::move(m_next);
+         while (next && next.use_count() == 1)
+         {
+            next = std::move(next->m_next);
+         }
+      }
+
+      Slot m_slots[REPLAY_CHUNK_SIZE];
+      //! Written once, before the count that covers its first element.
+      std::shared_ptr<Chunk> m_next;
+   };
+
+   struct Reader
+   {
+      Reader(Observer<T> observer)
+            : m_observer(std::move(observer)),
+              m_offset(0),
+              m_index(0),
+              m_wip(1),
+              m_isCancelled(false)
+      {
+      }
+
+      const Observer<T> m_observer;
+      std::shared_ptr<Chunk> m_chunk;
+      //! Position within m_chunk, REPLAY_CHUNK_SIZE when it has been read.
+      std::size_t m_offset;
+      std::uint64_t m_index;
+      std::atomic<int> m_wip;
+      std::atomic<bool> m_isCancelled;
+   };
+
+   typedef std::vector<std::shared_ptr<Reader>> Readers;
+
+   class State : public Observable<T>::State,
+                 public std::enable_shared_from_this<State>
+   {
+   public:
+      State(std::size_t maxSize, Scheduler::Duration window,
+            std::shared_ptr<Scheduler> scheduler)
+            : m_maxSize(maxSize),
+              m_window(window),
+              m_scheduler(std::move(scheduler)),
+              m_readers(std::make_shared<Readers>()),
+              m_head(std::make_shared<Chunk>()),
+              m_headIndex(0),
+              m_tail(m_head),
+              m_tailOffset(0),
+              m_size(0),
+              m_isDone(false)
+      {
+      }
+
+      void onSubscribe(Subscriber<T> subscriber) override
+      {
+         // The reader owns its drain loop until it has found where to
+         // start, so elements arriving meanwhile only mark it as missed.
+         auto reader = std::make_shared<Reader>(subscriber.getObserver());
+         std::uint64_t index;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto readers = std::make_shared<Readers>(*m_readers);
+            readers->push_back(reader);
+            m_readers = std::move(readers);
+            reader->m_chunk = m_head;
+            index = m_headIndex;
+         }
+
+         std::weak_ptr<State> weak_state = this->shared_from_this();
+         std::weak_ptr<Reader> weak_reader = reader;
+         subscriber.add(Subscription([weak_state, weak_reader]() {
+            auto shared_state = weak_state.lock();
+            auto shared_reader = weak_reader.lock();
+            if (shared_state && shared_reader)
+            {
+               shared_state->remove(shared_reader);
+            }
+         }));
+
+         seek(*reader, index);
+         drainLoop(*reader);
+      }
+
+      void onNext(const T& t)
+      {
+         if (m_isDone.load(std::memory_order_relaxed))
+         {
+            return;
+         }
+
+         if (m_tailOffset == REPLAY_CHUNK_SIZE)
+         {
+            m_tail->m_next = std::make_shared<Chunk>();
+            m_tail = m_tail->m_next;
+            m_tailOffset = 0;
+         }
+
+         auto& slot = m_tail->m_slots[m_tailOffset++];
+         slot.m_value.set(t);
+         if (m_scheduler)
+         {
+            slot.m_time = m_scheduler->now();
+         }
+         auto size = m_size.load(std::memory_order_relaxed) + 1;
+         m_size.store(size, std::memory_order_release);
+
+         trim(size);
+         drainAll();
+      }
+
+      void onTerminate(std::exception_ptr e)
+      {
+         if (m_isDone.load(std::memory_order_relaxed))
+         {
+            return;
+         }
+         m_error = std::move(e);
+         m_isDone.store(true, std::memory_order_release);
+         drainAll();
+      }
+
+   private:
+      //! Moves a new reader from index, the first element of its chunk, to
+      //! the first element it is to replay.
+      void seek(Reader& reader, std::uint64_t index)
+      {
+         auto size = m_size.load(std::memory_order_acquire);
+         auto start = index;
+         if (m_maxSize != 0 && size - start > m_maxSize)
+         {
+            start = size - m_maxSize;
+         }
+
+         // Elements are published chunk after chunk, so every chunk before
+         // the one holding element start - 1 is linked to the next.
+         while (start - index > REPLAY_CHUNK_SIZE)
+         {
+            reader.m_chunk = reader.m_chunk->m_next;
+            index += REPLAY_CHUNK_SIZE;
+         }
+         reader.m_offset = start - index;
+         reader.m_index = start;
+
+         if (m_scheduler)
+         {
+            auto oldest = m_scheduler->now() - m_window;
+            while (reader.m_index < size)
+            {
+               stepToNextChunk(reader);
+               if (reader.m_chunk->m_slots[reader.m_offset].m_time >= oldest)
+               {
+                  break;
+               }
+               ++reader.m_offset;
+               ++reader.m_index;
+            }
+         }
+      }
+
+      static void stepToNextChunk(Reader& reader)
+      {
+         if (reader.m_offset == REPLAY_CHUNK_SIZE)
+         {
+            reader.m_chunk = reader.m_chunk->m_next;
+            reader.m_offset = 0;
+         }
+      }
+
+      //! Drops chunks from the front that hold nothing to replay any more.
+      //! Only the producer moves the head, readers only take it under the
+      //! lock.
+      void trim(std::uint64_t size)
+      {
+         if (m_maxSize != 0)
+         {
+            while (m_head != m_tail
+                   && size - (m_headIndex + REPLAY_CHUNK_SIZE) >= m_maxSize)
+            {
+               advanceHead();
+            }
+         }
+         else if (m_scheduler)
+         {
+            auto oldest = m_scheduler->now() - m_window;
+            while (m_head != m_tail
+                   && m_head->m_slots[REPLAY_CHUNK_SIZE - 1].m_time < oldest)
+            {
+               advanceHead();
+            }
+         }
+      }
+
+      void advanceHead()
+      {
+         std::shared_ptr<Chunk> old;
+         std::lock_guard<std::mutex> lock(m_mutex);
+         old = m_head;
+         m_head = m_head->m_next;
+         m_headIndex += REPLAY_CHUNK_SIZE;
+      }
+
+      void remove(const std::shared_ptr<Reader>& reader)
+      {
+         reader->m_isCancelled.store(true, std::memory_order_release);
+
+         std::lock_guard<std::mutex> lock(m_mutex);
+         auto readers = std::make_shared<Readers>();
+         readers->reserve(m_readers->size());
+         for (auto& r : *m_readers)
+         {
+            if (r != reader)
+            {
+               readers->push_back(r);
+            }
+         }
+         m_readers = std::move(readers);
+      }
+
+      void drainAll()
+      {
+         std::shared_ptr<const Readers> readers;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            readers = m_readers;
+         }
+         for (auto& reader : *readers)
+         {
+            if (reader->m_wip.fetch_add(1, std::memory_order_acq_rel) == 0)
+            {
+               drainLoop(*reader);
+            }
+         }
+      }
+
+      //! Called by the thread that raised the reader's wip from zero.
+      void drainLoop(Reader& reader)
+      {
+         int missed = 1;
+         for (;;)
+         {
+            // Read before the count, so that done means nothing follows.
+            bool isDone = m_isDone.load(std::memory_order_acquire);
+            auto size = m_size.load(std::memory_order_acquire);
+
+            while (reader.m_index < size)
+            {
+               if (reader.m_isCancelled.load(std::memory_order_acquire))
+               {
+                  return;
+               }
+               stepToNextChunk(reader);
+               reader.m_observer.onNext(
+                     reader.m_chunk->m_slots[reader.m_offset].m_value.get());
+               ++reader.m_offset;
+               ++reader.m_index;
+            }
+
+            if (isDone && !reader.m_isCancelled.exchange(true, std::memory_order_acq_rel))
+            {
+               reader.m_chunk.reset();
+               if (m_error)
+               {
+                  reader.m_observer.onError(m_error);
+               }
+               else
+               {
+                  reader.m_observer.onCompleted();
+               }
+               return;
+            }
+
+            missed = reader.m_wip.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+            if (missed == 0)
+            {
+               break;
+            }
+         }
+      }
+
+      const std::size_t m_maxSize;
+      const Scheduler::Duration m_window;
+      const std::shared_ptr<Scheduler> m_scheduler;
+
+      std::mutex m_mutex;
+      std::shared_ptr<const Readers> m_readers;
+      std::shared_ptr<Chunk> m_head;
+      std::uint64_t m_headIndex;
+
+      //! Only touched by the producer.
+      std::shared_ptr<Chunk> m_tail;
+      std::size_t m_tailOffset;
+
+      std::atomic<std::uint64_t> m_size;
+      std::atomic<bool> m_isDone;
+      std::exception_ptr m_error;
+   };
+
+   ReplaySubject(std::shared_ptr<State> state)
+         : Observable<T>(state),
+           m_state(std::move(state))
+   {
+   }
+
+   std::shared_ptr<State> m_state;
+};
+
+//! Returns an Observable that subscribes to source through subject with
+//! its first subscriber, and from then on only replays subject.
+template<class T>
+Observable<T> replayThrough(Observable<T> source, ReplaySubject<T> subject)
+{
+   auto isConnected = std::make_shared<std::atomic<bool>>(false);
+   return Observable<T>::create([source, subject, isConnected](Subscriber<T> subscriber) {
+      subject.unsafeSubscribe(subscriber);
+      if (!isConnected->exchange(true, std::memory_order_acq_rel))
+      {
+         source.subscribe(Observer<T>(
+            // onNext
+            [subject](const T& t) {
+               subject.onNext(t);
+            },
+            // onCompleted
+            [subject]() {
+               subject.onCompleted();
+            },
+            // onError
+            [subject](std::exception_ptr e) {
+               subject.onError(e);
+            }));
+      }
+   });
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+
+#include "rx/Scheduler.hpp"
+#include "rx/internal/Optional.hpp"
+
+//! Decides whether, and after how long, retryWhen() resubscribes to a
+//! source that failed. attempt counts the failures of the subscription so
+//! far, starting at 1.
+class RetryPolicy
+{
+public:
+   typedef Scheduler::Duration Duration;
+   typedef std::function<Optional<Duration>(std::exception_ptr error,
+                                            std::size_t attempt)> Decide;
+
+   //! decide returns the delay before the next subscription, or no value
+   //! to give up and pass error on.
+   explicit RetryPolicy(Decide decide);
+
+   //! Resubscribes right away, at most maxRetries times.
+   static RetryPolicy immediate(std::size_t maxRetries);
+
+   //! Waits initialDelay before the first retry and multiplier times as
+   //! long before every further one, up to maxDelay, and gives up after
+   //! maxRetries retries. jitter is the fraction of every delay that is
+   //! randomized, between 0 and 1, so that sources that failed together
+   //! do not all come back at the same instant.
+   static RetryPolicy exponentialBackoff(std::size_t maxRetries,
+                                         Duration initialDelay,
+                                         Duration maxDelay,
+                                         double multiplier = 2.0,
+                                         double jitter = 0.5);
+
+   Optional<Duration> next(std::exception_ptr error, std::size_t attempt) const;
+
+private:
+   Decide m_decide;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "rx/Subscriber.hpp"
+#include "rx/internal/ObjectPool.hpp"
 #include <memory>
 
 class OnErrorNotImplementedException : public std::runtime_error
@@ -28,7 +29,7 @@ struct SafeObserverState
 };
 
 template<class T>
-void onError(const std::shared_ptr<SafeObserverState<T>>& state, std::exception_ptr e)
+void onError(SafeObserverState<T>* state, std::exception_ptr e)
 {
    if (!state->m_isFinished)
    {
@@ -51,11 +52,15 @@ void onError(const std::shared_ptr<SafeObserverState<T>>& state, std::exception_
 template<class T>
 Observer<T> createSafeObserver(Subscriber<T> actual)
 {
-   auto state = std::make_shared<SafeObserverState<T>>(actual.getObserver(), actual.getSubscription());
+   auto state = std::allocate_shared<SafeObserverState<T>>(
+         PoolAllocator<SafeObserverState<T>>(), actual.getObserver(), actual.getSubscription());
 
+   // The callbacks hold on to state through the observer, a raw pointer
+   // keeps them from allocating.
    return Observer<T>(
+      state,
       //onNext
-      [state](const T& t) {
+      [state = state.get()](const T& t) {
          try
          {
             if (!state->m_isFinished)
@@ -69,7 +74,7 @@ Observer<T> createSafeObserver(Subscriber<T> actual)
          }
       },
       //onCompleted
-      [state]() {
+      [state = state.get()]() {
          if (!state->m_isFinished)
          {
             state->m_isFinished = true; // TODO: Use CAS to make threadsafe
@@ -97,7 +102,7 @@ Observer<T> createSafeObserver(Subscriber<T> actual)
          }
       },
       //onError
-      [state](std::exception_ptr e) {
+      [state = state.get()](std::exception_ptr e) {
          onError(state, std::move(e));
       });
 }
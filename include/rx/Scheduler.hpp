@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "rx/Subscription.hpp"
+
+//! A reusable one-shot timer slot owned by a Scheduler.
+//!
+//! Arming an already armed timer moves its deadline, so an operator that
+//! needs a timer per subscription can keep a single Timer for the whole
+//! lifetime of the subscription instead of scheduling a new action per
+//! element.
+class Timer
+{
+public:
+   typedef std::chrono::steady_clock Clock;
+   typedef Clock::time_point TimePoint;
+
+   class State
+   {
+   public:
+      virtual ~State() = default;
+
+      virtual void arm(TimePoint due) = 0;
+
+      virtual void cancel() = 0;
+
+      virtual bool isArmed() const = 0;
+
+      //! Cancels the timer for good and releases its action.
+      virtual void dispose() = 0;
+   };
+
+   Timer();
+
+   explicit Timer(std::shared_ptr<State> state);
+
+   void arm(TimePoint due) const;
+
+   void cancel() const;
+
+   bool isArmed() const;
+
+   void dispose() const;
+
+   //! Returns a Subscription that disposes the timer when unsubscribed.
+   Subscription getSubscription() const;
+
+private:
+   std::shared_ptr<State> m_state;
+};
+
+
+class Scheduler
+{
+public:
+   typedef Timer::Clock Clock;
+   typedef Timer::TimePoint TimePoint;
+   typedef Clock::duration Duration;
+   typedef std::function<void()> Action;
+
+   TimePoint now() const;
+
+   //! Creates a disarmed timer that runs action every time it expires.
+   Timer createTimer(Action action) const;
+
+   Subscription schedule(Action action) const;
+
+   Subscription schedule(TimePoint due, Action action) const;
+
+   //! Runs action at firstDue and then every period. Deadlines are
+   //! computed from the previous deadline, not from when the action ran,
+   //! so a periodic action does not drift.
+   Subscription schedulePeriodically(TimePoint firstDue, Duration period,
+                                     Action action) const;
+
+protected:
+   class State
+   {
+   public:
+      virtual ~State() = default;
+
+      virtual TimePoint now() const = 0;
+
+      virtual Timer createTimer(Action action) = 0;
+
+      virtual Subscription schedule(Action action);
+   };
+
+   Scheduler(std::shared_ptr<State> state);
+
+   std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "rx/Observable.hpp"
+#include "rx/Observer.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+#include "rx/internal/SharedMemory.hpp"
+
+//! Ring buffer of T laid out in shared memory, with one writer and any
+//! number of readers in any number of processes.
+//!
+//! The writer never waits for readers. Every slot carries a stamp that the
+//! writer makes odd while it overwrites the slot and sets to an even value
+//! derived from the sequence number afterwards, so a reader can tell that
+//! the element it copied was overwritten meanwhile. Such a reader, or one
+//! that fell more than a ring behind, skips ahead to the oldest element
+//! still in the ring.
+template<class T>
+class SharedMemoryRing
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "SharedMemoryRing requires a trivially copyable T");
+
+public:
+   enum Status : std::uint32_t
+   {
+      ACTIVE,
+      COMPLETED,
+      FAILED
+   };
+
+   static std::shared_ptr<SharedMemoryRing> create(const std::string& name,
+                                                   std::size_t capacity)
+   {
+      std::size_t roundedCapacity = 1;
+      while (roundedCapacity < capacity)
+      {
+         roundedCapacity <<= 1;
+      }
+
+      auto memory = SharedMemory::create(
+            name, sizeof(Header) + roundedCapacity * sizeof(Slot));
+      auto header = static_cast<Header*>(memory->data());
+      header->m_capacity = std::uint32_t(roundedCapacity);
+      header->m_elementSize = std::uint32_t(sizeof(T));
+      header->m_magic.store(MAGIC, std::memory_order_release);
+      return std::shared_ptr<SharedMemoryRing>(new SharedMemoryRing(std::move(memory)));
+   }
+
+   //! Throws std::system_error if there is no ring called name, and
+   //! std::runtime_error if it is not a ring of T.
+   static std::shared_ptr<SharedMemoryRing> open(const std::string& name)
+   {
+      auto memory = SharedMemory::open(name);
+      auto header = static_cast<Header*>(memory->data());
+      if (memory->size() < sizeof(Header)
+          || header->m_magic.load(std::memory_order_acquire) != MAGIC
+          || header->m_elementSize != sizeof(T)
+          || memory->size() < sizeof(Header) + header->m_capacity * sizeof(Slot))
+      {
+         throw std::runtime_error("not a shared memory ring of this type: " + name);
+      }
+      return std::shared_ptr<SharedMemoryRing>(new SharedMemoryRing(std::move(memory)));
+   }
+
+   //! Must only be called by the single writer.
+   void publish(const T& t)
+   {
+      auto sequence = m_header->m_writeSequence.load(std::memory_order_relaxed);
+      auto& slot = m_slots[sequence & m_mask];
+
+      slot.m_stamp.store(2 * sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      std::memcpy(&slot.m_value, &t, sizeof(T));
+      slot.m_stamp.store(2 * sequence + 2, std::memory_order_release);
+
+      m_header->m_writeSequence.store(sequence + 1, std::memory_order_seq_cst);
+      wakeReaders(false);
+   }
+
+   void terminate(Status status)
+   {
+      m_header->m_status.store(status, std::memory_order_seq_cst);
+      wakeReaders(true);
+   }
+
+   //! The sequence number of the element that will be published next.
+   std::uint64_t getWriteSequence() const
+   {
+      return m_header->m_writeSequence.load(std::memory_order_acquire);
+   }
+
+   //! Emits every element from sequence number next on to o, on the
+   //! calling thread, until the writer terminates or cancellation is
+   //! raised.
+   void read(const Observer<T>& o, const CancellationFlag& cancellation,
+             std::uint64_t next)
+   {
+      const std::uint64_t capacity = m_header->m_capacity;
+
+      while (!cancellation.isCancelled())
+      {
+         auto published = m_header->m_writeSequence.load(std::memory_order_acquire);
+         if (next < published)
+         {
+            if (published - next > capacity)
+            {
+               next = published - capacity;
+            }
+
+            T t;
+            if (tryRead(next, t))
+            {
+               o.onNext(t);
+               ++next;
+            }
+            else
+            {
+               // Overwritten while copying, the writer has lapped us.
+               next = m_header->m_writeSequence.load(std::memory_order_acquire)
+                      - capacity + 1;
+            }
+            continue;
+         }
+
+         auto status = m_header->m_status.load(std::memory_order_acquire);
+         if (status == COMPLETED)
+         {
+            o.onCompleted();
+            return;
+         }
+         if (status == FAILED)
+         {
+            o.onError(std::make_exception_ptr(
+                  std::runtime_error("shared memory publisher failed")));
+            return;
+         }
+
+         waitFor(next);
+      }
+   }
+
+   //! Wakes readers up so they notice that they were cancelled.
+   void interruptReaders()
+   {
+      wakeReaders(true);
+   }
+
+private:
+   static const std::uint64_t MAGIC = 0x5278526970676e31;
+   static const int SPIN_COUNT = 64;
+
+   struct Header
+   {
+      std::atomic<std::uint64_t> m_magic;
+      std::uint32_t m_capacity;
+      std::uint32_t m_elementSize;
+      alignas(64) std::atomic<std::uint64_t> m_writeSequence;
+      std::atomic<std::uint32_t> m_status;
+      std::atomic<std::uint32_t> m_wakeups;
+      std::atomic<std::uint32_t> m_waiters;
+   };
+
+   struct Slot
+   {
+      std::atomic<std::uint64_t> m_stamp;
+      T m_value;
+   };
+
+   explicit SharedMemoryRing(std::shared_ptr<SharedMemory> memory)
+         : m_memory(std::move(memory)),
+           m_header(static_cast<Header*>(m_memory->data())),
+           m_slots(reinterpret_cast<Slot*>(m_header + 1)),
+           m_mask(m_header->m_capacity - 1)
+   {
+   }
+
+   bool tryRead(std::uint64_t sequence, T& t) const
+   {
+      auto& slot = m_slots[sequence & m_mask];
+      auto stamp = 2 * sequence + 2;
+
+      if (slot.m_stamp.load(std::memory_order_acquire) != stamp)
+      {
+         return false;
+      }
+      std::memcpy(&t, &slot.m_value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return slot.m_stamp.load(std::memory_order_relaxed) == stamp;
+   }
+
+   void wakeReaders(bool isForced)
+   {
+      // Readers that are not blocked notice new elements by themselves, so
+      // the writer stays off the shared counters while they keep up.
+      if (isForced || m_header->m_waiters.load(std::memory_order_seq_cst) > 0)
+      {
+         m_header->m_wakeups.fetch_add(1, std::memory_order_seq_cst);
+         SharedMemory::futexWakeAll(m_header->m_wakeups);
+      }
+   }
+
+   void waitFor(std::uint64_t next)
+   {
+      for (int i = 0; i < SPIN_COUNT; ++i)
+      {
+         if (m_header->m_writeSequence.load(std::memory_order_acquire) != next)
+         {
+            return;
+         }
+         std::this_thread::yield();
+      }
+
+      // Registering as a waiter before looking at the sequence again makes
+      // sure the writer either sees the waiter or we see its element.
+      m_header->m_waiters.fetch_add(1, std::memory_order_seq_cst);
+      auto wakeups = m_header->m_wakeups.load(std::memory_order_seq_cst);
+      if (m_header->m_writeSequence.load(std::memory_order_seq_cst) == next
+          && m_header->m_status.load(std::memory_order_seq_cst) == ACTIVE)
+      {
+         SharedMemory::futexWait(m_header->m_wakeups, wakeups,
+                                 std::chrono::milliseconds(100));
+      }
+      m_header->m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+   }
+
+   std::shared_ptr<SharedMemory> m_memory;
+   Header* m_header;
+   Slot* m_slots;
+   std::uint64_t m_mask;
+};
+
+
+//! Subject that publishes into a shared memory ring buffer so that
+//! processes on the same host can subscribe to one feed.
+//!
+//! The process that calls create() owns the ring and is its single
+//! writer; other processes call open() for an Observable over it. Every
+//! subscription, in any process, runs a thread that follows the ring from
+//! the element published next when subscribe() was called and blocks on a
+//! futex while it has caught up; unsubscribing joins that thread. A
+//! subscriber that falls more than the capacity behind loses the oldest
+//! elements instead of slowing the writer down.
+template<class T>
+class SharedMemorySubject : public Observable<T>, public Observer<T>
+{
+public:
+   static SharedMemorySubject create(const std::string& name, std::size_t capacity)
+   {
+      auto ring = SharedMemoryRing<T>::create(name, capacity);
+      return SharedMemorySubject(ring);
+   }
+
+   static Observable<T> open(const std::string& name)
+   {
+      auto ring = SharedMemoryRing<T>::open(name);
+      return Observable<T>::create(createOnSubscribeFunc(ring));
+   }
+
+private:
+   explicit SharedMemorySubject(std::shared_ptr<SharedMemoryRing<T>> ring)
+         : Observable<T>(createOnSubscribeFunc(ring)),
+           Observer<T>(
+               // onNext
+               [ring](const T& t) {
+                  ring->publish(t);
+               },
+               // onCompleted
+               [ring]() {
+                  ring->terminate(SharedMemoryRing<T>::COMPLETED);
+               },
+               // onError
+               [ring](std::exception_ptr) {
+                  ring->terminate(SharedMemoryRing<T>::FAILED);
+               })
+   {
+   }
+
+   //! The thread of one subscription. Unsubscribing joins it, unless it
+   //! unsubscribes itself; a subscription that is dropped without being
+   //! unsubscribed lets it run until the writer terminates.
+   class Reader
+   {
+   public:
+      explicit Reader(std::thread thread)
+            : m_thread(std::move(thread))
+      {
+      }
+
+      ~Reader()
+      {
+         if (m_thread.joinable())
+         {
+            m_thread.detach();
+         }
+      }
+
+      void join()
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (!m_thread.joinable())
+         {
+            return;
+         }
+         if (m_thread.get_id() == std::this_thread::get_id())
+         {
+            m_thread.detach();
+         }
+         else
+         {
+            m_thread.join();
+         }
+      }
+
+   private:
+      std::mutex m_mutex;
+      std::thread m_thread;
+   };
+
+   static OnSubscribeFunc<T> createOnSubscribeFunc(std::shared_ptr<SharedMemoryRing<T>> ring)
+   {
+      return [ring](Subscriber<T> s) {
+         // Taken before the thread starts, so that nothing published once
+         // subscribe() has returned is missed.
+         auto next = ring->getWriteSequence();
+         auto cancellation = CancellationFlag::create(s);
+
+         // The reader thread keeps the ring mapped until it returns.
+         auto o = s.getObserver();
+         auto reader = std::make_shared<Reader>(std::thread(
+               [ring, o, cancellation, next]() {
+            ring->read(o, cancellation, next);
+         }));
+
+         s.add(Subscription([ring, reader]() {
+            ring->interruptReaders();
+            reader->join();
+         }));
+      };
+   }
+};
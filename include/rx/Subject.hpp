@@ -3,9 +3,12 @@
 #include <memory>
 #include <list>
 #include <algorithm>
+#include <utility>
 
 #include "rx/Observer.hpp"
 #include "rx/Subscriber.hpp"
+#include "rx/internal/ObjectPool.hpp"
+#include "rx/schedulers/Trampoline.hpp"
 
 template<class T>
 class SubjectSubscriptionManager
@@ -22,7 +25,7 @@ public:
       auto shared_state = m_state;
       return [shared_state](Subscriber<T> subscriber)
       {
-         shared_state->m_subscribers.push_back(subscriber);
+         shared_state->m_subscribers.push_back(Entry{ subscriber, false });
 
          subscriber.add(Subscription(
                [shared_state, subscriber]()
@@ -37,10 +40,7 @@ public:
       auto shared_state = m_state;
       return [shared_state](const T& t)
       {
-         for(auto& s: shared_state->m_subscribers)
-         {
-            s.getObserver().onNext(t);
-         }
+         shared_state->onNext(t);
       };
    }
 
@@ -49,11 +49,7 @@ public:
       auto shared_state = m_state;
       return [shared_state]()
       {
-         for(auto& s: shared_state->m_subscribers)
-         {
-            s.getObserver().onCompleted();
-         }
-         shared_state->removeAllSubscribers();
+         shared_state->onCompleted();
       };
    }
 
@@ -62,34 +58,169 @@ public:
       auto shared_state = m_state;
       return [shared_state](std::exception_ptr e)
       {
-         for(auto& s: shared_state->m_subscribers)
-         {
-            s.getObserver().onError(e);
-         }
-         shared_state->removeAllSubscribers();
+         shared_state->onError(std::move(e));
       };
    }
 private:
 
+   struct Entry
+   {
+      Subscriber<T> m_subscriber;
+
+      //! Unsubscribed during an emission, erased once it has returned.
+      bool m_isRemoved;
+   };
+
    struct State
    {
+      State()
+            : m_hasRemoved(false)
+      {
+      }
+
+      // An emission started from within an observer of this Subject is
+      // delivered once the emission in progress has returned. Emissions
+      // into other Subjects run right away.
+      void onNext(const T& t)
+      {
+         if (m_trampoline.isActive())
+         {
+            m_trampoline.defer([this, t]() {
+               emitNext(t);
+            });
+            return;
+         }
+         run([this, &t]() {
+            emitNext(t);
+         });
+      }
+
+      void onCompleted()
+      {
+         if (m_trampoline.isActive())
+         {
+            m_trampoline.defer([this]() {
+               emitCompleted();
+            });
+            return;
+         }
+         run([this]() {
+            emitCompleted();
+         });
+      }
+
+      void onError(std::exception_ptr e)
+      {
+         if (m_trampoline.isActive())
+         {
+            m_trampoline.defer([this, e]() {
+               emitError(e);
+            });
+            return;
+         }
+         run([this, &e]() {
+            emitError(e);
+         });
+      }
+
       void removeSubscriber(const Subscriber<T>& subscriber)
       {
-         auto it = std::find(std::begin(m_subscribers), std::end(m_subscribers),
-               subscriber);
+         for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it)
+         {
+            if (!it->m_isRemoved && it->m_subscriber == subscriber)
+            {
+               // Observers may unsubscribe any subscriber while the list
+               // is iterated, so the entry stays until it has finished.
+               if (m_trampoline.isActive())
+               {
+                  it->m_isRemoved = true;
+                  m_hasRemoved = true;
+               }
+               else
+               {
+                  m_subscribers.erase(it);
+               }
+               return;
+            }
+         }
+      }
+
+      std::list<Entry, PoolAllocator<Entry>> m_subscribers;
 
-         if (it != m_subscribers.end())
+   private:
+      template<class F>
+      void run(F&& f)
+      {
+         try
+         {
+            m_trampoline.run(std::forward<F>(f));
+         }
+         catch (...)
          {
-            m_subscribers.erase(it);
+            eraseRemoved();
+            throw;
          }
+         eraseRemoved();
       }
 
+      void emitNext(const T& t)
+      {
+         for (auto& entry : m_subscribers)
+         {
+            if (!entry.m_isRemoved)
+            {
+               entry.m_subscriber.getObserver().onNext(t);
+            }
+         }
+      }
+
+      void emitCompleted()
+      {
+         for (auto& entry : m_subscribers)
+         {
+            if (!entry.m_isRemoved)
+            {
+               entry.m_subscriber.getObserver().onCompleted();
+            }
+         }
+         removeAllSubscribers();
+      }
+
+      void emitError(std::exception_ptr e)
+      {
+         for (auto& entry : m_subscribers)
+         {
+            if (!entry.m_isRemoved)
+            {
+               entry.m_subscriber.getObserver().onError(e);
+            }
+         }
+         removeAllSubscribers();
+      }
+
+      //! Runs within the emission, the entries are erased once it returns.
       void removeAllSubscribers()
       {
-         m_subscribers.clear();
+         for (auto& entry : m_subscribers)
+         {
+            entry.m_isRemoved = true;
+         }
+         m_hasRemoved = true;
+      }
+
+      void eraseRemoved()
+      {
+         if (m_hasRemoved)
+         {
+            m_hasRemoved = false;
+            m_subscribers.remove_if([](const Entry& entry) {
+               return entry.m_isRemoved;
+            });
+         }
       }
 
-      std::list<Subscriber<T>> m_subscribers;
+      Trampoline m_trampoline;
+      bool m_hasRemoved;
    };
 
    std::shared_ptr<State> m_state;
@@ -2,23 +2,25 @@
 
 #include "rx/Observer.hpp"
 #include "rx/Subscription.hpp"
+#include "rx/internal/ObjectPool.hpp"
 
 template<class T>
 class Subscriber
 {
 public:
    Subscriber(OnNext<T> onNext)
-      : m_state(std::make_shared<State>(std::move(onNext)))
+      : m_state(std::allocate_shared<State>(PoolAllocator<State>(), std::move(onNext)))
    {
    }
 
    Subscriber(Observer<T> destination)
-      : m_state(std::make_shared<State>(std::move(destination)))
+      : m_state(std::allocate_shared<State>(PoolAllocator<State>(), std::move(destination)))
    {
    }
 
    Subscriber(Observer<T> destination, Subscription subscription)
-      : m_state(std::make_shared<State>(std::move(destination), std::move(subscription)))
+      : m_state(std::allocate_shared<State>(PoolAllocator<State>(), std::move(destination),
+                                            std::move(subscription)))
    {
    }
 
@@ -4,6 +4,10 @@
 #include <memory>
 #include <algorithm>
 #include <list>
+#include <type_traits>
+#include <utility>
+
+#include "rx/internal/ObjectPool.hpp"
 
 class Subscription
 {
@@ -13,6 +17,16 @@ public:
 
    Subscription(UnsubscribeFunc unsubscribe);
 
+   //! Keeps unsubscribe in a pooled block rather than in a std::function,
+   //! which allocates for any capture that is not trivially copyable.
+   template<class Unsubscribe,
+            class = typename std::enable_if<std::is_invocable<Unsubscribe&>::value>::type>
+   Subscription(Unsubscribe unsubscribe)
+      : m_state(std::allocate_shared<CallbackState<Unsubscribe>>(
+            PoolAllocator<CallbackState<Unsubscribe>>(), std::move(unsubscribe)))
+   {
+   }
+
    virtual void unsubscribe() const;
 
 protected:
@@ -32,8 +46,28 @@ protected:
       UnsubscribeFunc m_unsubscribe;
    };
 
+   template<class Unsubscribe>
+   class CallbackState : public State
+   {
+   public:
+      explicit CallbackState(Unsubscribe unsubscribe)
+         : m_unsubscribe(std::move(unsubscribe))
+      {
+      }
+
+      void unsubscribe() override
+      {
+         m_unsubscribe();
+      }
+
+   private:
+      Unsubscribe m_unsubscribe;
+   };
+
    Subscription(std::unique_ptr<State> state);
 
+   Subscription(std::shared_ptr<State> state);
+
    friend bool operator==(const Subscription& lhs, const Subscription& rhs);
 
 protected:
@@ -65,7 +99,7 @@ private:
       void remove(Subscription s);
 
    private:
-      std::list<Subscription> m_subscriptions;
+      std::list<Subscription, PoolAllocator<Subscription>> m_subscriptions;
    };
 
    friend bool operator==(SubscriptionList& lhs, SubscriptionList& rhs);
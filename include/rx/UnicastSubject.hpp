@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "rx/Observable.hpp"
+#include "rx/Subscriber.hpp"
+
+//! A Subject that accepts a single subscriber.
+//!
+//! Everything lives in one State allocation, which is also the state of
+//! the Observable, so creating one is a single make_shared. Elements that
+//! arrive before the subscriber are buffered; once the subscriber has been
+//! attached elements are handed straight to it after an atomic load,
+//! without taking a lock. A second subscriber receives onError.
+template<class T>
+class UnicastSubject : public Observable<T>
+{
+public:
+   static UnicastSubject<T> create()
+   {
+      return UnicastSubject(std::make_shared<State>(nullptr));
+   }
+
+   //! onCancel is called once, on the thread that unsubscribes, when the
+   //! subscriber unsubscribes.
+   static UnicastSubject<T> create(std::function<void()> onCancel)
+   {
+      return UnicastSubject(std::make_shared<State>(std::move(onCancel)));
+   }
+
+   void onNext(const T& t) const
+   {
+      m_state->onNext(t);
+   }
+
+   //! True once the subscriber has unsubscribed.
+   bool isCancelled() const
+   {
+      return m_state->isCancelled();
+   }
+
+   void onCompleted() const
+   {
+      m_state->onTerminate(nullptr);
+   }
+
+   void onError(std::exception_ptr e) const
+   {
+      m_state->onTerminate(std::move(e));
+   }
+
+private:
+   enum Mode
+   {
+      WAITING,
+      SUBSCRIBED,
+      CANCELLED
+   };
+
+   class State : public Observable<T>::State,
+                 public std::enable_shared_from_this<State>
+   {
+   public:
+      explicit State(std::function<void()> onCancel)
+            : m_mode(WAITING),
+              m_onCancel(std::move(onCancel)),
+              m_hasSubscriber(false),
+              m_isDone(false)
+      {
+      }
+
+      void onSubscribe(Subscriber<T> subscriber) override
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+
+         if (m_hasSubscriber)
+         {
+            lock.unlock();
+            subscriber.getObserver().onError(std::make_exception_ptr(
+                  std::logic_error("UnicastSubject allows only one subscriber")));
+            return;
+         }
+
+         m_hasSubscriber = true;
+         m_observer = subscriber.getObserver();
+
+         // The subscriber may unsubscribe from any thread, the state must
+         // outlive its reference to it.
+         std::weak_ptr<State> weak_state = this->shared_from_this();
+         subscriber.add(Subscription([weak_state]() {
+            auto shared_state = weak_state.lock();
+            if (!shared_state
+                || shared_state->m_mode.exchange(CANCELLED,
+                                                 std::memory_order_acq_rel) == CANCELLED)
+            {
+               return;
+            }
+            if (shared_state->m_onCancel)
+            {
+               shared_state->m_onCancel();
+            }
+         }));
+
+         // Replaying under the lock keeps the producer, which sees WAITING
+         // until the store below, from overtaking the buffered elements.
+         for (auto& t : m_buffer)
+         {
+            m_observer.onNext(t);
+         }
+         m_buffer.clear();
+         m_buffer.shrink_to_fit();
+
+         if (m_isDone)
+         {
+            deliverTerminal();
+         }
+         else
+         {
+            int expected = WAITING;
+            m_mode.compare_exchange_strong(expected, SUBSCRIBED,
+                                           std::memory_order_release);
+         }
+      }
+
+      void onNext(const T& t)
+      {
+         auto mode = m_mode.load(std::memory_order_acquire);
+         if (mode == SUBSCRIBED)
+         {
+            m_observer.onNext(t);
+            return;
+         }
+         if (mode == CANCELLED)
+         {
+            return;
+         }
+
+         std::lock_guard<std::mutex> lock(m_mutex);
+         mode = m_mode.load(std::memory_order_acquire);
+         if (mode == SUBSCRIBED)
+         {
+            m_observer.onNext(t);
+         }
+         else if (mode == WAITING && !m_isDone)
+         {
+            m_buffer.push_back(t);
+         }
+      }
+
+      bool isCancelled() const
+      {
+         return m_mode.load(std::memory_order_acquire) == CANCELLED;
+      }
+
+      void onTerminate(std::exception_ptr e)
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_isDone)
+         {
+            return;
+         }
+         m_isDone = true;
+         m_error = std::move(e);
+
+         if (m_mode.load(std::memory_order_acquire) == SUBSCRIBED)
+         {
+            deliverTerminal();
+         }
+      }
+
+   private:
+      void deliverTerminal()
+      {
+         if (m_error)
+         {
+            m_observer.onError(m_error);
+         }
+         else
+         {
+            m_observer.onCompleted();
+         }
+      }
+
+      std::atomic<int> m_mode;
+      std::function<void()> m_onCancel;
+      std::mutex m_mutex;
+      Observer<T> m_observer;
+      std::vector<T> m_buffer;
+      std::exception_ptr m_error;
+      bool m_hasSubscriber;
+      bool m_isDone;
+   };
+
+   UnicastSubject(std::shared_ptr<State> state)
+         : Observable<T>(state),
+           m_state(std::move(state))
+   {
+   }
+
+   std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "rx/Subscriber.hpp"
+
+//! Flag that is raised when the subscriber it was created for unsubscribes.
+//!
+//! Subscribers do not expose whether they are unsubscribed, so a source
+//! that emits from a loop registers one of these to find out when to stop.
+class CancellationFlag
+{
+public:
+   template<class T>
+   static CancellationFlag create(Subscriber<T>& subscriber)
+   {
+      auto shared_state = std::make_shared<std::atomic<bool>>(false);
+      subscriber.add(Subscription([shared_state]() {
+         shared_state->store(true, std::memory_order_release);
+      }));
+      return CancellationFlag(std::move(shared_state));
+   }
+
+   CancellationFlag()
+         : m_state(std::make_shared<std::atomic<bool>>(false))
+   {
+   }
+
+   bool isCancelled() const
+   {
+      return m_state->load(std::memory_order_acquire);
+   }
+
+private:
+   explicit CancellationFlag(std::shared_ptr<std::atomic<bool>> state)
+         : m_state(std::move(state))
+   {
+   }
+
+   std::shared_ptr<std::atomic<bool>> m_state;
+};
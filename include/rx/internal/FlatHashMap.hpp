@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "rx/internal/Optional.hpp"
+
+//! Open addressing hash map with linear probing.
+//!
+//! Entries live inline in one contiguous array together with their hash,
+//! so a lookup is one hash computation and a probe over adjacent slots,
+//! and erasing uses backward shifting instead of tombstones. Capacity is a
+//! power of two and the load factor is kept at or below 3/4.
+template<class K, class V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+class FlatHashMap
+{
+public:
+   explicit FlatHashMap(std::size_t initialCapacity = 16)
+         : m_slots(roundUpToPowerOfTwo(initialCapacity)),
+           m_size(0)
+   {
+   }
+
+   std::size_t size() const
+   {
+      return m_size;
+   }
+
+   std::size_t capacity() const
+   {
+      return m_slots.size();
+   }
+
+   bool empty() const
+   {
+      return m_size == 0;
+   }
+
+   //! Bytes taken by the table itself, not counting anything that keys or
+   //! values allocate on their own.
+   std::size_t memoryUsage() const
+   {
+      return m_slots.capacity() * sizeof(Slot);
+   }
+
+   //! True if inserting one more key would grow the table.
+   bool isFull() const
+   {
+      return (m_size + 1) * 4 > m_slots.size() * 3;
+   }
+
+   V* find(const K& key)
+   {
+      auto index = probe(key, hashOf(key));
+      return m_slots[index].m_entry.hasValue()
+             ? &m_slots[index].m_entry.get().second : nullptr;
+   }
+
+   //! Returns the value for key, constructing it with create() if the key
+   //! is not present. Either way the key is hashed and probed once.
+   template<class Create>
+   V& findOrCreate(const K& key, Create create, bool& isCreated)
+   {
+      if (isFull())
+      {
+         rehash(m_slots.size() * 2);
+      }
+
+      auto hash = hashOf(key);
+      auto index = probe(key, hash);
+      auto& slot = m_slots[index];
+
+      isCreated = !slot.m_entry.hasValue();
+      if (isCreated)
+      {
+         slot.m_hash = hash;
+         slot.m_entry.set(Entry(key, create()));
+         ++m_size;
+      }
+      return slot.m_entry.get().second;
+   }
+
+   bool erase(const K& key)
+   {
+      auto index = probe(key, hashOf(key));
+      if (!m_slots[index].m_entry.hasValue())
+      {
+         return false;
+      }
+
+      // Shift following entries of the probe chain back into the hole.
+      auto mask = m_slots.size() - 1;
+      auto hole = index;
+      for (auto next = (hole + 1) & mask;
+           m_slots[next].m_entry.hasValue();
+           next = (next + 1) & mask)
+      {
+         auto ideal = m_slots[next].m_hash & mask;
+         if (((next - ideal) & mask) >= ((next - hole) & mask))
+         {
+            m_slots[hole] = std::move(m_slots[next]);
+            hole = next;
+         }
+      }
+      m_slots[hole].m_entry.reset();
+      --m_size;
+      return true;
+   }
+
+   //! Removes every entry for which pred(key, value) is true by rebuilding
+   //! the table, shrinking it if the remaining entries allow.
+   template<class Pred>
+   std::size_t removeIf(Pred pred)
+   {
+      auto before = m_size;
+      auto capacity = m_slots.size();
+      rehash(capacity, pred);
+      while (capacity > MIN_CAPACITY && m_size * 4 < capacity)
+      {
+         capacity /= 2;
+      }
+      if (capacity != m_slots.size())
+      {
+         rehash(capacity);
+      }
+      return before - m_size;
+   }
+
+   template<class F>
+   void forEach(F f)
+   {
+      for (auto& slot : m_slots)
+      {
+         if (slot.m_entry.hasValue())
+         {
+            f(slot.m_entry.get().first, slot.m_entry.get().second);
+         }
+      }
+   }
+
+   void clear()
+   {
+      for (auto& slot : m_slots)
+      {
+         slot.m_entry.reset();
+      }
+      m_size = 0;
+   }
+
+private:
+   typedef std::pair<K, V> Entry;
+
+   static const std::size_t MIN_CAPACITY = 16;
+
+   struct Slot
+   {
+      Slot()
+            : m_hash(0)
+      {
+      }
+
+      std::size_t m_hash;
+      Optional<Entry> m_entry;
+   };
+
+   static std::size_t roundUpToPowerOfTwo(std::size_t n)
+   {
+      std::size_t capacity = MIN_CAPACITY;
+      while (capacity < n)
+      {
+         capacity *= 2;
+      }
+      return capacity;
+   }
+
+   //! Mixes the user hash so that hashes which only differ in their high
+   //! bits, like std::hash of integers, still spread over the low bits
+   //! used to pick a slot.
+   std::size_t hashOf(const K& key) const
+   {
+      std::uint64_t h = m_hash(key);
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return std::size_t(h);
+   }
+
+   //! Returns the slot holding key, or the empty slot where it belongs.
+   std::size_t probe(const K& key, std::size_t hash) const
+   {
+      auto mask = m_slots.size() - 1;
+      auto index = hash & mask;
+      while (m_slots[index].m_entry.hasValue())
+      {
+         const auto& slot = m_slots[index];
+         if (slot.m_hash == hash && m_equal(slot.m_entry.get().first, key))
+         {
+            break;
+         }
+         index = (index + 1) & mask;
+      }
+      return index;
+   }
+
+   void rehash(std::size_t capacity)
+   {
+      rehash(capacity, [](const K&, const V&) { return false; });
+   }
+
+   template<class Pred>
+   void rehash(std::size_t capacity, Pred remove)
+   {
+      std::vector<Slot> slots(capacity);
+      auto mask = capacity - 1;
+      m_size = 0;
+
+      for (auto& slot : m_slots)
+      {
+         if (!slot.m_entry.hasValue()
+             || remove(slot.m_entry.get().first, slot.m_entry.get().second))
+         {
+            continue;
+         }
+
+         auto index = slot.m_hash & mask;
+         while (slots[index].m_entry.hasValue())
+         {
+            index = (index + 1) & mask;
+         }
+         slots[index] = std::move(slot);
+         ++m_size;
+      }
+
+      m_slots.swap(slots);
+   }
+
+   std::vector<Slot> m_slots;
+   std::size_t m_size;
+   Hash m_hash;
+   KeyEqual m_equal;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+//! A file mapped read-only into memory for as long as the object lives.
+class MappedFile
+{
+public:
+   //! Throws std::system_error if the file cannot be opened or mapped.
+   static std::shared_ptr<const MappedFile> open(const std::string& path);
+
+   ~MappedFile();
+
+   MappedFile(const MappedFile&) = delete;
+   MappedFile& operator=(const MappedFile&) = delete;
+
+   std::string_view data() const;
+
+   //! Tells the kernel the mapping is read front to back, so it reads
+   //! ahead aggressively and drops pages behind the reader early.
+   void adviseSequential() const;
+
+   //! Asks the kernel to start reading [offset, offset + length) in the
+   //! background. The range is clamped to the mapping.
+   void prefetch(std::size_t offset, std::size_t length) const;
+
+private:
+   MappedFile(const char* data, std::size_t size);
+
+   const char* m_data;
+   std::size_t m_size;
+};
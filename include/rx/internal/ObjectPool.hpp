@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+//! Blocks every thread keeps cached per pool before it hands half of them
+//! to the shared freelist.
+const std::size_t POOL_THREAD_CACHE_SIZE = 256;
+
+//! Blocks the shared freelist of a pool keeps; beyond that they are freed.
+const std::size_t POOL_SHARED_CACHE_SIZE = 4096;
+
+//! Operations on all ObjectPools together.
+class ObjectPools
+{
+public:
+   //! Frees the blocks cached in the shared freelists of all pools, for
+   //! instance once a burst of subscriptions is over. Blocks cached by
+   //! threads are freed when the thread exits.
+   static void releaseIdle();
+
+   //! Blocks taken from operator new by all pools so far.
+   static std::size_t getAllocationCount();
+
+   static void registerPool(void (*release)());
+
+   static void countAllocation();
+};
+
+//! Freelist of blocks the size of T with a cache per thread in front of a
+//! shared one.
+//!
+//! Allocating and freeing pop and push the calling thread's cache, without
+//! any synchronization. A thread whose cache runs empty takes a batch from
+//! the shared freelist under its lock, and one whose cache is full hands
+//! half of it over, so a thread that only frees blocks allocated by
+//! another feeds them back. Both caches are bounded, blocks beyond them go
+//! back to operator delete.
+template<class T>
+class ObjectPool
+{
+   static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                 "blocks come from the plain operator new");
+
+public:
+   static void* allocate()
+   {
+      auto& cache = threadCache();
+      if (cache.m_head == nullptr)
+      {
+         refill(cache);
+         if (cache.m_head == nullptr)
+         {
+            ObjectPools::countAllocation();
+            return ::operator new(sizeof(Block));
+         }
+      }
+
+      auto block = cache.m_head;
+      cache.m_head = block->m_next;
+      --cache.m_count;
+      return block;
+   }
+
+   static void deallocate(void* p)
+   {
+      auto block = static_cast<Block*>(p);
+      auto& cache = threadCache();
+
+      // Freed while the thread exits, after its cache was flushed.
+      if (cache.m_isRetired)
+      {
+         block->m_next = nullptr;
+         giveBack(block);
+         return;
+      }
+
+      block->m_next = cache.m_head;
+      cache.m_head = block;
+      if (++cache.m_count > POOL_THREAD_CACHE_SIZE)
+      {
+         spill(cache, POOL_THREAD_CACHE_SIZE / 2);
+      }
+   }
+
+   //! Frees the blocks of the shared freelist.
+   static void release()
+   {
+      auto& pool = sharedPool();
+      Block* chain;
+      {
+         std::lock_guard<std::mutex> lock(pool.m_mutex);
+         chain = pool.m_head;
+         pool.m_head = nullptr;
+         pool.m_count = 0;
+      }
+      free(chain);
+   }
+
+private:
+   union Block
+   {
+      Block* m_next;
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+   };
+
+   //! Trivially destructible, so that blocks freed by destructors that run
+   //! after the thread's Retirer can still find out it has gone.
+   struct ThreadCache
+   {
+      Block* m_head;
+      std::size_t m_count;
+      bool m_isRetired;
+   };
+
+   //! Hands the cache of an exiting thread over.
+   struct Retirer
+   {
+      ~Retirer()
+      {
+         auto& cache = t_cache;
+         spill(cache, cache.m_count);
+         cache.m_isRetired = true;
+      }
+   };
+
+   struct SharedPool
+   {
+      SharedPool()
+            : m_head(nullptr),
+              m_count(0)
+      {
+         ObjectPools::registerPool(&ObjectPool::release);
+      }
+
+      std::mutex m_mutex;
+      Block* m_head;
+      std::size_t m_count;
+   };
+
+   static ThreadCache& threadCache()
+   {
+      thread_local Retirer retirer;
+      (void) retirer;
+      return t_cache;
+   }
+
+   //! Never destroyed, blocks may still be freed during static destruction.
+   static SharedPool& sharedPool()
+   {
+      static SharedPool* pool = new SharedPool();
+      return *pool;
+   }
+
+   static void refill(ThreadCache& cache)
+   {
+      auto& pool = sharedPool();
+      std::lock_guard<std::mutex> lock(pool.m_mutex);
+      while (pool.m_head != nullptr && cache.m_count < POOL_THREAD_CACHE_SIZE / 2)
+      {
+         auto block = pool.m_head;
+         pool.m_head = block->m_next;
+         --pool.m_count;
+         block->m_next = cache.m_head;
+         cache.m_head = block;
+         ++cache.m_count;
+      }
+   }
+
+   //! Moves count blocks from the front of cache to the shared freelist.
+   static void spill(ThreadCache& cache, std::size_t count)
+   {
+      if (count == 0)
+      {
+         return;
+      }
+
+      auto chain = cache.m_head;
+      auto last = chain;
+      for (std::size_t i = 1; i < count; ++i)
+      {
+         last = last->m_next;
+      }
+      cache.m_head = last->m_next;
+      cache.m_count -= count;
+      last->m_next = nullptr;
+
+      giveBack(chain);
+   }
+
+   //! Keeps what the shared freelist has room for and frees the rest.
+   static void giveBack(Block* chain)
+   {
+      auto& pool = sharedPool();
+      {
+         std::lock_guard<std::mutex> lock(pool.m_mutex);
+         while (chain != nullptr && pool.m_count < POOL_SHARED_CACHE_SIZE)
+         {
+            auto block = chain;
+            chain = block->m_next;
+            block->m_next = pool.m_head;
+            pool.m_head = block;
+            ++pool.m_count;
+         }
+      }
+      free(chain);
+   }
+
+   static void free(Block* chain)
+   {
+      while (chain != nullptr)
+      {
+         auto block = chain;
+         chain = block->m_next;
+         ::operator delete(block);
+      }
+   }
+
+   static thread_local ThreadCache t_cache;
+};
+
+template<class T>
+thread_local typename ObjectPool<T>::ThreadCache ObjectPool<T>::t_cache = { nullptr, 0, false };
+
+
+//! Standard allocator that takes single objects from the ObjectPool of
+//! their type, for std::allocate_shared and node based containers.
+template<class T>
+class PoolAllocator
+{
+public:
+   typedef T value_type;
+
+   PoolAllocator() = default;
+
+   template<class U>
+   PoolAllocator(const PoolAllocator<U>&)
+   {
+   }
+
+   T* allocate(std::size_t n)
+   {
+      if (n == 1)
+      {
+         return static_cast<T*>(ObjectPool<T>::allocate());
+      }
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+   }
+
+   void deallocate(T* p, std::size_t n)
+   {
+      if (n == 1)
+      {
+         ObjectPool<T>::deallocate(p);
+         return;
+      }
+      ::operator delete(p);
+   }
+};
+
+template<class T, class U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+   return true;
+}
+
+template<class T, class U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+   return false;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+//! Minimal in place optional value, used by operators that hold on to at
+//! most one element without requiring T to be default constructible and
+//! without allocating.
+template<class T>
+class Optional
+{
+public:
+   Optional()
+         : m_storage(),
+           m_hasValue(false)
+   {
+   }
+
+   Optional(const Optional& other)
+         : m_storage(),
+           m_hasValue(false)
+   {
+      if (other.m_hasValue)
+      {
+         set(other.get());
+      }
+   }
+
+   Optional(Optional&& other)
+         : m_storage(),
+           m_hasValue(false)
+   {
+      if (other.m_hasValue)
+      {
+         set(std::move(other.get()));
+      }
+   }
+
+   Optional& operator=(Optional&& other)
+   {
+      if (this != &other)
+      {
+         if (other.m_hasValue)
+         {
+            set(std::move(other.get()));
+         }
+         else
+         {
+            reset();
+         }
+      }
+      return *this;
+   }
+
+   Optional& operator=(const Optional& other)
+   {
+      if (this != &other)
+      {
+         if (other.m_hasValue)
+         {
+            set(other.get());
+         }
+         else
+         {
+            reset();
+         }
+      }
+      return *this;
+   }
+
+   ~Optional()
+   {
+      reset();
+   }
+
+   bool hasValue() const
+   {
+      return m_hasValue;
+   }
+
+   const T& get() const
+   {
+      return *reinterpret_cast<const T*>(&m_storage);
+   }
+
+   T& get()
+   {
+      return *reinterpret_cast<T*>(&m_storage);
+   }
+
+   template<class U>
+   void set(U&& value)
+   {
+      if (m_hasValue)
+      {
+         get() = std::forward<U>(value);
+      }
+      else
+      {
+         new (&m_storage) T(std::forward<U>(value));
+         m_hasValue = true;
+      }
+   }
+
+   //! Moves the value out and leaves the optional empty.
+   T take()
+   {
+      T value(std::move(get()));
+      reset();
+      return value;
+   }
+
+   void reset()
+   {
+      if (m_hasValue)
+      {
+         get().~T();
+         m_hasValue = false;
+      }
+   }
+
+private:
+   //! Zeroed on construction, GCC otherwise warns that copies of an empty
+   //! Optional read it uninitialized.
+   typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+   bool m_hasValue;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//! A named POSIX shared memory object mapped read-write into this process
+//! for as long as the object lives.
+class SharedMemory
+{
+public:
+   //! Creates, or replaces, the object called name with size zeroed bytes.
+   //! The name is unlinked again when the returned object is destroyed;
+   //! processes that have it mapped keep their mapping. Throws
+   //! std::system_error on failure.
+   static std::shared_ptr<SharedMemory> create(const std::string& name,
+                                               std::size_t size);
+
+   //! Maps the existing object called name. Throws std::system_error on
+   //! failure.
+   static std::shared_ptr<SharedMemory> open(const std::string& name);
+
+   ~SharedMemory();
+
+   SharedMemory(const SharedMemory&) = delete;
+   SharedMemory& operator=(const SharedMemory&) = delete;
+
+   void* data() const;
+
+   std::size_t size() const;
+
+   //! Blocks while word equals expected, for at most timeout. Works across
+   //! processes.
+   static void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                         std::chrono::milliseconds timeout);
+
+   //! Wakes every process and thread blocked in futexWait on word.
+   static void futexWakeAll(std::atomic<std::uint32_t>& word);
+
+private:
+   SharedMemory(std::string name, void* data, std::size_t size, bool isOwner);
+
+   const std::string m_name;
+   void* const m_data;
+   const std::size_t m_size;
+   const bool m_isOwner;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "rx/internal/Optional.hpp"
+
+//! Unbounded single producer, single consumer queue made of fixed size
+//! segments.
+//!
+//! offer() may only be called from one thread at a time and isEmpty(),
+//! front() and pop() from one other thread at a time. Neither side takes a
+//! lock. The producer fills a segment of segmentSize slots and links a new
+//! one behind it once it is full; the consumer drains the segments in
+//! order and hands every drained one back for reuse, so a queue whose
+//! length stays within one segment of its peak does not allocate. The
+//! length itself is not bounded: segmentSize is the unit of allocation.
+template<class T>
+class SpscLinkedArrayQueue
+{
+public:
+   explicit SpscLinkedArrayQueue(std::size_t segmentSize)
+         : m_segmentSize(segmentSize),
+           m_producer(new Segment(segmentSize)),
+           m_consumer(m_producer),
+           m_head(0),
+           m_spare(nullptr)
+   {
+   }
+
+   SpscLinkedArrayQueue(const SpscLinkedArrayQueue&) = delete;
+   SpscLinkedArrayQueue& operator=(const SpscLinkedArrayQueue&) = delete;
+
+   ~SpscLinkedArrayQueue()
+   {
+      auto segment = m_consumer;
+      while (segment != nullptr)
+      {
+         auto next = segment->m_next.load(std::memory_order_relaxed);
+         delete segment;
+         segment = next;
+      }
+      delete m_spare.load(std::memory_order_relaxed);
+   }
+
+   //! Producer side.
+   template<class U>
+   void offer(U&& t)
+   {
+      auto segment = m_producer;
+      auto tail = segment->m_tail.load(std::memory_order_relaxed);
+      if (tail < m_segmentSize)
+      {
+         segment->m_slots[tail].set(std::forward<U>(t));
+         segment->m_tail.store(tail + 1, std::memory_order_release);
+         return;
+      }
+
+      // The element goes first into the new segment, which is published
+      // by linking it.
+      auto next = m_spare.exchange(nullptr, std::memory_order_acquire);
+      if (next == nullptr)
+      {
+         next = new Segment(m_segmentSize);
+      }
+      next->m_slots[0].set(std::forward<U>(t));
+      next->m_tail.store(1, std::memory_order_relaxed);
+      segment->m_next.store(next, std::memory_order_release);
+      m_producer = next;
+   }
+
+   //! Consumer side.
+   bool isEmpty()
+   {
+      return !advance();
+   }
+
+   //! Consumer side. Only valid if the queue is not empty.
+   T& front()
+   {
+      return m_consumer->m_slots[m_head].get();
+   }
+
+   //! Consumer side. Only valid if the queue is not empty.
+   void pop()
+   {
+      m_consumer->m_slots[m_head].reset();
+      ++m_head;
+   }
+
+private:
+   struct Segment
+   {
+      explicit Segment(std::size_t size)
+            : m_slots(size),
+              m_tail(0),
+              m_next(nullptr)
+      {
+      }
+
+      std::vector<Optional<T>> m_slots;
+      std::atomic<std::size_t> m_tail;
+      std::atomic<Segment*> m_next;
+   };
+
+   //! Consumer side. Steps onto the next segment once the current one has
+   //! been drained and returns true if there is an element at the head.
+   bool advance()
+   {
+      if (m_head == m_segmentSize)
+      {
+         auto next = m_consumer->m_next.load(std::memory_order_acquire);
+         if (next == nullptr)
+         {
+            return false;
+         }
+         recycle(m_consumer);
+         m_consumer = next;
+         m_head = 0;
+      }
+      return m_head < m_consumer->m_tail.load(std::memory_order_acquire);
+   }
+
+   //! Consumer side. Keeps one drained segment for the producer to reuse.
+   void recycle(Segment* segment)
+   {
+      segment->m_tail.store(0, std::memory_order_relaxed);
+      segment->m_next.store(nullptr, std::memory_order_relaxed);
+      delete m_spare.exchange(segment, std::memory_order_acq_rel);
+   }
+
+   const std::size_t m_segmentSize;
+
+   // Producer side.
+   Segment* m_producer;
+   char m_padding0[64];
+
+   // Consumer side.
+   Segment* m_consumer;
+   std::size_t m_head;
+   char m_padding1[64];
+
+   std::atomic<Segment*> m_spare;
+};
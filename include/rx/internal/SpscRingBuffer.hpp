@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "rx/internal/Optional.hpp"
+
+//! Fixed capacity single producer, single consumer ring buffer.
+//!
+//! offer() may only be called from one thread at a time and isEmpty(),
+//! front() and pop() from one other thread at a time. Neither side takes a
+//! lock and elements are constructed in place in preallocated slots.
+template<class T>
+class SpscRingBuffer
+{
+public:
+   explicit SpscRingBuffer(std::size_t capacity)
+         : m_capacity(capacity),
+           m_mask(roundUpToPowerOfTwo(capacity) - 1),
+           m_slots(m_mask + 1),
+           m_head(0),
+           m_tail(0)
+   {
+   }
+
+   SpscRingBuffer(const SpscRingBuffer&) = delete;
+   SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+   std::size_t capacity() const
+   {
+      return m_capacity;
+   }
+
+   //! Producer side. Returns false if the buffer is full.
+   template<class U>
+   bool offer(U&& t)
+   {
+      auto tail = m_tail.load(std::memory_order_relaxed);
+      if (tail - m_head.load(std::memory_order_acquire) == m_capacity)
+      {
+         return false;
+      }
+      m_slots[tail & m_mask].set(std::forward<U>(t));
+      m_tail.store(tail + 1, std::memory_order_release);
+      return true;
+   }
+
+   //! Consumer side.
+   bool isEmpty() const
+   {
+      return m_head.load(std::memory_order_relaxed)
+             == m_tail.load(std::memory_order_acquire);
+   }
+
+   //! Consumer side. Only valid if the buffer is not empty.
+   T& front()
+   {
+      return m_slots[m_head.load(std::memory_order_relaxed) & m_mask].get();
+   }
+
+   //! Consumer side. Only valid if the buffer is not empty.
+   void pop()
+   {
+      auto head = m_head.load(std::memory_order_relaxed);
+      m_slots[head & m_mask].reset();
+      m_head.store(head + 1, std::memory_order_release);
+   }
+
+   //! Consumer side. Moves the front element into t if there is one.
+   bool poll(T& t)
+   {
+      if (isEmpty())
+      {
+         return false;
+      }
+      t = std::move(front());
+      pop();
+      return true;
+   }
+
+   //! Either side; exact only when the other side is idle.
+   std::size_t size() const
+   {
+      return m_tail.load(std::memory_order_acquire)
+             - m_head.load(std::memory_order_acquire);
+   }
+
+private:
+   static std::size_t roundUpToPowerOfTwo(std::size_t n)
+   {
+      std::size_t capacity = 1;
+      while (capacity < n)
+      {
+         capacity *= 2;
+      }
+      return capacity;
+   }
+
+   const std::size_t m_capacity;
+   const std::size_t m_mask;
+   std::vector<Optional<T>> m_slots;
+
+   // Head and tail are written by different threads; keep them on
+   // different cache lines.
+   char m_padding0[64];
+   std::atomic<std::size_t> m_head;
+   char m_padding1[64];
+   std::atomic<std::size_t> m_tail;
+   char m_padding2[64];
+};
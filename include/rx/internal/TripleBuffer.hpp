@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "rx/internal/Optional.hpp"
+
+//! Wait free single producer, single consumer latest value slot.
+//!
+//! The producer writes into a back buffer it owns and publishes it by
+//! swapping it with the middle buffer; the consumer takes the middle
+//! buffer by swapping it with the front buffer it owns. Neither side ever
+//! waits for the other and values are never read while being written, so
+//! T does not need to be trivially copyable. Values the consumer did not
+//! pick up in time are overwritten by newer ones.
+template<class T>
+class TripleBuffer
+{
+public:
+   TripleBuffer()
+         : m_middle(1),
+           m_front(0),
+           m_back(2)
+   {
+   }
+
+   TripleBuffer(const TripleBuffer&) = delete;
+   TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+   //! Producer side.
+   template<class U>
+   void write(U&& t)
+   {
+      m_buffers[m_back].set(std::forward<U>(t));
+      auto previous = m_middle.exchange(m_back | IS_DIRTY, std::memory_order_acq_rel);
+      m_back = previous & INDEX_MASK;
+   }
+
+   //! Consumer side. Makes the latest published value the front value and
+   //! returns true if there was one that had not been taken yet.
+   bool update()
+   {
+      if ((m_middle.load(std::memory_order_relaxed) & IS_DIRTY) == 0)
+      {
+         return false;
+      }
+      auto previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+      m_front = previous & INDEX_MASK;
+      return true;
+   }
+
+   //! Consumer side.
+   bool hasFront() const
+   {
+      return m_buffers[m_front].hasValue();
+   }
+
+   //! Consumer side. Only valid if hasFront().
+   const T& front() const
+   {
+      return m_buffers[m_front].get();
+   }
+
+private:
+   static const std::uint8_t INDEX_MASK = 0x3;
+   static const std::uint8_t IS_DIRTY = 0x4;
+
+   Optional<T> m_buffers[3];
+   std::atomic<std::uint8_t> m_middle;
+   std::uint8_t m_front;
+   std::uint8_t m_back;
+};
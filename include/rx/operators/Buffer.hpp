@@ -0,0 +1,138 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+
+// Buffers are handed to the observer by const reference, so an observer
+// that wants to keep a batch has to copy it and the operator can reuse its
+// vector as soon as onNext returns. Every subscription therefore owns a
+// single vector that is cleared, keeping its capacity, after each
+// emission and never reallocates once it has been reserved.
+
+template<class T>
+Observer<T> createOperatorBuffer(Observer<std::vector<T>> o, std::size_t count)
+{
+   auto buffer = std::make_shared<std::vector<T>>();
+   buffer->reserve(count);
+
+   return Observer<T>(
+      // onNext
+      [o, buffer, count](const T& t) {
+         buffer->push_back(t);
+         if (buffer->size() >= count)
+         {
+            o.onNext(*buffer);
+            buffer->clear();
+         }
+      },
+      // onCompleted
+      [o, buffer]() {
+         if (!buffer->empty())
+         {
+            o.onNext(*buffer);
+            buffer->clear();
+         }
+         o.onCompleted();
+      },
+      // onError
+      [o, buffer](std::exception_ptr e) {
+         buffer->clear();
+         o.onError(e);
+      });
+}
+
+template<class T>
+struct BufferWithTimeState
+{
+   BufferWithTimeState(Observer<std::vector<T>> observer, std::size_t maxCount)
+         : m_observer(std::move(observer)),
+           m_maxCount(maxCount),
+           m_isDone(false)
+   {
+      if (m_maxCount > 0)
+      {
+         m_buffer.reserve(m_maxCount);
+      }
+   }
+
+   void emit()
+   {
+      m_observer.onNext(m_buffer);
+      m_buffer.clear();
+   }
+
+   std::recursive_mutex m_mutex;
+   Observer<std::vector<T>> m_observer;
+   std::vector<T> m_buffer;
+   const std::size_t m_maxCount;
+   bool m_isDone;
+};
+
+//! Emits the elements collected during every timespan, or earlier as soon
+//! as maxCount elements have been collected if maxCount is not zero.
+template<class T>
+Subscriber<T> createOperatorBufferWithTime(Subscriber<std::vector<T>> subscriber,
+                                           Scheduler::Duration timespan,
+                                           std::size_t maxCount,
+                                           Scheduler scheduler)
+{
+   auto state = std::make_shared<BufferWithTimeState<T>>(
+         subscriber.getObserver(), maxCount);
+
+   std::weak_ptr<BufferWithTimeState<T>> weak_state = state;
+   auto timerSubscription = scheduler.schedulePeriodically(
+         scheduler.now() + timespan, timespan, [weak_state]() {
+            if (auto shared_state = weak_state.lock())
+            {
+               std::lock_guard<std::recursive_mutex> lock(shared_state->m_mutex);
+               if (!shared_state->m_isDone)
+               {
+                  shared_state->emit();
+               }
+            }
+         });
+
+   auto parent = Subscriber<T>(Observer<T>(
+      // onNext
+      [state](const T& t) {
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         if (state->m_isDone)
+         {
+            return;
+         }
+         state->m_buffer.push_back(t);
+         if (state->m_buffer.size() == state->m_maxCount)
+         {
+            state->emit();
+         }
+      },
+      // onCompleted
+      [state, timerSubscription]() {
+         timerSubscription.unsubscribe();
+
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isDone = true;
+         if (!state->m_buffer.empty())
+         {
+            state->emit();
+         }
+         state->m_observer.onCompleted();
+      },
+      // onError
+      [state, timerSubscription](std::exception_ptr e) {
+         timerSubscription.unsubscribe();
+
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isDone = true;
+         state->m_buffer.clear();
+         state->m_observer.onError(e);
+      }));
+
+   subscriber.add(timerSubscription);
+   subscriber.add(parent.getSubscription());
+   return parent;
+}
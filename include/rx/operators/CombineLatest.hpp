@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <tuple>
+#include <utility>
+
+#include "rx/Observable.hpp"
+#include "rx/internal/TripleBuffer.hpp"
+
+//! Combines the latest element of every source whenever one of them
+//! emits, once all of them have emitted at least once.
+//!
+//! Every source publishes into its own TripleBuffer, which costs a copy
+//! and an atomic exchange and never takes a lock, and then runs a drain
+//! pass. Drains are serialized with a work-in-progress counter, so the
+//! combiner is never called concurrently. When sources emit on the same
+//! thread every element produces a combination; when they race, elements
+//! that arrive while another thread is draining are conflated to the
+//! latest one per source.
+template<class Combiner, class... Ts>
+class CombineLatestState
+      : public std::enable_shared_from_this<CombineLatestState<Combiner, Ts...>>
+{
+public:
+   typedef typename std::result_of<Combiner(const Ts&...)>::type R;
+
+   CombineLatestState(Observer<R> observer, Combiner combiner)
+         : m_observer(std::move(observer)),
+           m_combiner(std::move(combiner)),
+           m_wip(0),
+           m_errorState(ERROR_UNSET),
+           m_isTerminated(false)
+   {
+      for (auto& isDone : m_isDone)
+      {
+         isDone.store(false, std::memory_order_relaxed);
+      }
+   }
+
+   void subscribe(Subscriber<R> subscriber, const Observable<Ts>&... sources)
+   {
+      subscriber.add(m_subscriptions);
+      subscribe(std::index_sequence_for<Ts...>(), sources...);
+   }
+
+private:
+   enum ErrorState
+   {
+      ERROR_UNSET,
+      ERROR_SETTING,
+      ERROR_SET
+   };
+
+   template<std::size_t... I>
+   void subscribe(std::index_sequence<I...>, const Observable<Ts>&... sources)
+   {
+      auto self = this->shared_from_this();
+      (void)std::initializer_list<int>{ (subscribeTo<I>(self, sources), 0)... };
+   }
+
+   template<std::size_t I, class T>
+   void subscribeTo(const std::shared_ptr<CombineLatestState>& self,
+                    const Observable<T>& source)
+   {
+      if (m_isTerminated.load(std::memory_order_acquire))
+      {
+         return;
+      }
+
+      m_subscriptions.add(source.subscribe(Observer<T>(
+         // onNext
+         [self](const T& t) {
+            std::get<I>(self->m_latest).write(t);
+            self->drain();
+         },
+         // onCompleted
+         [self]() {
+            self->m_isDone[I].store(true, std::memory_order_release);
+            self->drain();
+         },
+         // onError
+         [self](std::exception_ptr e) {
+            int expected = ERROR_UNSET;
+            if (self->m_errorState.compare_exchange_strong(expected, ERROR_SETTING))
+            {
+               self->m_error = std::move(e);
+               self->m_errorState.store(ERROR_SET, std::memory_order_release);
+            }
+            self->drain();
+         })));
+   }
+
+   void drain()
+   {
+      if (m_wip.fetch_add(1, std::memory_order_acq_rel) != 0)
+      {
+         return;
+      }
+
+      int missed = 1;
+      for (;;)
+      {
+         if (!m_isTerminated.load(std::memory_order_relaxed))
+         {
+            drainOnce(std::index_sequence_for<Ts...>());
+         }
+
+         missed = m_wip.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+         if (missed == 0)
+         {
+            break;
+         }
+      }
+   }
+
+   template<std::size_t... I>
+   void drainOnce(std::index_sequence<I...>)
+   {
+      if (m_errorState.load(std::memory_order_acquire) == ERROR_SET)
+      {
+         terminate();
+         m_observer.onError(m_error);
+         return;
+      }
+
+      // Read the done flags before the slots: a source publishes its last
+      // element before it marks itself done.
+      bool isDone[sizeof...(Ts)] = { m_isDone[I].load(std::memory_order_acquire)... };
+      bool isUpdated[sizeof...(Ts)] = { std::get<I>(m_latest).update()... };
+      bool hasValue[sizeof...(Ts)] = { std::get<I>(m_latest).hasFront()... };
+
+      bool isAnyUpdated = false;
+      bool isAllDone = true;
+      bool isAllReady = true;
+      for (std::size_t i = 0; i < sizeof...(Ts); i++)
+      {
+         isAnyUpdated = isAnyUpdated || isUpdated[i];
+         isAllDone = isAllDone && isDone[i];
+         isAllReady = isAllReady && hasValue[i];
+
+         if (isDone[i] && !hasValue[i])
+         {
+            // This source can never contribute, nothing can be combined.
+            terminate();
+            m_observer.onCompleted();
+            return;
+         }
+      }
+
+      if (isAllReady && isAnyUpdated)
+      {
+         m_observer.onNext(m_combiner(std::get<I>(m_latest).front()...));
+      }
+
+      if (isAllDone)
+      {
+         terminate();
+         m_observer.onCompleted();
+      }
+   }
+
+   void terminate()
+   {
+      m_isTerminated.store(true, std::memory_order_release);
+      m_subscriptions.unsubscribe();
+   }
+
+   Observer<R> m_observer;
+   Combiner m_combiner;
+   std::tuple<TripleBuffer<Ts>...> m_latest;
+   std::atomic<bool> m_isDone[sizeof...(Ts)];
+   std::atomic<int> m_wip;
+   std::atomic<int> m_errorState;
+   std::exception_ptr m_error;
+   std::atomic<bool> m_isTerminated;
+   SubscriptionList m_subscriptions;
+};
+
+template<class Combiner, class... Ts>
+Observable<typename CombineLatestState<Combiner, Ts...>::R>
+combineLatestWith(Combiner combiner, Observable<Ts>... sources)
+{
+   typedef CombineLatestState<Combiner, Ts...> State;
+   typedef typename State::R R;
+
+   return Observable<R>::create([combiner, sources...](Subscriber<R> s){
+      auto state = std::make_shared<State>(s.getObserver(), combiner);
+      state->subscribe(s, sources...);
+   });
+}
+
+template<class Tuple, std::size_t... I>
+auto combineLatestFromTuple(Tuple&& args, std::index_sequence<I...>)
+   -> decltype(combineLatestWith(std::get<sizeof...(I)>(args), std::get<I>(args)...))
+{
+   return combineLatestWith(std::get<sizeof...(I)>(args), std::get<I>(args)...);
+}
+
+//! combineLatest(a, b, ..., combiner) calls combiner with the latest
+//! element of every source each time one of them emits.
+template<class... Args>
+auto combineLatest(Args... args)
+   -> decltype(combineLatestFromTuple(std::forward_as_tuple(args...),
+                                      std::make_index_sequence<sizeof...(Args) - 1>()))
+{
+   return combineLatestFromTuple(std::forward_as_tuple(args...),
+                                 std::make_index_sequence<sizeof...(Args) - 1>());
+}
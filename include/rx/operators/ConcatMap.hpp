@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "rx/Observer.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/Optional.hpp"
+
+template<class T>
+class Observable;
+
+//! Subscribes to queued sources one after the other.
+//!
+//! A source that completes synchronously completes inside subscribe, so
+//! subscribing to the next source from its onCompleted would nest one
+//! stack frame per source. Instead onCompleted only marks the source as
+//! finished and the trampolining drain loop, serialized by a
+//! work-in-progress counter, subscribes to the next source once the
+//! previous subscribe has returned. A single inner Subscriber is reused
+//! for every source.
+template<class R>
+class ConcatState : public std::enable_shared_from_this<ConcatState<R>>
+{
+public:
+   ConcatState(Observer<R> observer)
+         : m_observer(std::move(observer)),
+           m_inner(Observer<R>()),
+           m_wip(0),
+           m_isActive(false),
+           m_isOuterDone(false),
+           m_isTerminated(false)
+   {
+   }
+
+   //! Creates the inner subscriber and ties both to the downstream
+   //! subscriber. Must be called once, right after construction.
+   void init(Subscriber<R> subscriber)
+   {
+      std::weak_ptr<ConcatState> weak_state = this->shared_from_this();
+      auto o = m_observer;
+
+      m_inner = Subscriber<R>(Observer<R>(
+         // onNext
+         [o](const R& r) {
+            o.onNext(r);
+         },
+         // onCompleted
+         [weak_state]() {
+            if (auto shared_state = weak_state.lock())
+            {
+               shared_state->onInnerCompleted();
+            }
+         },
+         // onError
+         [weak_state](std::exception_ptr e) {
+            if (auto shared_state = weak_state.lock())
+            {
+               shared_state->onError(std::move(e));
+            }
+         }));
+
+      auto shared_state = this->shared_from_this();
+      subscriber.add(m_inner.getSubscription());
+      subscriber.add(Subscription([shared_state]() {
+         std::lock_guard<std::mutex> lock(shared_state->m_mutex);
+         shared_state->m_isTerminated = true;
+         shared_state->m_queue.clear();
+      }));
+   }
+
+   void push(Observable<R> source)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_isTerminated)
+         {
+            return;
+         }
+         m_queue.push_back(std::move(source));
+      }
+      drain();
+   }
+
+   void onOuterCompleted()
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_isOuterDone = true;
+      }
+      drain();
+   }
+
+   void onError(std::exception_ptr e)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_isTerminated)
+         {
+            return;
+         }
+         m_isTerminated = true;
+         m_queue.clear();
+      }
+      m_inner.getSubscription().unsubscribe();
+      m_observer.onError(e);
+   }
+
+private:
+   void onInnerCompleted()
+   {
+      // Releases whatever the finished source registered on the reused
+      // subscriber, before the next source registers its own.
+      m_inner.getSubscription().unsubscribe();
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_isActive = false;
+      }
+      drain();
+   }
+
+   void drain()
+   {
+      if (m_wip.fetch_add(1, std::memory_order_acq_rel) != 0)
+      {
+         return;
+      }
+
+      int missed = 1;
+      for (;;)
+      {
+         for (;;)
+         {
+            // Decided under the lock, emitted without it: the downstream
+            // may unsubscribe from onCompleted, which takes the lock.
+            Optional<Observable<R>> next;
+            bool isCompleted = false;
+            {
+               std::lock_guard<std::mutex> lock(m_mutex);
+               if (m_isTerminated || m_isActive)
+               {
+                  break;
+               }
+               if (m_queue.empty())
+               {
+                  if (!m_isOuterDone)
+                  {
+                     break;
+                  }
+                  m_isTerminated = true;
+                  isCompleted = true;
+               }
+               else
+               {
+                  next.set(std::move(m_queue.front()));
+                  m_queue.pop_front();
+                  m_isActive = true;
+               }
+            }
+
+            if (isCompleted)
+            {
+               m_observer.onCompleted();
+               break;
+            }
+            next.get().unsafeSubscribe(m_inner);
+         }
+
+         missed = m_wip.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+         if (missed == 0)
+         {
+            break;
+         }
+      }
+   }
+
+   Observer<R> m_observer;
+   Subscriber<R> m_inner;
+   std::atomic<int> m_wip;
+   std::mutex m_mutex;
+   std::deque<Observable<R>> m_queue;
+   bool m_isActive;
+   bool m_isOuterDone;
+   bool m_isTerminated;
+};
+
+//! Maps every element to an Observable and emits the elements of those
+//! Observables one Observable after the other.
+template<class T, class R, class Callable>
+Subscriber<T> createOperatorConcatMap(Subscriber<R> subscriber, Callable f)
+{
+   auto state = std::make_shared<ConcatState<R>>(subscriber.getObserver());
+   state->init(subscriber);
+
+   auto parent = Subscriber<T>(Observer<T>(
+      // onNext
+      [state, f](const T& t) {
+         state->push(f(t));
+      },
+      // onCompleted
+      [state]() {
+         state->onOuterCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         state->onError(std::move(e));
+      }));
+
+   subscriber.add(parent.getSubscription());
+   return parent;
+}
+
+//! Emits the elements of every source, one source after the other.
+template<class T, class... Rest>
+Observable<T> concat(Observable<T> first, Rest... rest)
+{
+   std::vector<Observable<T>> sources{ first, Observable<T>(rest)... };
+
+   return Observable<T>::create([sources](Subscriber<T> s){
+      auto state = std::make_shared<ConcatState<T>>(s.getObserver());
+      state->init(s);
+      for (auto& source : sources)
+      {
+         state->push(source);
+      }
+      state->onOuterCompleted();
+   });
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <mutex>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/Optional.hpp"
+
+template<class T>
+struct DebounceState
+{
+   DebounceState(Observer<T> observer, Scheduler::Duration timeout,
+                 Scheduler scheduler)
+         : m_observer(std::move(observer)),
+           m_timeout(timeout),
+           m_scheduler(std::move(scheduler)),
+           m_isArmed(false)
+   {
+   }
+
+   //! Runs when the timer expires. Elements that arrived since the timer
+   //! was armed only moved m_deadline, so the timer is re-armed here
+   //! instead of on every element.
+   void onTimer()
+   {
+      std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+      if (!m_isArmed)
+      {
+         return;
+      }
+
+      if (m_scheduler.now() < m_deadline)
+      {
+         m_timer.arm(m_deadline);
+         return;
+      }
+
+      m_isArmed = false;
+      if (m_value.hasValue())
+      {
+         m_observer.onNext(m_value.take());
+      }
+   }
+
+   std::recursive_mutex m_mutex;
+   Observer<T> m_observer;
+   const Scheduler::Duration m_timeout;
+   const Scheduler m_scheduler;
+   Timer m_timer;
+   Scheduler::TimePoint m_deadline;
+   Optional<T> m_value;
+   bool m_isArmed;
+};
+
+//! Emits an element only once timeout has passed without another element
+//! arriving. Every subscription owns a single Timer; an element costs one
+//! clock read and a store, plus arming the timer if it is idle.
+template<class T>
+Subscriber<T> createOperatorDebounce(Subscriber<T> subscriber,
+                                     Scheduler::Duration timeout,
+                                     Scheduler scheduler)
+{
+   auto state = std::make_shared<DebounceState<T>>(
+         subscriber.getObserver(), timeout, scheduler);
+
+   std::weak_ptr<DebounceState<T>> weak_state = state;
+   state->m_timer = scheduler.createTimer([weak_state]() {
+      if (auto shared_state = weak_state.lock())
+      {
+         shared_state->onTimer();
+      }
+   });
+
+   auto parent = Subscriber<T>(Observer<T>(
+      // onNext
+      [state](const T& t) {
+         auto deadline = state->m_scheduler.now() + state->m_timeout;
+
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_value.set(t);
+         state->m_deadline = deadline;
+         if (!state->m_isArmed)
+         {
+            state->m_isArmed = true;
+            state->m_timer.arm(deadline);
+         }
+      },
+      // onCompleted
+      [state]() {
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isArmed = false;
+         state->m_timer.dispose();
+         if (state->m_value.hasValue())
+         {
+            state->m_observer.onNext(state->m_value.take());
+         }
+         state->m_observer.onCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isArmed = false;
+         state->m_timer.dispose();
+         state->m_value.reset();
+         state->m_observer.onError(e);
+      }));
+
+   subscriber.add(state->m_timer.getSubscription());
+   subscriber.add(parent.getSubscription());
+   return parent;
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "rx/Observer.hpp"
+#include "rx/internal/FlatHashMap.hpp"
+#include "rx/internal/Optional.hpp"
+
+//! Reports what the key tables of distinct() cost. One report may be
+//! shared by many subscriptions, or operators, and then adds them up.
+//! Counters are updated as the tables change and may be read from any
+//! thread.
+class DistinctReport
+{
+public:
+   DistinctReport()
+         : m_keyCount(0),
+           m_memoryUsage(0),
+           m_evictionCount(0)
+   {
+   }
+
+   //! Keys currently remembered.
+   std::size_t getKeyCount() const
+   {
+      return m_keyCount.load(std::memory_order_relaxed);
+   }
+
+   //! Bytes taken by the tables, not counting memory that the keys
+   //! allocate themselves.
+   std::size_t getMemoryUsage() const
+   {
+      return m_memoryUsage.load(std::memory_order_relaxed);
+   }
+
+   //! Keys forgotten to stay within the maximum size.
+   std::size_t getEvictionCount() const
+   {
+      return m_evictionCount.load(std::memory_order_relaxed);
+   }
+
+private:
+   template<class T, class K, class KeySelector>
+   friend struct DistinctState;
+
+   std::atomic<std::size_t> m_keyCount;
+   std::atomic<std::size_t> m_memoryUsage;
+   std::atomic<std::size_t> m_evictionCount;
+};
+
+template<class T, class K, class KeySelector>
+struct DistinctState
+{
+   //! Every key is stored with the sequence number of the element that
+   //! last had it, which orders the keys from least to most recently seen.
+   typedef std::uint64_t Sequence;
+
+   DistinctState(Observer<T> observer, KeySelector keySelector, std::size_t maxSize,
+                 std::shared_ptr<DistinctReport> report)
+         : m_observer(std::move(observer)),
+           m_keySelector(std::move(keySelector)),
+           m_maxSize(maxSize),
+           m_report(std::move(report)),
+           m_sequence(0),
+           m_reportedKeys(0),
+           m_reportedMemory(0)
+   {
+      updateReport();
+   }
+
+   ~DistinctState()
+   {
+      if (m_report)
+      {
+         m_report->m_keyCount.fetch_sub(m_reportedKeys, std::memory_order_relaxed);
+         m_report->m_memoryUsage.fetch_sub(m_reportedMemory, std::memory_order_relaxed);
+      }
+   }
+
+   //! Returns true if t has a key that has not been seen before.
+   bool isNew(const T& t)
+   {
+      auto sequence = ++m_sequence;
+      auto key = m_keySelector(t);
+
+      bool isCreated = false;
+      if (m_maxSize == 0)
+      {
+         m_keys.findOrCreate(key, [sequence]() { return sequence; }, isCreated);
+      }
+      else if (auto seen = m_keys.find(key))
+      {
+         *seen = sequence;
+      }
+      else
+      {
+         if (m_keys.size() >= m_maxSize)
+         {
+            evict();
+         }
+         m_keys.findOrCreate(key, [sequence]() { return sequence; }, isCreated);
+      }
+
+      if (isCreated)
+      {
+         updateReport();
+      }
+      return isCreated;
+   }
+
+   //! Forgets every key that was not seen among the last maxSize / 2
+   //! elements. Those are the least recently seen keys, and at most
+   //! maxSize / 2 keys can be more recent, so this frees at least half of
+   //! the table and its cost is spread over as many insertions.
+   void evict()
+   {
+      auto threshold = m_sequence - (m_maxSize + 1) / 2;
+      auto evicted = m_keys.removeIf([threshold](const K&, Sequence seen) {
+         return seen <= threshold;
+      });
+      if (m_report)
+      {
+         m_report->m_evictionCount.fetch_add(evicted, std::memory_order_relaxed);
+      }
+   }
+
+   //! Forgets every key and shrinks the table back to its initial size.
+   void release()
+   {
+      m_keys.removeIf([](const K&, Sequence) { return true; });
+      updateReport();
+   }
+
+   void updateReport()
+   {
+      if (!m_report)
+      {
+         return;
+      }
+
+      auto keys = m_keys.size();
+      auto memory = m_keys.memoryUsage();
+      m_report->m_keyCount.fetch_add(keys - m_reportedKeys, std::memory_order_relaxed);
+      if (memory != m_reportedMemory)
+      {
+         m_report->m_memoryUsage.fetch_add(memory - m_reportedMemory,
+                                           std::memory_order_relaxed);
+      }
+      m_reportedKeys = keys;
+      m_reportedMemory = memory;
+   }
+
+   Observer<T> m_observer;
+   KeySelector m_keySelector;
+   const std::size_t m_maxSize;
+   const std::shared_ptr<DistinctReport> m_report;
+   FlatHashMap<K, Sequence> m_keys;
+   Sequence m_sequence;
+   std::size_t m_reportedKeys;
+   std::size_t m_reportedMemory;
+};
+
+//! Emits the elements whose key has not been seen before. Keys live inline
+//! in a flat open addressing table, so remembering one costs the key, its
+//! hash and a sequence number, with no allocation per key. A maxSize of
+//! zero remembers every key; otherwise the least recently seen keys are
+//! forgotten to stay within maxSize, and an element whose key has been
+//! forgotten is emitted again. The keys are released on termination.
+template<class T, class K, class KeySelector>
+Observer<T> createOperatorDistinct(Observer<T> o, KeySelector keySelector,
+                                   std::size_t maxSize,
+                                   std::shared_ptr<DistinctReport> report)
+{
+   auto state = std::make_shared<DistinctState<T, K, KeySelector>>(
+         std::move(o), std::move(keySelector), maxSize, std::move(report));
+
+   return Observer<T>(
+      // onNext
+      [state](const T& t) {
+         if (state->isNew(t))
+         {
+            state->m_observer.onNext(t);
+         }
+      },
+      // onCompleted
+      [state]() {
+         state->release();
+         state->m_observer.onCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         state->release();
+         state->m_observer.onError(e);
+      });
+}
+
+//! Emits the elements that differ from the element before them, as told by
+//! isEqual(previous, current). Only the last element is kept, inline, so
+//! nothing is allocated for trivially copyable elements.
+template<class T, class Comparator>
+Observer<T> createOperatorDistinctUntilChanged(Observer<T> o, Comparator isEqual)
+{
+   auto last = std::make_shared<Optional<T>>();
+
+   return Observer<T>(
+      // onNext
+      [o, isEqual, last](const T& t) {
+         if (last->hasValue() && isEqual(last->get(), t))
+         {
+            return;
+         }
+         last->set(t);
+         o.onNext(t);
+      },
+      // onCompleted
+      [o]() {
+         o.onCompleted();
+      },
+      // onError
+      [o](std::exception_ptr e) {
+         o.onError(e);
+      });
+}
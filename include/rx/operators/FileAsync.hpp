@@ -0,0 +1,439 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rx/FileIo.hpp"
+#include "rx/Observable.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+
+typedef std::vector<char> IoBuffer;
+
+struct FileBlock
+{
+   std::uint64_t m_offset;
+
+   //! Points into a buffer that is reused for a later read once onNext
+   //! has returned.
+   std::string_view m_data;
+};
+
+static std::exception_ptr makeIoError(int error, const std::string& what)
+{
+   return std::make_exception_ptr(
+         std::system_error(error, std::generic_category(), what));
+}
+
+//! Keeps a fixed number of block reads in flight, reissuing every buffer
+//! for the next block as soon as it has been emitted. A read that comes
+//! back short before the end of the file is reissued for the rest of its
+//! block first.
+class FileReadState : public FileIo::Handler,
+                      public std::enable_shared_from_this<FileReadState>
+{
+public:
+   FileReadState(FileIo io, Observer<FileBlock> observer,
+                 CancellationFlag cancellation)
+         : m_io(std::move(io)),
+           m_observer(std::move(observer)),
+           m_cancellation(std::move(cancellation)),
+           m_fd(-1),
+           m_size(0),
+           m_blockSize(0),
+           m_nextOffset(0),
+           m_inFlight(0),
+           m_isTerminated(false)
+   {
+   }
+
+   ~FileReadState()
+   {
+      if (m_fd >= 0)
+      {
+         close(m_fd);
+      }
+   }
+
+   void start(const std::string& path, std::size_t blockSize, unsigned inFlight)
+   {
+      m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      struct stat status;
+      if (m_fd < 0 || fstat(m_fd, &status) != 0)
+      {
+         m_observer.onError(makeIoError(errno, "open " + path));
+         return;
+      }
+      m_size = std::uint64_t(status.st_size);
+      m_blockSize = blockSize;
+
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_buffers.resize(inFlight);
+         m_requests.resize(inFlight);
+         for (unsigned i = 0; i < inFlight && m_nextOffset < m_size; i++)
+         {
+            m_buffers[i].resize(blockSize);
+            m_requests[i] = FileIo::Request{ m_fd, false, m_buffers[i].data(),
+                                             blockSize, 0, this };
+            issue(m_requests[i]);
+         }
+
+         if (m_inFlight == 0)
+         {
+            m_isTerminated = true;
+            m_observer.onCompleted();
+            return;
+         }
+
+         // Every read in flight refers to this state.
+         m_self = shared_from_this();
+      }
+      m_io.submit();
+   }
+
+   void onIoCompleted(FileIo::Request& request, long result) override
+   {
+      std::shared_ptr<FileReadState> released;
+      std::unique_lock<std::mutex> lock(m_mutex);
+      --m_inFlight;
+
+      if (!m_isTerminated)
+      {
+         if (result < 0)
+         {
+            m_isTerminated = true;
+            m_observer.onError(makeIoError(int(-result), "read"));
+         }
+         else if (result > 0 && !m_cancellation.isCancelled())
+         {
+            m_observer.onNext(FileBlock{ request.m_offset,
+                  std::string_view(request.m_data, std::size_t(result)) });
+         }
+      }
+
+      bool isReading = !m_isTerminated && !m_cancellation.isCancelled();
+      auto end = request.m_offset + std::uint64_t(std::max(result, 0L));
+      if (isReading && result > 0 && std::size_t(result) < request.m_length
+          && end < m_size)
+      {
+         // The emitted bytes have been consumed, the rest of the block is
+         // read into the same buffer.
+         request.m_offset = end;
+         request.m_length -= std::size_t(result);
+         ++m_inFlight;
+         m_io.queue(request);
+      }
+      else if (isReading && m_nextOffset < m_size)
+      {
+         issue(request);
+      }
+      else
+      {
+         if (m_inFlight == 0)
+         {
+            if (isReading)
+            {
+               m_isTerminated = true;
+               m_observer.onCompleted();
+            }
+            released = std::move(m_self);
+         }
+         return;
+      }
+
+      // Once unlocked the last read may complete and release this state.
+      auto io = m_io;
+      lock.unlock();
+      io.submit();
+   }
+
+private:
+   //! Must be called with m_mutex held.
+   void issue(FileIo::Request& request)
+   {
+      request.m_offset = m_nextOffset;
+      request.m_length = m_blockSize;
+      m_nextOffset += m_blockSize;
+      ++m_inFlight;
+      m_io.queue(request);
+   }
+
+   FileIo m_io;
+   Observer<FileBlock> m_observer;
+   CancellationFlag m_cancellation;
+   int m_fd;
+   std::uint64_t m_size;
+   std::size_t m_blockSize;
+
+   std::mutex m_mutex;
+   std::vector<IoBuffer> m_buffers;
+   std::vector<FileIo::Request> m_requests;
+   std::uint64_t m_nextOffset;
+   unsigned m_inFlight;
+   bool m_isTerminated;
+   std::shared_ptr<FileReadState> m_self;
+};
+
+//! Reads the file at path in blocks of blockSize bytes, keeping inFlight
+//! reads outstanding, and emits every block as it completes. Blocks may
+//! complete, and so be emitted, out of order; FileBlock::m_offset says
+//! where each belongs. Emits on the I/O threads of io.
+static Observable<FileBlock> fromFileAsync(std::string path,
+                                           std::size_t blockSize = 1 << 20,
+                                           unsigned inFlight = 8,
+                                           FileIo io = FileIo::getDefault())
+{
+   return Observable<FileBlock>::create(
+         [path, blockSize, inFlight, io](Subscriber<FileBlock> s){
+      auto state = std::make_shared<FileReadState>(
+            io, s.getObserver(), CancellationFlag::create(s));
+      state->start(path, blockSize, inFlight);
+   });
+}
+
+
+//! Appends the buffers of a source to a file, handing writes to the kernel
+//! in batches.
+class FileWriteState : public FileIo::Handler,
+                       public std::enable_shared_from_this<FileWriteState>
+{
+public:
+   FileWriteState(FileIo io, Observer<std::uint64_t> observer,
+                  std::size_t batchSize)
+         : m_io(std::move(io)),
+           m_observer(std::move(observer)),
+           m_batchSize(batchSize),
+           m_fd(-1),
+           m_offset(0),
+           m_bytesWritten(0),
+           m_queued(0),
+           m_inFlight(0),
+           m_isSourceDone(false),
+           m_isTerminated(false)
+   {
+   }
+
+   ~FileWriteState()
+   {
+      if (m_fd >= 0)
+      {
+         close(m_fd);
+      }
+   }
+
+   bool open(const std::string& path)
+   {
+      m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if (m_fd < 0)
+      {
+         m_isTerminated = true;
+         m_observer.onError(makeIoError(errno, "open " + path));
+         return false;
+      }
+
+      // Writes in flight and the source, until it terminates, refer to
+      // this state.
+      m_self = shared_from_this();
+      return true;
+   }
+
+   void onNext(const IoBuffer& buffer)
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_isTerminated || buffer.empty())
+      {
+         return;
+      }
+
+      auto& write = acquire();
+      write.m_buffer.assign(buffer.begin(), buffer.end());
+      write.m_fd = m_fd;
+      write.m_isWrite = true;
+      write.m_data = write.m_buffer.data();
+      write.m_length = write.m_buffer.size();
+      write.m_offset = m_offset;
+      write.m_handler = this;
+      m_offset += buffer.size();
+      ++m_inFlight;
+      ++m_queued;
+      m_io.queue(write);
+
+      // A batch is also handed over if nothing submitted is outstanding,
+      // since no completion would come along to flush it.
+      if (m_queued >= m_batchSize || m_inFlight == m_queued)
+      {
+         flush(lock);
+      }
+   }
+
+   void onCompleted()
+   {
+      std::shared_ptr<FileWriteState> released;
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_isSourceDone = true;
+      if (m_inFlight == 0)
+      {
+         released = finish();
+      }
+      flush(lock);
+   }
+
+   void onError(std::exception_ptr e)
+   {
+      std::shared_ptr<FileWriteState> released;
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_isSourceDone = true;
+      fail(e);
+      if (m_inFlight == 0)
+      {
+         released = std::move(m_self);
+      }
+      flush(lock);
+   }
+
+   void onIoCompleted(FileIo::Request& request, long result) override
+   {
+      std::shared_ptr<FileWriteState> released;
+      std::unique_lock<std::mutex> lock(m_mutex);
+      --m_inFlight;
+
+      if (result < 0)
+      {
+         fail(makeIoError(int(-result), "write"));
+      }
+      else if (std::size_t(result) != request.m_length)
+      {
+         fail(std::make_exception_ptr(std::runtime_error("short write")));
+      }
+      else
+      {
+         m_bytesWritten += std::uint64_t(result);
+      }
+      release(request);
+
+      if (m_isSourceDone && m_inFlight == 0)
+      {
+         released = finish();
+      }
+      flush(lock);
+   }
+
+private:
+   struct Write : FileIo::Request
+   {
+      IoBuffer m_buffer;
+   };
+
+   //! Must be called with m_mutex held, as must the members below.
+   Write& acquire()
+   {
+      if (m_free.empty())
+      {
+         m_writes.emplace_back(new Write());
+         return *m_writes.back();
+      }
+      auto write = m_free.back();
+      m_free.pop_back();
+      return *write;
+   }
+
+   void release(FileIo::Request& request)
+   {
+      m_free.push_back(&static_cast<Write&>(request));
+   }
+
+   //! Hands the queued writes to the kernel, after releasing lock as
+   //! refused writes complete within submit(). Once unlocked the last
+   //! write may complete and release this state.
+   void flush(std::unique_lock<std::mutex>& lock)
+   {
+      if (m_queued > 0)
+      {
+         m_queued = 0;
+         auto io = m_io;
+         lock.unlock();
+         io.submit();
+      }
+   }
+
+   void fail(std::exception_ptr e)
+   {
+      if (!m_isTerminated)
+      {
+         m_isTerminated = true;
+         m_observer.onError(e);
+      }
+   }
+
+   std::shared_ptr<FileWriteState> finish()
+   {
+      if (!m_isTerminated)
+      {
+         m_isTerminated = true;
+         m_observer.onNext(m_bytesWritten);
+         m_observer.onCompleted();
+      }
+      return std::move(m_self);
+   }
+
+   FileIo m_io;
+   Observer<std::uint64_t> m_observer;
+   const std::size_t m_batchSize;
+   int m_fd;
+
+   std::mutex m_mutex;
+   std::vector<std::unique_ptr<Write>> m_writes;
+   std::vector<Write*> m_free;
+   std::uint64_t m_offset;
+   std::uint64_t m_bytesWritten;
+   std::size_t m_queued;
+   std::size_t m_inFlight;
+   bool m_isSourceDone;
+   bool m_isTerminated;
+   std::shared_ptr<FileWriteState> m_self;
+};
+
+//! Writes every buffer of source to the file at path, one after the other,
+//! and emits the number of bytes written once all writes have completed.
+//! Buffers are copied into pooled write buffers; up to batchSize writes
+//! are handed to the kernel with a single submit.
+static Observable<std::uint64_t> writeFileAsync(Observable<IoBuffer> source,
+                                                std::string path,
+                                                std::size_t batchSize = 16,
+                                                FileIo io = FileIo::getDefault())
+{
+   return Observable<std::uint64_t>::create(
+         [source, path, batchSize, io](Subscriber<std::uint64_t> s){
+      auto state = std::make_shared<FileWriteState>(io, s.getObserver(), batchSize);
+      if (!state->open(path))
+      {
+         return;
+      }
+
+      s.add(source.subscribe(Observer<IoBuffer>(
+         // onNext
+         [state](const IoBuffer& buffer) {
+            state->onNext(buffer);
+         },
+         // onCompleted
+         [state]() {
+            state->onCompleted();
+         },
+         // onError
+         [state](std::exception_ptr e) {
+            state->onError(std::move(e));
+         })));
+   });
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "rx/Observable.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+
+//! Emits [begin, end) to o, checking for cancellation before every
+//! element, so nothing is emitted once the subscriber has unsubscribed.
+//! Contiguous ranges are walked by pointer. Returns false if cancelled.
+template<class T, class Iterator>
+bool emitFrom(Iterator begin, Iterator end, const Observer<T>& o,
+              const CancellationFlag& cancellation)
+{
+   if constexpr (std::contiguous_iterator<Iterator>)
+   {
+      auto p = std::to_address(begin);
+      const auto last = p + (end - begin);
+      for (; p != last; ++p)
+      {
+         if (cancellation.isCancelled())
+         {
+            return false;
+         }
+         o.onNext(*p);
+      }
+   }
+   else
+   {
+      for (; begin != end; ++begin)
+      {
+         if (cancellation.isCancelled())
+         {
+            return false;
+         }
+         o.onNext(*begin);
+      }
+   }
+   return true;
+}
+
+//! The iterators must stay valid for as long as the Observable is
+//! subscribed to.
+template<class Iterator,
+         class T = typename std::iterator_traits<Iterator>::value_type>
+Observable<T> from(Iterator begin, Iterator end)
+{
+   return Observable<T>::create([begin, end](Subscriber<T> s){
+      auto cancellation = CancellationFlag::create(s);
+      auto o = s.getObserver();
+      if (emitFrom(begin, end, o, cancellation))
+      {
+         o.onCompleted();
+      }
+   });
+}
+
+//! Copies an lvalue container, or takes over an rvalue container without
+//! copying its elements. The container is shared by every subscription.
+template<class Container,
+         class T = typename std::decay<Container>::type::value_type>
+Observable<T> from(Container&& container)
+{
+   typedef typename std::decay<Container>::type Stored;
+   auto shared_container = std::make_shared<const Stored>(
+         std::forward<Container>(container));
+
+   return Observable<T>::create([shared_container](Subscriber<T> s){
+      auto cancellation = CancellationFlag::create(s);
+      auto o = s.getObserver();
+      if (emitFrom(std::begin(*shared_container), std::end(*shared_container),
+                   o, cancellation))
+      {
+         o.onCompleted();
+      }
+   });
+}
+
+//! Emits a contiguous container as consecutive spans of at most batchSize
+//! elements, one onNext per span instead of per element. The spans point
+//! into the container, which the Observable keeps alive. Throws
+//! std::invalid_argument if batchSize is 0.
+template<class Container,
+         class T = typename std::decay<Container>::type::value_type>
+Observable<std::span<const T>> fromBatches(Container&& container,
+                                           std::size_t batchSize)
+{
+   typedef typename std::decay<Container>::type Stored;
+   static_assert(std::contiguous_iterator<typename Stored::const_iterator>,
+                 "fromBatches requires a contiguous container");
+
+   if (batchSize == 0)
+   {
+      throw std::invalid_argument("batchSize must not be 0");
+   }
+
+   auto shared_container = std::make_shared<const Stored>(
+         std::forward<Container>(container));
+
+   return Observable<std::span<const T>>::create(
+         [shared_container, batchSize](Subscriber<std::span<const T>> s){
+      auto cancellation = CancellationFlag::create(s);
+      auto o = s.getObserver();
+      std::span<const T> all(std::data(*shared_container),
+                             std::size(*shared_container));
+
+      for (std::size_t i = 0; i < all.size(); i += batchSize)
+      {
+         if (cancellation.isCancelled())
+         {
+            return;
+         }
+         o.onNext(all.subspan(i, std::min(batchSize, all.size() - i)));
+      }
+      o.onCompleted();
+   });
+}
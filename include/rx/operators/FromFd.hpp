@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "rx/Observable.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+#include "rx/schedulers/EpollScheduler.hpp"
+
+enum class FdMode
+{
+   //! Emits the ready epoll events only; the observer does the I/O and
+   //! must consume everything that is ready.
+   READINESS,
+
+   //! Reads until the fd would block, emitting every chunk read. Completes
+   //! at end of file.
+   READ
+};
+
+struct FdEvent
+{
+   std::uint32_t m_events;
+
+   //! The chunk read in FdMode::READ, pointing into a buffer that is
+   //! reused for the next chunk. Empty in FdMode::READINESS.
+   std::string_view m_data;
+};
+
+//! Size of the buffer every subscription in FdMode::READ reads into.
+static const std::size_t FROM_FD_BUFFER_SIZE = 64 * 1024;
+
+//! Returns false once fd has reached end of file, or failed with error.
+//! The observer is only told once fd has been removed from the epoll set,
+//! since it may close fd right away.
+static bool onFdReadable(int fd, std::uint32_t events, std::vector<char>& buffer,
+                         const Observer<FdEvent>& o,
+                         const CancellationFlag& cancellation,
+                         std::exception_ptr& error)
+{
+   // Edge-triggered: the fd is not reported again until it has been
+   // drained, so read until it would block.
+   while (!cancellation.isCancelled())
+   {
+      auto count = ::read(fd, buffer.data(), buffer.size());
+      if (count > 0)
+      {
+         o.onNext(FdEvent{ events, std::string_view(buffer.data(), count) });
+      }
+      else if (count == 0)
+      {
+         return false;
+      }
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+         return true;
+      }
+      else if (errno != EINTR)
+      {
+         error = std::make_exception_ptr(
+               std::system_error(errno, std::generic_category(), "read"));
+         return false;
+      }
+   }
+   return false;
+}
+
+//! Emits on the scheduler's loop thread whenever fd becomes readable. In
+//! FdMode::READ fd is switched to non-blocking mode. fd is not closed when
+//! the subscription ends.
+static OnSubscribeFunc<FdEvent> onSubscribeFd(int fd, FdMode mode,
+                                              EpollScheduler scheduler)
+{
+   return [fd, mode, scheduler](Subscriber<FdEvent> s){
+      auto o = s.getObserver();
+      auto cancellation = CancellationFlag::create(s);
+      EpollScheduler::FdHandler handler;
+      std::function<void()> onStopped;
+
+      if (mode == FdMode::READ)
+      {
+         fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+         auto buffer = std::make_shared<std::vector<char>>(FROM_FD_BUFFER_SIZE);
+         auto error = std::make_shared<std::exception_ptr>();
+         handler = [fd, buffer, o, cancellation, error](std::uint32_t events) {
+            return onFdReadable(fd, events, *buffer, o, cancellation, *error);
+         };
+         onStopped = [o, cancellation, error]() {
+            if (cancellation.isCancelled())
+            {
+               return;
+            }
+            if (*error)
+            {
+               o.onError(*error);
+            }
+            else
+            {
+               o.onCompleted();
+            }
+         };
+      }
+      else
+      {
+         handler = [o, cancellation](std::uint32_t events) {
+            if (cancellation.isCancelled())
+            {
+               return false;
+            }
+            o.onNext(FdEvent{ events, std::string_view() });
+            return true;
+         };
+      }
+
+      try
+      {
+         s.add(scheduler.watch(fd, EPOLLIN | EPOLLRDHUP, std::move(handler),
+                               std::move(onStopped)));
+      }
+      catch (...)
+      {
+         o.onError(std::current_exception());
+      }
+   };
+}
+
+static Observable<FdEvent> fromFd(int fd, FdMode mode,
+                                  EpollScheduler scheduler = EpollScheduler::getDefault())
+{
+   return Observable<FdEvent>::create(onSubscribeFd(fd, mode, scheduler));
+}
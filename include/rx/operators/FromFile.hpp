@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rx/Observable.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+#include "rx/internal/MappedFile.hpp"
+
+//! The file is processed in chunks of this many bytes: the chunk after the
+//! current one is prefetched, and cancellation is checked once per chunk.
+static const std::size_t FROM_FILE_CHUNK_SIZE = 1 << 20;
+
+//! Splits a file into lines, without their '\n'. A last line that does not
+//! end in '\n' is emitted too.
+struct LineSplitter
+{
+   bool next(std::string_view data, std::size_t& offset,
+             std::string_view& record) const
+   {
+      if (offset >= data.size())
+      {
+         return false;
+      }
+
+      auto begin = data.data() + offset;
+      auto size = data.size() - offset;
+      auto newline = static_cast<const char*>(std::memchr(begin, '\n', size));
+      if (newline)
+      {
+         size = std::size_t(newline - begin);
+         offset += size + 1;
+      }
+      else
+      {
+         offset += size;
+      }
+      record = std::string_view(begin, size);
+      return true;
+   }
+};
+
+//! Splits a file into records of recordSize bytes. A truncated last record
+//! is an error.
+struct FixedSizeSplitter
+{
+   explicit FixedSizeSplitter(std::size_t recordSize)
+         : m_recordSize(recordSize)
+   {
+      if (recordSize == 0)
+      {
+         throw std::invalid_argument("recordSize must not be 0");
+      }
+   }
+
+   bool next(std::string_view data, std::size_t& offset,
+             std::string_view& record) const
+   {
+      if (offset >= data.size())
+      {
+         return false;
+      }
+      if (data.size() - offset < m_recordSize)
+      {
+         throw std::runtime_error("truncated record");
+      }
+
+      record = data.substr(offset, m_recordSize);
+      offset += m_recordSize;
+      return true;
+   }
+
+   std::size_t m_recordSize;
+};
+
+//! Splits a file into records that each start with their length as a
+//! std::uint32_t in host byte order. The emitted record excludes the
+//! length. A truncated last record is an error.
+struct LengthPrefixedSplitter
+{
+   bool next(std::string_view data, std::size_t& offset,
+             std::string_view& record) const
+   {
+      if (offset >= data.size())
+      {
+         return false;
+      }
+
+      std::uint32_t length;
+      if (data.size() - offset < sizeof(length))
+      {
+         throw std::runtime_error("truncated record");
+      }
+      std::memcpy(&length, data.data() + offset, sizeof(length));
+      offset += sizeof(length);
+
+      if (data.size() - offset < length)
+      {
+         throw std::runtime_error("truncated record");
+      }
+      record = data.substr(offset, length);
+      offset += length;
+      return true;
+   }
+};
+
+//! Maps the file at path and passes its records to onBatch, one chunk's
+//! worth at a time, through a vector that is reused for every chunk.
+//! Returns false if cancelled.
+template<class Splitter, class OnBatch>
+bool forEachMappedBatch(const MappedFile& file, const Splitter& splitter,
+                        const CancellationFlag& cancellation, OnBatch onBatch)
+{
+   auto data = file.data();
+   file.adviseSequential();
+   file.prefetch(0, FROM_FILE_CHUNK_SIZE);
+
+   std::vector<std::string_view> batch;
+   std::size_t offset = 0;
+   std::string_view record;
+
+   while (offset < data.size())
+   {
+      if (cancellation.isCancelled())
+      {
+         return false;
+      }
+
+      auto chunkEnd = offset + FROM_FILE_CHUNK_SIZE;
+      file.prefetch(chunkEnd, FROM_FILE_CHUNK_SIZE);
+
+      // A record that straddles the chunk end belongs to this chunk. The
+      // records before a malformed one are still emitted.
+      batch.clear();
+      try
+      {
+         while (offset < chunkEnd && splitter.next(data, offset, record))
+         {
+            batch.push_back(record);
+         }
+      }
+      catch (...)
+      {
+         onBatch(std::span<const std::string_view>(batch));
+         throw;
+      }
+      onBatch(std::span<const std::string_view>(batch));
+   }
+   return true;
+}
+
+//! Opens the file on subscribe and keeps it mapped until the subscription
+//! ends, so the emitted views are only valid until then.
+template<class Splitter, class Emit>
+OnSubscribeFunc<typename Emit::ValueType> onSubscribeMappedFile(
+      std::string path, Splitter splitter, Emit emit)
+{
+   typedef typename Emit::ValueType T;
+
+   return [path, splitter, emit](Subscriber<T> s){
+      auto o = s.getObserver();
+      try
+      {
+         auto file = MappedFile::open(path);
+         s.add(Subscription([file]() {}));
+
+         auto cancellation = CancellationFlag::create(s);
+         if (forEachMappedBatch(*file, splitter, cancellation,
+               [&o, &emit](std::span<const std::string_view> batch) {
+                  emit(o, batch);
+               }))
+         {
+            o.onCompleted();
+         }
+      }
+      catch (...)
+      {
+         o.onError(std::current_exception());
+      }
+   };
+}
+
+struct EmitRecords
+{
+   typedef std::string_view ValueType;
+
+   void operator()(const Observer<ValueType>& o,
+                   std::span<const std::string_view> batch) const
+   {
+      for (const auto& record : batch)
+      {
+         o.onNext(record);
+      }
+   }
+};
+
+struct EmitBatches
+{
+   typedef std::span<const std::string_view> ValueType;
+
+   void operator()(const Observer<ValueType>& o,
+                   std::span<const std::string_view> batch) const
+   {
+      if (!batch.empty())
+      {
+         o.onNext(batch);
+      }
+   }
+};
+
+//! Emits every record of the memory-mapped file at path as a view into the
+//! mapping.
+template<class Splitter>
+Observable<std::string_view> fromFile(std::string path, Splitter splitter)
+{
+   return Observable<std::string_view>::create(
+         onSubscribeMappedFile(std::move(path), std::move(splitter),
+                               EmitRecords()));
+}
+
+//! Like fromFile, but emits the records of every chunk as one span.
+template<class Splitter>
+Observable<std::span<const std::string_view>> fromFileBatches(std::string path,
+                                                              Splitter splitter)
+{
+   return Observable<std::span<const std::string_view>>::create(
+         onSubscribeMappedFile(std::move(path), std::move(splitter),
+                               EmitBatches()));
+}
+
+static Observable<std::string_view> fromFileLines(std::string path)
+{
+   return fromFile(std::move(path), LineSplitter());
+}
+
+static Observable<std::string_view> fromFileRecords(std::string path,
+                                                    std::size_t recordSize)
+{
+   return fromFile(std::move(path), FixedSizeSplitter(recordSize));
+}
+
+static Observable<std::string_view> fromFileLengthPrefixed(std::string path)
+{
+   return fromFile(std::move(path), LengthPrefixedSplitter());
+}
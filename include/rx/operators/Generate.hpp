@@ -0,0 +1,83 @@
+#pragma once
+
+#include <exception>
+
+#include "rx/Observable.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+
+//! Passed to the step function of generate(). A step emits at most one
+//! element, or terminates the sequence.
+template<class T>
+class GenerateEmitter
+{
+public:
+   explicit GenerateEmitter(Observer<T> observer)
+         : m_observer(std::move(observer)),
+           m_isDone(false)
+   {
+   }
+
+   void onNext(const T& t) const
+   {
+      m_observer.onNext(t);
+   }
+
+   void onCompleted()
+   {
+      m_isDone = true;
+      m_observer.onCompleted();
+   }
+
+   void onError(std::exception_ptr e)
+   {
+      m_isDone = true;
+      m_observer.onError(e);
+   }
+
+   bool isDone() const
+   {
+      return m_isDone;
+   }
+
+private:
+   Observer<T> m_observer;
+   bool m_isDone;
+};
+
+//! The state is a local of the subscribing call, so every subscription
+//! starts over from a copy of initialState. step is not called again once
+//! it has terminated the sequence or the subscriber has unsubscribed, so
+//! nothing is computed that would only be dropped.
+template<class T, class S, class Step>
+OnSubscribeFunc<T> onSubscribeGenerate(S initialState, Step step)
+{
+   return [initialState, step](Subscriber<T> s){
+      auto cancellation = CancellationFlag::create(s);
+      GenerateEmitter<T> emitter(s.getObserver());
+      S state = initialState;
+
+      try
+      {
+         while (!emitter.isDone() && !cancellation.isCancelled())
+         {
+            step(state, emitter);
+         }
+      }
+      catch (...)
+      {
+         if (!emitter.isDone())
+         {
+            emitter.onError(std::current_exception());
+         }
+      }
+   };
+}
+
+//! Creates an Observable that calls step(state, emitter) for every element,
+//! where state starts out as initialState and may be modified by step.
+template<class T, class S, class Step>
+Observable<T> generate(S initialState, Step step)
+{
+   return Observable<T>::create(onSubscribeGenerate<T>(std::move(initialState),
+                                                       std::move(step)));
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rx/Observer.hpp"
+#include "rx/internal/FlatHashMap.hpp"
+
+template<class K, class T>
+class GroupedObservable;
+
+template<class T>
+class UnicastSubject;
+
+template<class T, class K, class KeySelector>
+struct GroupByState : std::enable_shared_from_this<GroupByState<T, K, KeySelector>>
+{
+   GroupByState(Observer<GroupedObservable<K, T>> observer, KeySelector keySelector)
+         : m_observer(std::move(observer)),
+           m_keySelector(std::move(keySelector)),
+           m_hasCancelled(false)
+   {
+   }
+
+   //! Returns the live group for key, opening and emitting a new group if
+   //! there is none or the previous one has been unsubscribed.
+   UnicastSubject<T>& route(const K& key)
+   {
+      if (m_hasCancelled.load(std::memory_order_acquire))
+      {
+         eraseCancelled();
+      }
+
+      bool isCreated = false;
+      auto& group = m_groups.findOrCreate(key, [this, &key]() {
+         return openGroup(key);
+      }, isCreated);
+
+      if (!isCreated && group.isCancelled())
+      {
+         group = openGroup(key);
+         isCreated = true;
+      }
+
+      if (isCreated)
+      {
+         m_observer.onNext(GroupedObservable<K, T>(key, group));
+      }
+      return group;
+   }
+
+   //! Groups may be unsubscribed from any thread, so they only queue their
+   //! key; route() erases them from the table before its next lookup.
+   UnicastSubject<T> openGroup(const K& key)
+   {
+      std::weak_ptr<GroupByState> weak_state = this->shared_from_this();
+      return UnicastSubject<T>::create([weak_state, key]() {
+         if (auto shared_state = weak_state.lock())
+         {
+            std::lock_guard<std::mutex> lock(shared_state->m_cancelledMutex);
+            shared_state->m_cancelled.push_back(key);
+            shared_state->m_hasCancelled.store(true, std::memory_order_release);
+         }
+      });
+   }
+
+   void eraseCancelled()
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_cancelledMutex);
+         m_erasing.swap(m_cancelled);
+         m_hasCancelled.store(false, std::memory_order_relaxed);
+      }
+
+      for (auto& key : m_erasing)
+      {
+         // The key may have been reopened since it was queued.
+         auto group = m_groups.find(key);
+         if (group != nullptr && group->isCancelled())
+         {
+            m_groups.erase(key);
+         }
+      }
+      m_erasing.clear();
+   }
+
+   Observer<GroupedObservable<K, T>> m_observer;
+   KeySelector m_keySelector;
+   FlatHashMap<K, UnicastSubject<T>> m_groups;
+   std::mutex m_cancelledMutex;
+   std::vector<K> m_cancelled;
+   std::vector<K> m_erasing;
+   std::atomic<bool> m_hasCancelled;
+};
+
+//! Routes every element to the group of its key. Groups are kept in a flat
+//! open addressing table, so routing an element costs one hash and one
+//! probe, and unsubscribed groups are erased from it one by one.
+template<class T, class K, class KeySelector>
+Observer<T> createOperatorGroupBy(Observer<GroupedObservable<K, T>> o,
+                                  KeySelector keySelector)
+{
+   auto state = std::make_shared<GroupByState<T, K, KeySelector>>(
+         std::move(o), std::move(keySelector));
+
+   return Observer<T>(
+      // onNext
+      [state](const T& t) {
+         state->route(state->m_keySelector(t)).onNext(t);
+      },
+      // onCompleted
+      [state]() {
+         state->m_groups.forEach([](const K&, UnicastSubject<T>& group) {
+            group.onCompleted();
+         });
+         state->m_groups.clear();
+         state->m_observer.onCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         state->m_groups.forEach([e](const K&, UnicastSubject<T>& group) {
+            group.onError(e);
+         });
+         state->m_groups.clear();
+         state->m_observer.onError(e);
+      });
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "rx/Observable.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/schedulers/TimingWheelScheduler.hpp"
+
+static OnSubscribeFunc<long> onSubscribeInterval(Scheduler::Duration initialDelay,
+                                                 Scheduler::Duration period,
+                                                 Scheduler scheduler)
+{
+   return [initialDelay, period, scheduler](Subscriber<long> s){
+      auto o = s.getObserver();
+      long count = 0;
+      s.add(scheduler.schedulePeriodically(
+            scheduler.now() + initialDelay, period,
+            [o, count]() mutable {
+               o.onNext(count++);
+            }));
+   };
+}
+
+static OnSubscribeFunc<long> onSubscribeTimer(Scheduler::Duration delay,
+                                              Scheduler scheduler)
+{
+   return [delay, scheduler](Subscriber<long> s){
+      auto o = s.getObserver();
+      s.add(scheduler.schedule(scheduler.now() + delay, [o]() {
+         o.onNext(0);
+         o.onCompleted();
+      }));
+   };
+}
+
+//! Emits 0, 1, 2, ... every period, starting one period after subscribe.
+static Observable<long> interval(Scheduler::Duration period,
+                                 Scheduler scheduler = TimingWheelScheduler::getDefault())
+{
+   return Observable<long>::create(onSubscribeInterval(period, period, scheduler));
+}
+
+//! Emits 0 once after delay and completes.
+static Observable<long> timer(Scheduler::Duration delay,
+                              Scheduler scheduler = TimingWheelScheduler::getDefault())
+{
+   return Observable<long>::create(onSubscribeTimer(delay, scheduler));
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+#include "rx/internal/Optional.hpp"
+
+//! Runs the transformer of mapConcurrent() on a scheduler and emits the
+//! results in the order of the source.
+//!
+//! Element n is assigned slot n % maxInFlight of a fixed ring. The task
+//! that transforms it writes the result into that slot, publishes it with
+//! a release store of the slot's flag and then runs the drain loop, which
+//! is serialized by a work-in-progress counter and emits from the head of
+//! the ring for as long as the head slot is complete. No lock is taken on
+//! this path. A slot is only handed out again once the drain loop has
+//! emptied it, so the upstream thread waits while maxInFlight elements are
+//! in flight and memory stays flat however fast the source is.
+template<class T, class R, class Callable>
+class MapConcurrentState
+      : public std::enable_shared_from_this<MapConcurrentState<T, R, Callable>>
+{
+public:
+   MapConcurrentState(Callable transformer, std::size_t maxInFlight,
+                      Scheduler scheduler, Subscriber<R> subscriber)
+         : m_transformer(std::move(transformer)),
+           m_scheduler(std::move(scheduler)),
+           m_observer(subscriber.getObserver()),
+           m_cancellation(CancellationFlag::create(subscriber)),
+           m_slots(maxInFlight == 0 ? 1 : maxInFlight),
+           m_submitted(0),
+           m_head(0),
+           m_signal(0),
+           m_wip(0),
+           m_isUpstreamDone(false),
+           m_isTerminated(false)
+   {
+   }
+
+   //! Must be called once, right after construction.
+   void init(Subscriber<R> subscriber)
+   {
+      std::weak_ptr<MapConcurrentState> weak_state = this->shared_from_this();
+      subscriber.add(Subscription([weak_state]() {
+         if (auto shared_state = weak_state.lock())
+         {
+            shared_state->signal();
+         }
+      }));
+   }
+
+   void onNext(const T& t)
+   {
+      auto sequence = m_submitted.load(std::memory_order_relaxed);
+      if (!waitForSlot(sequence))
+      {
+         return;
+      }
+
+      auto shared_state = this->shared_from_this();
+      m_submitted.store(sequence + 1, std::memory_order_release);
+      m_scheduler.schedule([shared_state, sequence, t]() {
+         shared_state->transform(sequence, t);
+      });
+   }
+
+   void onCompleted()
+   {
+      m_isUpstreamDone.store(true, std::memory_order_release);
+      drain();
+   }
+
+   void onError(std::exception_ptr e)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_errorMutex);
+         m_upstreamError = e;
+      }
+      m_isUpstreamDone.store(true, std::memory_order_release);
+      drain();
+   }
+
+private:
+   struct Slot
+   {
+      Slot()
+            : m_isComplete(false)
+      {
+      }
+
+      std::atomic<bool> m_isComplete;
+      Optional<R> m_value;
+      std::exception_ptr m_error;
+   };
+
+   Slot& slotOf(std::uint64_t sequence)
+   {
+      return m_slots[sequence % m_slots.size()];
+   }
+
+   //! Blocks the upstream thread while the ring is full. Returns false once
+   //! the subscriber has unsubscribed or the stream has terminated.
+   bool waitForSlot(std::uint64_t sequence)
+   {
+      for (;;)
+      {
+         if (m_cancellation.isCancelled()
+             || m_isTerminated.load(std::memory_order_acquire))
+         {
+            return false;
+         }
+         auto signal = m_signal.load(std::memory_order_acquire);
+         if (sequence - m_head.load(std::memory_order_acquire) < m_slots.size())
+         {
+            return true;
+         }
+         m_signal.wait(signal, std::memory_order_acquire);
+      }
+   }
+
+   void signal()
+   {
+      m_signal.fetch_add(1, std::memory_order_release);
+      m_signal.notify_one();
+   }
+
+   void transform(std::uint64_t sequence, const T& t)
+   {
+      auto& slot = slotOf(sequence);
+      if (!m_cancellation.isCancelled())
+      {
+         try
+         {
+            slot.m_value.set(m_transformer(t));
+         }
+         catch (...)
+         {
+            slot.m_error = std::current_exception();
+         }
+      }
+      slot.m_isComplete.store(true, std::memory_order_release);
+      drain();
+   }
+
+   void drain()
+   {
+      if (m_wip.fetch_add(1, std::memory_order_acq_rel) != 0)
+      {
+         return;
+      }
+
+      int missed = 1;
+      for (;;)
+      {
+         while (!m_isTerminated.load(std::memory_order_relaxed)
+                && !m_cancellation.isCancelled())
+         {
+            // Read before the head slot, so that a completion seen here
+            // means no element is left behind it.
+            bool isUpstreamDone = m_isUpstreamDone.load(std::memory_order_acquire);
+            auto head = m_head.load(std::memory_order_relaxed);
+            auto& slot = slotOf(head);
+
+            if (!slot.m_isComplete.load(std::memory_order_acquire))
+            {
+               if (isUpstreamDone
+                   && head == m_submitted.load(std::memory_order_acquire))
+               {
+                  terminate();
+               }
+               break;
+            }
+
+            if (slot.m_error)
+            {
+               auto e = slot.m_error;
+               setTerminated();
+               m_observer.onError(e);
+               break;
+            }
+
+            // Left empty by a task that found the subscriber gone.
+            if (!slot.m_value.hasValue())
+            {
+               break;
+            }
+
+            auto value = slot.m_value.take();
+            slot.m_isComplete.store(false, std::memory_order_relaxed);
+            m_head.store(head + 1, std::memory_order_release);
+            signal();
+
+            m_observer.onNext(value);
+         }
+
+         missed = m_wip.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+         if (missed == 0)
+         {
+            break;
+         }
+      }
+   }
+
+   void setTerminated()
+   {
+      m_isTerminated.store(true, std::memory_order_release);
+      signal();
+   }
+
+   void terminate()
+   {
+      std::exception_ptr e;
+      {
+         std::lock_guard<std::mutex> lock(m_errorMutex);
+         e = m_upstreamError;
+      }
+      setTerminated();
+      if (e)
+      {
+         m_observer.onError(e);
+      }
+      else
+      {
+         m_observer.onCompleted();
+      }
+   }
+
+   Callable m_transformer;
+   Scheduler m_scheduler;
+   Observer<R> m_observer;
+   CancellationFlag m_cancellation;
+   std::vector<Slot> m_slots;
+
+   //! Written by the upstream thread only.
+   std::atomic<std::uint64_t> m_submitted;
+   //! Written by the drain loop only.
+   std::atomic<std::uint64_t> m_head;
+   std::atomic<std::uint32_t> m_signal;
+
+   std::atomic<int> m_wip;
+   std::atomic<bool> m_isUpstreamDone;
+   std::atomic<bool> m_isTerminated;
+   std::mutex m_errorMutex;
+   std::exception_ptr m_upstreamError;
+};
+
+template<class T, class R, class Callable>
+Subscriber<T> createOperatorMapConcurrent(Subscriber<R> subscriber,
+                                          Callable transformer,
+                                          std::size_t maxInFlight,
+                                          Scheduler scheduler)
+{
+   auto state = std::make_shared<MapConcurrentState<T, R, Callable>>(
+         std::move(transformer), maxInFlight, std::move(scheduler), subscriber);
+   state->init(subscriber);
+
+   auto parent = Subscriber<T>(Observer<T>(
+      // onNext
+      [state](const T& t) {
+         state->onNext(t);
+      },
+      // onCompleted
+      [state]() {
+         state->onCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         state->onError(std::move(e));
+      }));
+
+   subscriber.add(parent.getSubscription());
+   return parent;
+}
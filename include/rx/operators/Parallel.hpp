@@ -0,0 +1,623 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/CancellationFlag.hpp"
+#include "rx/internal/Optional.hpp"
+#include "rx/internal/SpscRingBuffer.hpp"
+
+template<class S, class T>
+class ParallelObservable;
+
+//! Elements a rail runs through the chain before it passes the results
+//! on to the merge loop.
+static const std::size_t PARALLEL_BATCH_SIZE = 64;
+
+//! Batches that may be queued on either side of a rail.
+static const std::size_t PARALLEL_QUEUE_CAPACITY = 16;
+
+//! Passes batches of U from one thread to another and the emptied vectors
+//! back, so that batches are only allocated while the stream warms up.
+template<class U>
+class BatchChannel
+{
+public:
+   explicit BatchChannel(std::size_t capacity)
+         : m_batches(capacity),
+           m_recycled(capacity + 2)
+   {
+   }
+
+   //! Sending side. Returns an empty batch.
+   std::vector<U> acquire()
+   {
+      std::vector<U> batch;
+      if (!m_recycled.poll(batch))
+      {
+         batch.reserve(PARALLEL_BATCH_SIZE);
+      }
+      return batch;
+   }
+
+   //! Sending side. Leaves batch alone and returns false if the channel is
+   //! full.
+   bool offer(std::vector<U>& batch)
+   {
+      return m_batches.offer(std::move(batch));
+   }
+
+   //! Either side; exact only when the other side is idle.
+   bool isFull() const
+   {
+      return m_batches.size() >= m_batches.capacity();
+   }
+
+   //! Receiving side.
+   bool poll(std::vector<U>& batch)
+   {
+      return m_batches.poll(batch);
+   }
+
+   //! Receiving side. Hands a batch that has been consumed back.
+   void recycle(std::vector<U>& batch)
+   {
+      batch.clear();
+      m_recycled.offer(std::move(batch));
+   }
+
+private:
+   SpscRingBuffer<std::vector<U>> m_batches;
+   SpscRingBuffer<std::vector<U>> m_recycled;
+};
+
+//! Runs the rails of a ParallelObservable for one subscription.
+//!
+//! The upstream thread distributes the source elements over the rails,
+//! round-robin or by key, through one single producer, single consumer
+//! ring per rail, without locking. A rail is not a thread but a task on
+//! the scheduler that is started when its ring receives an element while
+//! it is not running, takes the elements in batches, runs the map and
+//! filter chain over them and passes the results on in batches through
+//! another channel to the merge loop. Any rail task runs the merge loop
+//! once it has delivered a batch, serialized by a work-in-progress
+//! counter. In ordered mode rails pass on an empty slot for every filtered
+//! element and the merge loop takes one slot from each rail in turn, which
+//! restores the order of the round-robin distribution.
+//!
+//! A rail task that finds its output channel full ends, and the merge loop
+//! starts it again once it has taken a batch from it, so no thread of the
+//! scheduler ever waits for another. The upstream thread waits on a futex
+//! while a rail's ring is full, so the memory used is bounded; nothing is
+//! ever dropped. The source must therefore not emit on the scheduler.
+template<class S, class T>
+class ParallelState : public std::enable_shared_from_this<ParallelState<S, T>>
+{
+public:
+   typedef std::function<void(const S&, Optional<T>&)> Chain;
+   typedef std::function<std::size_t(const S&)> Router;
+
+   ParallelState(std::size_t railCount, Router router, Chain chain, bool isOrdered,
+                 Scheduler scheduler, Subscriber<T> subscriber)
+         : m_router(std::move(router)),
+           m_chain(std::move(chain)),
+           m_isOrdered(isOrdered),
+           m_scheduler(std::move(scheduler)),
+           m_observer(subscriber.getObserver()),
+           m_cancellation(CancellationFlag::create(subscriber)),
+           m_nextInputRail(0),
+           m_nextOutputRail(0),
+           m_wip(0),
+           m_isFailed(false),
+           m_isTerminated(false)
+   {
+      for (std::size_t i = 0; i < railCount; ++i)
+      {
+         m_rails.push_back(std::unique_ptr<Rail>(new Rail()));
+      }
+   }
+
+   //! Must be called once, right after construction.
+   void start(Subscriber<T> subscriber)
+   {
+      std::weak_ptr<ParallelState> weak_state = this->shared_from_this();
+      subscriber.add(Subscription([weak_state]() {
+         if (auto shared_state = weak_state.lock())
+         {
+            shared_state->signalUpstream();
+         }
+      }));
+   }
+
+   void onNext(const S& s)
+   {
+      if (isStopped())
+      {
+         return;
+      }
+
+      std::size_t index;
+      if (m_router)
+      {
+         index = m_router(s) % m_rails.size();
+      }
+      else
+      {
+         index = m_nextInputRail;
+         m_nextInputRail = (m_nextInputRail + 1) % m_rails.size();
+      }
+
+      auto& rail = *m_rails[index];
+      if (!rail.m_input.offer(s) && !waitAndOffer(rail, s))
+      {
+         return;
+      }
+      resume(rail);
+   }
+
+   void onCompleted()
+   {
+      finishInput();
+   }
+
+   void onError(std::exception_ptr e)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_errorMutex);
+         m_upstreamError = e;
+      }
+      finishInput();
+   }
+
+private:
+   struct Rail
+   {
+      Rail()
+            : m_input(PARALLEL_BATCH_SIZE * PARALLEL_QUEUE_CAPACITY),
+              m_output(PARALLEL_QUEUE_CAPACITY),
+              m_position(0),
+              m_isDone(false),
+              m_isFinished(false),
+              m_isRunning(false),
+              m_isBlocked(false),
+              m_signal(0)
+      {
+      }
+
+      // Upstream thread to rail task.
+      SpscRingBuffer<S> m_input;
+
+      // Rail task to merge loop.
+      BatchChannel<Optional<T>> m_output;
+      std::vector<Optional<T>> m_unsent;
+      std::vector<Optional<T>> m_current;
+      std::size_t m_position;
+
+      std::atomic<bool> m_isDone;
+      std::atomic<bool> m_isFinished;
+      //! Set while a task of the rail is scheduled or running.
+      std::atomic<bool> m_isRunning;
+      //! Whether the task ended on a full output channel.
+      std::atomic<bool> m_isBlocked;
+      //! Bumped whenever the rail has made room in its input.
+      std::atomic<std::uint32_t> m_signal;
+   };
+
+   bool isStopped() const
+   {
+      return m_cancellation.isCancelled()
+             || m_isFailed.load(std::memory_order_acquire);
+   }
+
+   void signalUpstream()
+   {
+      for (auto& rail : m_rails)
+      {
+         signal(*rail);
+      }
+   }
+
+   static void signal(Rail& rail)
+   {
+      rail.m_signal.fetch_add(1, std::memory_order_release);
+      rail.m_signal.notify_one();
+   }
+
+   //! Parks the upstream thread until the rail has made room for s.
+   //! Returns false once the stream has failed or been cancelled.
+   bool waitAndOffer(Rail& rail, const S& s)
+   {
+      for (;;)
+      {
+         auto signal = rail.m_signal.load(std::memory_order_acquire);
+         if (rail.m_input.offer(s))
+         {
+            return true;
+         }
+         if (isStopped())
+         {
+            return false;
+         }
+         rail.m_signal.wait(signal, std::memory_order_acquire);
+      }
+   }
+
+   //! Called after giving the rail something to do: an element, the end of
+   //! the input or room in its output. The fence pairs with the one in
+   //! pause(), so either the rail task sees the change or we see that it
+   //! is no longer running.
+   void resume(Rail& rail)
+   {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!rail.m_isRunning.load(std::memory_order_relaxed))
+      {
+         start(rail);
+      }
+   }
+
+   void start(Rail& rail)
+   {
+      if (!rail.m_isRunning.exchange(true, std::memory_order_acq_rel))
+      {
+         auto shared_state = this->shared_from_this();
+         auto r = &rail;
+         m_scheduler.schedule([shared_state, r]() {
+            shared_state->run(*r);
+         });
+      }
+   }
+
+   void finishInput()
+   {
+      for (auto& rail : m_rails)
+      {
+         rail->m_isDone.store(true, std::memory_order_release);
+         resume(*rail);
+      }
+   }
+
+   //! The rail task. A rail that has finished or whose stream has stopped
+   //! stays marked as running, so that it is never started again.
+   void run(Rail& rail)
+   {
+      while (!isStopped())
+      {
+         // Read before looking at the input, so that no element can follow.
+         bool isDone = rail.m_isDone.load(std::memory_order_acquire);
+
+         if (!send(rail))
+         {
+            if (pause(rail, true))
+            {
+               continue;
+            }
+            return;
+         }
+
+         if (!rail.m_input.isEmpty())
+         {
+            if (!process(rail))
+            {
+               return;
+            }
+            continue;
+         }
+
+         if (isDone)
+         {
+            rail.m_isFinished.store(true, std::memory_order_release);
+            drain();
+            return;
+         }
+
+         if (!pause(rail, false))
+         {
+            return;
+         }
+      }
+   }
+
+   //! Marks the rail as not running. Another task may be started for it
+   //! from then on, so the rail state is only looked at, not changed.
+   //! Returns true if the rail must go on after all and could mark itself
+   //! as running again.
+   bool pause(Rail& rail, bool isBlocked)
+   {
+      rail.m_isBlocked.store(isBlocked, std::memory_order_relaxed);
+      rail.m_isRunning.store(false, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      bool isRunnable = isBlocked
+            ? !rail.m_output.isFull()
+            : !rail.m_input.isEmpty() || rail.m_isDone.load(std::memory_order_acquire);
+      return isRunnable && !rail.m_isRunning.exchange(true, std::memory_order_acq_rel);
+   }
+
+   //! Runs the chain over a batch of the rail's input. Returns false once
+   //! the stream has failed.
+   bool process(Rail& rail)
+   {
+      // An empty batch is kept for the next one rather than recycled, as
+      // only the merge loop hands batches back.
+      auto& results = rail.m_unsent;
+      if (results.capacity() == 0)
+      {
+         results = rail.m_output.acquire();
+      }
+      try
+      {
+         for (std::size_t i = 0; i < PARALLEL_BATCH_SIZE && !rail.m_input.isEmpty(); ++i)
+         {
+            results.emplace_back();
+            m_chain(rail.m_input.front(), results.back());
+            rail.m_input.pop();
+            if (!m_isOrdered && !results.back().hasValue())
+            {
+               results.pop_back();
+            }
+         }
+      }
+      catch (...)
+      {
+         fail(std::current_exception());
+         return false;
+      }
+      signal(rail);
+      return true;
+   }
+
+   //! Queues the rail's results for the merge loop. Returns false if its
+   //! output channel is full.
+   bool send(Rail& rail)
+   {
+      if (rail.m_unsent.empty())
+      {
+         return true;
+      }
+      if (!rail.m_output.offer(rail.m_unsent))
+      {
+         return false;
+      }
+      rail.m_unsent.clear();
+      drain();
+      return true;
+   }
+
+   void fail(std::exception_ptr e)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_errorMutex);
+         if (!m_error)
+         {
+            m_error = e;
+         }
+      }
+      m_isFailed.store(true, std::memory_order_release);
+      signalUpstream();
+      drain();
+   }
+
+   void drain()
+   {
+      if (m_wip.fetch_add(1, std::memory_order_acq_rel) != 0)
+      {
+         return;
+      }
+
+      int missed = 1;
+      for (;;)
+      {
+         if (!m_isTerminated)
+         {
+            if (m_isOrdered)
+            {
+               drainOrdered();
+            }
+            else
+            {
+               drainUnordered();
+            }
+         }
+
+         missed = m_wip.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+         if (missed == 0)
+         {
+            break;
+         }
+      }
+   }
+
+   //! Returns the next result of rail, or nullptr if there is none yet.
+   //! Taking a batch makes room in the rail's output, so a rail task that
+   //! ended on a full channel is started again.
+   Optional<T>* nextResult(Rail& rail)
+   {
+      while (rail.m_position == rail.m_current.size())
+      {
+         if (!rail.m_current.empty())
+         {
+            rail.m_output.recycle(rail.m_current);
+         }
+         rail.m_position = 0;
+         if (!rail.m_output.poll(rail.m_current))
+         {
+            return nullptr;
+         }
+
+         // Pairs with the fence in pause() like resume() does.
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         if (!rail.m_isRunning.load(std::memory_order_acquire)
+             && rail.m_isBlocked.load(std::memory_order_relaxed))
+         {
+            start(rail);
+         }
+      }
+      return &rail.m_current[rail.m_position++];
+   }
+   void drainUnordered()
+   {
+      for (;;)
+      {
+         if (terminateIfFailed())
+         {
+            return;
+         }
+
+         // Each rail's flag must be read before its results are.
+         bool isFinished = true;
+         for (auto& rail : m_rails)
+         {
+            isFinished &= rail->m_isFinished.load(std::memory_order_acquire);
+         }
+
+         bool isEmitted = false;
+         for (auto& rail : m_rails)
+         {
+            while (auto result = nextResult(*rail))
+            {
+               m_observer.onNext(result->get());
+               isEmitted = true;
+               if (isStopped())
+               {
+                  break;
+               }
+            }
+         }
+
+         if (!isEmitted)
+         {
+            if (isFinished)
+            {
+               terminate();
+            }
+            return;
+         }
+      }
+   }
+
+   void drainOrdered()
+   {
+      for (;;)
+      {
+         if (terminateIfFailed())
+         {
+            return;
+         }
+
+         auto& rail = *m_rails[m_nextOutputRail];
+         bool isFinished = rail.m_isFinished.load(std::memory_order_acquire);
+         auto result = nextResult(rail);
+         if (!result)
+         {
+            // Elements are dealt round-robin, so a rail that has run out
+            // means that every later element would have run out too.
+            if (isFinished)
+            {
+               terminate();
+            }
+            return;
+         }
+
+         m_nextOutputRail = (m_nextOutputRail + 1) % m_rails.size();
+         if (result->hasValue())
+         {
+            m_observer.onNext(result->get());
+         }
+      }
+   }
+
+   bool terminateIfFailed()
+   {
+      if (m_isFailed.load(std::memory_order_acquire))
+      {
+         std::exception_ptr e;
+         {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            e = m_error;
+         }
+         m_isTerminated = true;
+         m_observer.onError(e);
+         return true;
+      }
+      return m_cancellation.isCancelled();
+   }
+
+   void terminate()
+   {
+      std::exception_ptr e;
+      {
+         std::lock_guard<std::mutex> lock(m_errorMutex);
+         e = m_upstreamError;
+      }
+      m_isTerminated = true;
+      if (e)
+      {
+         m_observer.onError(e);
+      }
+      else
+      {
+         m_observer.onCompleted();
+      }
+   }
+
+   const Router m_router;
+   const Chain m_chain;
+   const bool m_isOrdered;
+   Scheduler m_scheduler;
+   Observer<T> m_observer;
+   CancellationFlag m_cancellation;
+   std::vector<std::unique_ptr<Rail>> m_rails;
+
+   // Upstream thread only.
+   std::size_t m_nextInputRail;
+
+   // Merge loop only.
+   std::size_t m_nextOutputRail;
+
+   std::atomic<int> m_wip;
+   std::atomic<bool> m_isFailed;
+   bool m_isTerminated;
+   std::mutex m_errorMutex;
+   std::exception_ptr m_error;
+   std::exception_ptr m_upstreamError;
+};
+
+template<class S, class T>
+Subscriber<S> createOperatorParallel(Subscriber<T> subscriber,
+                                     std::size_t railCount,
+                                     typename ParallelState<S, T>::Router router,
+                                     typename ParallelState<S, T>::Chain chain,
+                                     bool isOrdered,
+                                     Scheduler scheduler)
+{
+   auto state = std::make_shared<ParallelState<S, T>>(
+         railCount, std::move(router), std::move(chain), isOrdered,
+         std::move(scheduler), subscriber);
+   state->start(subscriber);
+
+   auto parent = Subscriber<S>(Observer<S>(
+      // onNext
+      [state](const S& s) {
+         state->onNext(s);
+      },
+      // onCompleted
+      [state]() {
+         state->onCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         state->onError(std::move(e));
+      }));
+
+   subscriber.add(parent.getSubscription());
+   return parent;
+}
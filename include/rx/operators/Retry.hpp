@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "rx/Observer.hpp"
+#include "rx/RetryPolicy.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+
+template<class T>
+class Observable;
+
+//! Resubscribes to a source that failed, as long as the policy allows.
+//!
+//! Everything a subscription needs is set up once and reused by every
+//! attempt: a single inner Subscriber, whose subscriptions are released
+//! before the next attempt registers its own, and a single Timer that is
+//! re-armed for every delayed retry. Waiting costs nothing but an armed
+//! timer on the scheduler, so any number of sources can back off at once
+//! without holding a thread each. Immediate retries are trampolined by a
+//! work-in-progress counter, so a source that fails synchronously does not
+//! nest one stack frame per attempt.
+template<class T>
+class RetryState : public std::enable_shared_from_this<RetryState<T>>
+{
+public:
+   RetryState(Observable<T> source, Observer<T> observer, RetryPolicy policy,
+              Scheduler scheduler)
+         : m_source(std::move(source)),
+           m_observer(std::move(observer)),
+           m_policy(std::move(policy)),
+           m_scheduler(std::move(scheduler)),
+           m_inner(Observer<T>()),
+           m_failures(0),
+           m_wip(0),
+           m_isTerminated(false)
+   {
+   }
+
+   //! Creates the inner subscriber and the timer and ties both to the
+   //! downstream subscriber. Must be called once, right after construction.
+   void init(Subscriber<T> subscriber)
+   {
+      std::weak_ptr<RetryState> weak_state = this->shared_from_this();
+      auto o = m_observer;
+
+      m_inner = Subscriber<T>(Observer<T>(
+         // onNext
+         [o](const T& t) {
+            o.onNext(t);
+         },
+         // onCompleted
+         [weak_state]() {
+            if (auto shared_state = weak_state.lock())
+            {
+               shared_state->onInnerCompleted();
+            }
+         },
+         // onError
+         [weak_state](std::exception_ptr e) {
+            if (auto shared_state = weak_state.lock())
+            {
+               shared_state->onInnerError(std::move(e));
+            }
+         }));
+
+      m_timer = m_scheduler.createTimer([weak_state]() {
+         if (auto shared_state = weak_state.lock())
+         {
+            shared_state->subscribe();
+         }
+      });
+
+      auto shared_state = this->shared_from_this();
+      subscriber.add(m_inner.getSubscription());
+      subscriber.add(Subscription([shared_state]() {
+         shared_state->m_isTerminated.store(true, std::memory_order_release);
+         shared_state->m_timer.dispose();
+      }));
+   }
+
+   //! Subscribes to the source, or runs another attempt once the current
+   //! subscribe has returned if one is in progress.
+   void subscribe()
+   {
+      if (m_wip.fetch_add(1, std::memory_order_acq_rel) != 0)
+      {
+         return;
+      }
+
+      int missed = 1;
+      for (;;)
+      {
+         if (!isTerminated())
+         {
+            // Releases whatever the failed attempt registered on the
+            // reused subscriber, before the next attempt registers its own.
+            m_inner.getSubscription().unsubscribe();
+            m_source.unsafeSubscribe(m_inner);
+
+            // Unsubscribed from another thread while subscribing.
+            if (isTerminated())
+            {
+               m_inner.getSubscription().unsubscribe();
+            }
+         }
+
+         missed = m_wip.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+         if (missed == 0)
+         {
+            break;
+         }
+      }
+   }
+
+private:
+   bool isTerminated() const
+   {
+      return m_isTerminated.load(std::memory_order_acquire);
+   }
+
+   bool setTerminated()
+   {
+      if (m_isTerminated.exchange(true, std::memory_order_acq_rel))
+      {
+         return false;
+      }
+      m_timer.dispose();
+      return true;
+   }
+
+   void onInnerCompleted()
+   {
+      if (setTerminated())
+      {
+         m_observer.onCompleted();
+      }
+   }
+
+   void onInnerError(std::exception_ptr e)
+   {
+      if (isTerminated())
+      {
+         return;
+      }
+
+      auto attempt = ++m_failures;
+      auto delay = m_policy.next(e, attempt);
+      if (!delay.hasValue())
+      {
+         if (setTerminated())
+         {
+            m_observer.onError(e);
+         }
+      }
+      else if (delay.get() <= Scheduler::Duration::zero())
+      {
+         subscribe();
+      }
+      else
+      {
+         m_timer.arm(m_scheduler.now() + delay.get());
+      }
+   }
+
+   const Observable<T> m_source;
+   const Observer<T> m_observer;
+   const RetryPolicy m_policy;
+   const Scheduler m_scheduler;
+   Subscriber<T> m_inner;
+   Timer m_timer;
+   //! Only touched by one attempt at a time.
+   std::size_t m_failures;
+   std::atomic<int> m_wip;
+   std::atomic<bool> m_isTerminated;
+};
+
+//! Subscribes subscriber to source, resubscribing as policy decides
+//! whenever source fails. Delayed retries run on scheduler.
+template<class T>
+void subscribeWithRetry(Observable<T> source, Subscriber<T> subscriber,
+                        RetryPolicy policy, Scheduler scheduler)
+{
+   auto state = std::make_shared<RetryState<T>>(
+         std::move(source), subscriber.getObserver(), std::move(policy),
+         std::move(scheduler));
+   state->init(subscriber);
+   state->subscribe();
+}
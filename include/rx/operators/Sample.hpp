@@ -0,0 +1,84 @@
+#pragma once
+
+#include <mutex>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/Optional.hpp"
+
+template<class T>
+struct SampleState
+{
+   SampleState(Observer<T> observer)
+         : m_observer(std::move(observer)),
+           m_isDone(false)
+   {
+   }
+
+   void emitLatest()
+   {
+      if (m_latest.hasValue())
+      {
+         m_observer.onNext(m_latest.take());
+      }
+   }
+
+   std::recursive_mutex m_mutex;
+   Observer<T> m_observer;
+   Optional<T> m_latest;
+   bool m_isDone;
+};
+
+//! Emits the most recent element, if any arrived, once every period. One
+//! periodic timer runs per subscription; an element only replaces the
+//! stored latest value.
+template<class T>
+Subscriber<T> createOperatorSample(Subscriber<T> subscriber,
+                                   Scheduler::Duration period,
+                                   Scheduler scheduler)
+{
+   auto state = std::make_shared<SampleState<T>>(subscriber.getObserver());
+
+   std::weak_ptr<SampleState<T>> weak_state = state;
+   auto timerSubscription = scheduler.schedulePeriodically(
+         scheduler.now() + period, period, [weak_state]() {
+            if (auto shared_state = weak_state.lock())
+            {
+               std::lock_guard<std::recursive_mutex> lock(shared_state->m_mutex);
+               if (!shared_state->m_isDone)
+               {
+                  shared_state->emitLatest();
+               }
+            }
+         });
+
+   auto parent = Subscriber<T>(Observer<T>(
+      // onNext
+      [state](const T& t) {
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_latest.set(t);
+      },
+      // onCompleted
+      [state, timerSubscription]() {
+         timerSubscription.unsubscribe();
+
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isDone = true;
+         state->emitLatest();
+         state->m_observer.onCompleted();
+      },
+      // onError
+      [state, timerSubscription](std::exception_ptr e) {
+         timerSubscription.unsubscribe();
+
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isDone = true;
+         state->m_latest.reset();
+         state->m_observer.onError(e);
+      }));
+
+   subscriber.add(timerSubscription);
+   subscriber.add(parent.getSubscription());
+   return parent;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <mutex>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+
+template<class T>
+struct ThrottleFirstState
+{
+   ThrottleFirstState(Scheduler::Duration windowDuration, Scheduler scheduler)
+         : m_windowDuration(windowDuration),
+           m_scheduler(std::move(scheduler)),
+           m_windowEnd(Scheduler::TimePoint::min())
+   {
+   }
+
+   std::mutex m_mutex;
+   const Scheduler::Duration m_windowDuration;
+   const Scheduler m_scheduler;
+   Scheduler::TimePoint m_windowEnd;
+};
+
+//! Emits the first element and then drops elements until windowDuration
+//! has passed. Windows are tracked with timestamps only, no timer is used.
+template<class T>
+Observer<T> createOperatorThrottleFirst(Observer<T> o,
+                                        Scheduler::Duration windowDuration,
+                                        Scheduler scheduler)
+{
+   auto state = std::make_shared<ThrottleFirstState<T>>(windowDuration,
+                                                        std::move(scheduler));
+
+   return Observer<T>(
+      // onNext
+      [o, state](const T& t) {
+         auto now = state->m_scheduler.now();
+         {
+            std::lock_guard<std::mutex> lock(state->m_mutex);
+            if (now < state->m_windowEnd)
+            {
+               return;
+            }
+            state->m_windowEnd = now + state->m_windowDuration;
+         }
+         o.onNext(t);
+      },
+      // onCompleted
+      [o]() {
+         o.onCompleted();
+      },
+      // onError
+      [o](std::exception_ptr e) {
+         o.onError(e);
+      });
+}
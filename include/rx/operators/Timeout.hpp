@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+
+//! Passed to onError by timeout() when no fallback was given.
+class TimeoutException : public std::runtime_error
+{
+public:
+   TimeoutException()
+      : std::runtime_error("timeout")
+   {
+   }
+};
+
+//! Tracks the time since the last element, or since the subscription for
+//! a deadline on the whole stream, with a single Timer per subscription.
+//!
+//! An element only stores its arrival time and bumps m_index; the timer is
+//! armed once for the first deadline and, when it fires, re-arms itself for
+//! the deadline of the last element if one arrived meanwhile. For a stream
+//! deadline elements leave the time alone, so the timer fires once. m_index is
+//! even while the upstream is idle, odd while an element is being passed
+//! on and DONE once the stream terminated or timed out. The timer only
+//! times out an idle stream, by swapping the index it saw for DONE, so an
+//! element is either passed on before the fallback starts or not at all.
+template<class T>
+class TimeoutState
+{
+public:
+   typedef std::function<void(Subscriber<T>)> Fallback;
+
+   TimeoutState(Observer<T> observer, Scheduler::Duration timeout,
+                bool isPerElement, Scheduler scheduler, Fallback fallback)
+         : m_observer(std::move(observer)),
+           m_timeout(timeout),
+           m_isPerElement(isPerElement),
+           m_scheduler(std::move(scheduler)),
+           m_fallback(std::move(fallback)),
+           m_fallbackSubscriber(m_observer),
+           m_index(0),
+           m_lastElement(0)
+   {
+   }
+
+   void onNext(const T& t)
+   {
+      auto index = m_index.load(std::memory_order_acquire);
+      if (index == DONE)
+      {
+         return;
+      }
+
+      if (m_isPerElement)
+      {
+         m_lastElement.store(ticks(m_scheduler.now()), std::memory_order_relaxed);
+      }
+      if (!m_index.compare_exchange_strong(index, index + 1,
+                                           std::memory_order_acq_rel))
+      {
+         return;
+      }
+      m_observer.onNext(t);
+      m_index.store(index + 2, std::memory_order_release);
+   }
+
+   void onCompleted()
+   {
+      if (terminate())
+      {
+         m_observer.onCompleted();
+      }
+   }
+
+   void onError(std::exception_ptr e)
+   {
+      if (terminate())
+      {
+         m_observer.onError(e);
+      }
+   }
+
+   void onTimer()
+   {
+      for (;;)
+      {
+         auto index = m_index.load(std::memory_order_acquire);
+         if (index == DONE)
+         {
+            return;
+         }
+
+         auto now = m_scheduler.now();
+         auto deadline = Scheduler::TimePoint(Scheduler::Duration(
+               m_lastElement.load(std::memory_order_relaxed))) + m_timeout;
+
+         // Time spent downstream by the element being passed on does not
+         // count against the stream. Past a stream deadline the timeout
+         // only waits for the element, until the next tick.
+         if (index % 2 == 1)
+         {
+            m_timer.arm(m_isPerElement ? now + m_timeout : now);
+            return;
+         }
+         if (now < deadline)
+         {
+            m_timer.arm(deadline);
+            return;
+         }
+         if (m_index.compare_exchange_strong(index, DONE, std::memory_order_acq_rel))
+         {
+            break;
+         }
+      }
+
+      m_timer.dispose();
+      m_upstream.unsubscribe();
+      if (m_fallback)
+      {
+         m_fallback(m_fallbackSubscriber);
+      }
+      else
+      {
+         m_observer.onError(std::make_exception_ptr(TimeoutException()));
+      }
+   }
+
+   //! Must be called once, before the upstream is subscribed to.
+   void start(Subscriber<T> subscriber, Subscription upstream,
+              std::weak_ptr<TimeoutState> weak_state)
+   {
+      m_upstream = std::move(upstream);
+      m_timer = m_scheduler.createTimer([weak_state]() {
+         if (auto shared_state = weak_state.lock())
+         {
+            shared_state->onTimer();
+         }
+      });
+
+      subscriber.add(m_timer.getSubscription());
+      if (m_fallback)
+      {
+         subscriber.add(m_fallbackSubscriber.getSubscription());
+      }
+
+      auto now = m_scheduler.now();
+      m_lastElement.store(ticks(now), std::memory_order_relaxed);
+      m_timer.arm(now + m_timeout);
+   }
+
+private:
+   static const std::uint64_t DONE = ~std::uint64_t(0);
+
+   static Scheduler::Duration::rep ticks(Scheduler::TimePoint t)
+   {
+      return t.time_since_epoch().count();
+   }
+
+   bool terminate()
+   {
+      auto index = m_index.load(std::memory_order_acquire);
+      if (index == DONE
+          || !m_index.compare_exchange_strong(index, DONE, std::memory_order_acq_rel))
+      {
+         return false;
+      }
+      m_timer.dispose();
+      return true;
+   }
+
+   const Observer<T> m_observer;
+   const Scheduler::Duration m_timeout;
+   const bool m_isPerElement;
+   const Scheduler m_scheduler;
+   const Fallback m_fallback;
+   Subscriber<T> m_fallbackSubscriber;
+   Subscription m_upstream;
+   Timer m_timer;
+   std::atomic<std::uint64_t> m_index;
+   //! Arrival of the last element, or the subscription until one arrives
+   //! or for a stream deadline.
+   std::atomic<Scheduler::Duration::rep> m_lastElement;
+};
+
+//! Fails with TimeoutException, or switches to fallback if one is given,
+//! once timeout passes without an element arriving, counting from the
+//! subscription for the first one. Elements only record their arrival
+//! time, the one Timer of the subscription checks it when it fires. Unless
+//! isPerElement, timeout counts from the subscription for the whole stream
+//! and elements do not touch the timer at all.
+template<class T>
+Subscriber<T> createOperatorTimeout(Subscriber<T> subscriber,
+                                    Scheduler::Duration timeout,
+                                    bool isPerElement,
+                                    Scheduler scheduler,
+                                    typename TimeoutState<T>::Fallback fallback)
+{
+   auto state = std::make_shared<TimeoutState<T>>(
+         subscriber.getObserver(), timeout, isPerElement, std::move(scheduler),
+         std::move(fallback));
+
+   auto parent = Subscriber<T>(Observer<T>(
+      // onNext
+      [state](const T& t) {
+         state->onNext(t);
+      },
+      // onCompleted
+      [state]() {
+         state->onCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         state->onError(std::move(e));
+      }));
+
+   subscriber.add(parent.getSubscription());
+   state->start(subscriber, parent.getSubscription(), state);
+   return parent;
+}
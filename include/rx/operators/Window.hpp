@@ -0,0 +1,167 @@
+#pragma once
+
+#include <mutex>
+
+#include "rx/Observer.hpp"
+#include "rx/Scheduler.hpp"
+#include "rx/Subscriber.hpp"
+#include "rx/internal/Optional.hpp"
+
+template<class T>
+class Observable;
+
+template<class T>
+class UnicastSubject;
+
+// Windows are UnicastSubjects: a window only ever has the subscriber that
+// received it, and a UnicastSubject costs one allocation where a Subject
+// costs a handful of std::functions and states.
+
+template<class T>
+struct WindowState
+{
+   WindowState(Observer<Observable<T>> observer, std::size_t count)
+         : m_observer(std::move(observer)),
+           m_count(count),
+           m_received(0)
+   {
+   }
+
+   Observer<Observable<T>> m_observer;
+   Optional<UnicastSubject<T>> m_window;
+   const std::size_t m_count;
+   std::size_t m_received;
+};
+
+//! Splits the elements into windows of count elements. A window is opened
+//! by its first element, so no empty windows are emitted.
+template<class T>
+Observer<T> createOperatorWindow(Observer<Observable<T>> o, std::size_t count)
+{
+   auto state = std::make_shared<WindowState<T>>(std::move(o), count);
+
+   return Observer<T>(
+      // onNext
+      [state](const T& t) {
+         if (!state->m_window.hasValue())
+         {
+            state->m_window.set(UnicastSubject<T>::create());
+            state->m_received = 0;
+            state->m_observer.onNext(state->m_window.get());
+         }
+
+         state->m_window.get().onNext(t);
+
+         if (++state->m_received == state->m_count)
+         {
+            state->m_window.take().onCompleted();
+         }
+      },
+      // onCompleted
+      [state]() {
+         if (state->m_window.hasValue())
+         {
+            state->m_window.take().onCompleted();
+         }
+         state->m_observer.onCompleted();
+      },
+      // onError
+      [state](std::exception_ptr e) {
+         if (state->m_window.hasValue())
+         {
+            state->m_window.take().onError(e);
+         }
+         state->m_observer.onError(e);
+      });
+}
+
+template<class T>
+struct WindowWithTimeState
+{
+   WindowWithTimeState(Observer<Observable<T>> observer)
+         : m_observer(std::move(observer)),
+           m_isDone(false)
+   {
+   }
+
+   //! Completes the current window, if any, and emits a new one.
+   void rotate()
+   {
+      if (m_window.hasValue())
+      {
+         m_window.take().onCompleted();
+      }
+      m_window.set(UnicastSubject<T>::create());
+      m_observer.onNext(m_window.get());
+   }
+
+   std::recursive_mutex m_mutex;
+   Observer<Observable<T>> m_observer;
+   Optional<UnicastSubject<T>> m_window;
+   bool m_isDone;
+};
+
+//! Emits a new window every timespan, starting with one on subscribe.
+template<class T>
+Subscriber<T> createOperatorWindowWithTime(Subscriber<Observable<T>> subscriber,
+                                           Scheduler::Duration timespan,
+                                           Scheduler scheduler)
+{
+   auto state = std::make_shared<WindowWithTimeState<T>>(subscriber.getObserver());
+
+   {
+      std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+      state->rotate();
+   }
+
+   std::weak_ptr<WindowWithTimeState<T>> weak_state = state;
+   auto timerSubscription = scheduler.schedulePeriodically(
+         scheduler.now() + timespan, timespan, [weak_state]() {
+            if (auto shared_state = weak_state.lock())
+            {
+               std::lock_guard<std::recursive_mutex> lock(shared_state->m_mutex);
+               if (!shared_state->m_isDone)
+               {
+                  shared_state->rotate();
+               }
+            }
+         });
+
+   auto parent = Subscriber<T>(Observer<T>(
+      // onNext
+      [state](const T& t) {
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         if (state->m_window.hasValue())
+         {
+            state->m_window.get().onNext(t);
+         }
+      },
+      // onCompleted
+      [state, timerSubscription]() {
+         timerSubscription.unsubscribe();
+
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isDone = true;
+         if (state->m_window.hasValue())
+         {
+            state->m_window.take().onCompleted();
+         }
+         state->m_observer.onCompleted();
+      },
+      // onError
+      [state, timerSubscription](std::exception_ptr e) {
+         timerSubscription.unsubscribe();
+
+         std::lock_guard<std::recursive_mutex> lock(state->m_mutex);
+         state->m_isDone = true;
+         if (state->m_window.hasValue())
+         {
+            state->m_window.take().onError(e);
+         }
+         state->m_observer.onError(e);
+      }));
+
+   subscriber.add(timerSubscription);
+   subscriber.add(parent.getSubscription());
+   return parent;
+}
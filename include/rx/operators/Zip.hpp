@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "rx/Observable.hpp"
+#include "rx/internal/SpscLinkedArrayQueue.hpp"
+
+static const std::size_t ZIP_DEFAULT_PREFETCH = 128;
+
+//! Pairs up the n-th elements of every source. Each source gets its own
+//! lock-free SpscLinkedArrayQueue of prefetch element segments; every
+//! arrival triggers one drain pass that emits as many tuples as all queues
+//! can supply. Drains are serialized with a work-in-progress counter, so
+//! sources may emit on different threads and the zipper is never called
+//! concurrently.
+//!
+//! Nothing can make a source wait, so one that gets ahead of the others,
+//! like a synchronous one that emits everything before the next source is
+//! even subscribed, is buffered without bound, one segment of prefetch
+//! elements at a time. Neither side locks, and sources that stay within a
+//! segment of each other do not allocate.
+template<class Zipper, class... Ts>
+class ZipState : public std::enable_shared_from_this<ZipState<Zipper, Ts...>>
+{
+public:
+   typedef typename std::result_of<Zipper(const Ts&...)>::type R;
+
+   ZipState(Observer<R> observer, Zipper zipper, std::size_t prefetch)
+         : m_observer(std::move(observer)),
+           m_zipper(std::move(zipper)),
+           m_buffers(capacityFor<Ts>(prefetch)...),
+           m_wip(0),
+           m_errorState(ERROR_UNSET),
+           m_isTerminated(false)
+   {
+      for (auto& isDone : m_isDone)
+      {
+         isDone.store(false, std::memory_order_relaxed);
+      }
+   }
+
+   void subscribe(Subscriber<R> subscriber, const Observable<Ts>&... sources)
+   {
+      subscriber.add(m_subscriptions);
+      subscribe(std::index_sequence_for<Ts...>(), sources...);
+   }
+
+private:
+   enum ErrorState
+   {
+      ERROR_UNSET,
+      ERROR_SETTING,
+      ERROR_SET
+   };
+
+   //! Expands to one segment size per source type.
+   template<class T>
+   static std::size_t capacityFor(std::size_t prefetch)
+   {
+      return prefetch;
+   }
+
+   template<std::size_t... I>
+   void subscribe(std::index_sequence<I...>, const Observable<Ts>&... sources)
+   {
+      auto self = this->shared_from_this();
+      (void)std::initializer_list<int>{ (subscribeTo<I>(self, sources), 0)... };
+   }
+
+   template<std::size_t I, class T>
+   void subscribeTo(const std::shared_ptr<ZipState>& self, const Observable<T>& source)
+   {
+      if (m_isTerminated.load(std::memory_order_acquire))
+      {
+         return;
+      }
+
+      m_subscriptions.add(source.subscribe(Observer<T>(
+         // onNext
+         [self](const T& t) {
+            std::get<I>(self->m_buffers).offer(t);
+            self->drain();
+         },
+         // onCompleted
+         [self]() {
+            self->m_isDone[I].store(true, std::memory_order_release);
+            self->drain();
+         },
+         // onError
+         [self](std::exception_ptr e) {
+            self->onError(std::move(e));
+         })));
+   }
+
+   void onError(std::exception_ptr e)
+   {
+      int expected = ERROR_UNSET;
+      if (m_errorState.compare_exchange_strong(expected, ERROR_SETTING))
+      {
+         m_error = std::move(e);
+         m_errorState.store(ERROR_SET, std::memory_order_release);
+      }
+      drain();
+   }
+
+   void drain()
+   {
+      if (m_wip.fetch_add(1, std::memory_order_acq_rel) != 0)
+      {
+         return;
+      }
+
+      int missed = 1;
+      for (;;)
+      {
+         if (!m_isTerminated.load(std::memory_order_relaxed))
+         {
+            drainOnce(std::index_sequence_for<Ts...>());
+         }
+
+         missed = m_wip.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+         if (missed == 0)
+         {
+            break;
+         }
+      }
+   }
+
+   template<std::size_t... I>
+   void drainOnce(std::index_sequence<I...>)
+   {
+      for (;;)
+      {
+         if (m_errorState.load(std::memory_order_acquire) == ERROR_SET)
+         {
+            terminate();
+            m_observer.onError(m_error);
+            return;
+         }
+
+         // Read the done flags before the buffers: a source stores its
+         // last element before it marks itself done.
+         bool isDone[sizeof...(Ts)] = {
+               m_isDone[I].load(std::memory_order_acquire)... };
+         bool isEmpty[sizeof...(Ts)] = {
+               std::get<I>(m_buffers).isEmpty()... };
+
+         bool isReady = true;
+         for (std::size_t i = 0; i < sizeof...(Ts); i++)
+         {
+            if (isEmpty[i])
+            {
+               if (isDone[i])
+               {
+                  terminate();
+                  m_observer.onCompleted();
+                  return;
+               }
+               isReady = false;
+            }
+         }
+
+         if (!isReady)
+         {
+            return;
+         }
+
+         auto r = m_zipper(std::get<I>(m_buffers).front()...);
+         (void)std::initializer_list<int>{ (std::get<I>(m_buffers).pop(), 0)... };
+         m_observer.onNext(r);
+      }
+   }
+
+   void terminate()
+   {
+      m_isTerminated.store(true, std::memory_order_release);
+      m_subscriptions.unsubscribe();
+   }
+
+   Observer<R> m_observer;
+   Zipper m_zipper;
+   std::tuple<SpscLinkedArrayQueue<Ts>...> m_buffers;
+   std::atomic<bool> m_isDone[sizeof...(Ts)];
+   std::atomic<int> m_wip;
+   std::atomic<int> m_errorState;
+   std::exception_ptr m_error;
+   std::atomic<bool> m_isTerminated;
+   SubscriptionList m_subscriptions;
+};
+
+//! Like zip(), with the elements of every source buffered in segments of
+//! prefetch elements. prefetch is the unit of allocation, not a bound on
+//! memory: a source that runs ahead is buffered in as many segments as it
+//! takes. Throws std::invalid_argument if prefetch is 0.
+template<class Zipper, class... Ts>
+Observable<typename ZipState<Zipper, Ts...>::R>
+zipWithPrefetch(std::size_t prefetch, Zipper zipper, Observable<Ts>... sources)
+{
+   typedef ZipState<Zipper, Ts...> State;
+   typedef typename State::R R;
+
+   if (prefetch == 0)
+   {
+      throw std::invalid_argument("zip prefetch must not be 0");
+   }
+
+   return Observable<R>::create([prefetch, zipper, sources...](Subscriber<R> s){
+      auto state = std::make_shared<State>(s.getObserver(), zipper, prefetch);
+      state->subscribe(s, sources...);
+   });
+}
+
+template<class Tuple, std::size_t... I>
+auto zipFromTuple(Tuple&& args, std::index_sequence<I...>)
+   -> decltype(zipWithPrefetch(ZIP_DEFAULT_PREFETCH,
+                               std::get<sizeof...(I)>(args),
+                               std::get<I>(args)...))
+{
+   return zipWithPrefetch(ZIP_DEFAULT_PREFETCH,
+                          std::get<sizeof...(I)>(args),
+                          std::get<I>(args)...);
+}
+
+//! zip(a, b, ..., zipper) combines the n-th elements of every source with
+//! zipper, buffering the elements of every source without locking in
+//! segments of ZIP_DEFAULT_PREFETCH elements.
+template<class... Args>
+auto zip(Args... args)
+   -> decltype(zipFromTuple(std::forward_as_tuple(args...),
+                            std::make_index_sequence<sizeof...(Args) - 1>()))
+{
+   return zipFromTuple(std::forward_as_tuple(args...),
+                       std::make_index_sequence<sizeof...(Args) - 1>());
+}
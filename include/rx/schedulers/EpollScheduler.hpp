@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "rx/Scheduler.hpp"
+
+//! Scheduler whose single thread runs an epoll event loop. Besides timers,
+//! which are kept in a TimingWheel, it watches file descriptors, so one
+//! thread serves thousands of sockets, pipes, eventfds, timerfds or
+//! signalfds. Other threads wake the loop up through an eventfd.
+//!
+//! The thread is stopped when the last handle to the scheduler, or to one
+//! of its watches, goes away.
+class EpollScheduler : public Scheduler
+{
+public:
+   //! Returns false to stop the watch, for instance at end of file.
+   typedef std::function<bool(std::uint32_t events)> FdHandler;
+
+   static EpollScheduler create(
+         Duration resolution = std::chrono::milliseconds(1));
+
+   //! Returns the process wide event loop used by fd sources when no
+   //! scheduler is given.
+   static EpollScheduler getDefault();
+
+   //! Registers fd edge-triggered for events and calls handler on the loop
+   //! thread with the events that became ready. Since readiness is only
+   //! reported on edges, handler must consume everything there is to
+   //! consume. Once handler returns false fd is removed from the epoll set
+   //! and then onStopped is called, so that it may close fd.
+   //!
+   //! Unsubscribing stops the watch but does not close fd; once it
+   //! returns, on any other thread than the loop, handler is neither
+   //! running nor called again. Throws std::system_error if fd cannot be
+   //! registered.
+   Subscription watch(int fd, std::uint32_t events, FdHandler handler,
+                      std::function<void()> onStopped = nullptr) const;
+
+private:
+   class State;
+
+   EpollScheduler(std::shared_ptr<State> state);
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "rx/Scheduler.hpp"
+
+//! Scheduler with a virtual clock that only moves when told to. Actions run
+//! on the thread that advances the clock, and now() reports the time of the
+//! tick being fired, which makes time based operators testable.
+class TestScheduler : public Scheduler
+{
+public:
+   static TestScheduler create(
+         Duration resolution = std::chrono::milliseconds(1));
+
+   void advanceTimeBy(Duration delta) const;
+
+   void advanceTimeTo(TimePoint t) const;
+
+private:
+   class State;
+
+   TestScheduler(std::shared_ptr<State> state);
+};
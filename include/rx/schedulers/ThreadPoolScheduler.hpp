@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+#include "rx/Scheduler.hpp"
+
+//! Scheduler that runs actions on a fixed pool of threads, in the order
+//! they were scheduled but possibly concurrently. Timers are kept by the
+//! default TimingWheelScheduler and their actions handed to the pool when
+//! they expire.
+//!
+//! The threads are stopped when the last handle to the scheduler goes
+//! away; actions that have not started by then never run.
+class ThreadPoolScheduler : public Scheduler
+{
+public:
+   //! A threadCount of zero starts one thread per hardware thread.
+   static ThreadPoolScheduler create(std::size_t threadCount = 0);
+
+   //! Returns the process wide pool used by operators that run work
+   //! concurrently when no scheduler is given.
+   static ThreadPoolScheduler getDefault();
+
+   std::size_t getThreadCount() const;
+
+private:
+   class State;
+
+   ThreadPoolScheduler(std::shared_ptr<State> state);
+};
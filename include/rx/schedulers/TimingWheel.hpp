@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "rx/Scheduler.hpp"
+
+//! Hierarchical timing wheel.
+//!
+//! Time is divided into ticks of a configurable resolution and every
+//! deadline is rounded up to the next tick, so all timers that fall within
+//! the same tick fire together. The wheel has LEVELS levels of SLOTS slots;
+//! a timer is placed in the level whose span covers its distance from the
+//! current tick and is cascaded down to a finer level when the coarser
+//! level's slot comes around. Timers are intrusively linked into their
+//! slot, which makes arming, re-arming and cancelling O(1) and free of
+//! allocation. The only allocation is the one in createTimer.
+//!
+//! The wheel does not own a thread; it is driven by calling advance(),
+//! which runs expired actions on the calling thread. All other members can
+//! be called from any thread.
+class TimingWheel : public std::enable_shared_from_this<TimingWheel>
+{
+public:
+   typedef Scheduler::Clock Clock;
+   typedef Scheduler::TimePoint TimePoint;
+   typedef Scheduler::Duration Duration;
+   typedef Scheduler::Action Action;
+   typedef std::function<void()> WakeupFunc;
+
+   static const int LEVEL_BITS = 6;
+   static const int SLOTS = 1 << LEVEL_BITS;
+   static const int LEVELS = 4;
+
+   //! onWakeup is called, without any lock held, when a timer is armed in
+   //! an empty wheel so that whoever drives the wheel can stop idling.
+   static std::shared_ptr<TimingWheel> create(Duration resolution,
+                                              TimePoint origin,
+                                              WakeupFunc onWakeup = nullptr);
+
+   ~TimingWheel();
+
+   Timer createTimer(Action action);
+
+   //! Fires, in tick order, every timer whose tick has been reached by now.
+   //! Actions run with the wheel unlocked and may arm or cancel timers.
+   void advance(TimePoint now);
+
+   bool empty() const;
+
+   //! Returns the earliest point in time at which advance() may have work
+   //! to do, or TimePoint::max() if no timer is armed.
+   TimePoint nextExpiry() const;
+
+   Duration getResolution() const;
+
+private:
+   struct Link
+   {
+      Link()
+            : m_prev(nullptr),
+              m_next(nullptr)
+      {
+      }
+
+      bool isLinked() const
+      {
+         return m_next != nullptr;
+      }
+
+      Link* m_prev;
+      Link* m_next;
+   };
+
+   class TimerState;
+
+   TimingWheel(Duration resolution, TimePoint origin, WakeupFunc onWakeup);
+
+   TimingWheel(const TimingWheel&) = delete;
+   TimingWheel& operator=(const TimingWheel&) = delete;
+
+   void arm(TimerState& timer, TimePoint due);
+
+   void cancel(TimerState& timer);
+
+   void dispose(TimerState& timer);
+
+   std::uint64_t toTick(TimePoint t) const;
+
+   TimePoint toTimePoint(std::uint64_t tick) const;
+
+   void insert(TimerState& timer);
+
+   void unlink(TimerState& timer);
+
+   void cascade(int level, int slot);
+
+   static void initList(Link& head);
+
+   static void pushBack(Link& head, Link& link);
+
+   static bool isEmpty(const Link& head);
+
+   const Duration m_resolution;
+   const TimePoint m_origin;
+   const WakeupFunc m_onWakeup;
+
+   mutable std::mutex m_mutex;
+   std::uint64_t m_tick;
+   mutable std::uint64_t m_plannedTick;
+   std::size_t m_count;
+   Link m_slots[LEVELS][SLOTS];
+   Link m_expired;
+};
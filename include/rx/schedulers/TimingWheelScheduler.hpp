@@ -0,0 +1,25 @@
+#pragma once
+
+#include "rx/Scheduler.hpp"
+
+//! Scheduler that runs all of its timers on a single thread driving a
+//! TimingWheel. Tens of thousands of live timers cost one thread plus one
+//! small node each.
+//!
+//! The thread is stopped when the last handle to the scheduler goes away;
+//! timers that are still armed at that point never fire.
+class TimingWheelScheduler : public Scheduler
+{
+public:
+   static TimingWheelScheduler create(
+         Duration resolution = std::chrono::milliseconds(1));
+
+   //! Returns the process wide scheduler used by time based sources and
+   //! operators when no scheduler is given.
+   static TimingWheelScheduler getDefault();
+
+private:
+   class State;
+
+   TimingWheelScheduler(std::shared_ptr<State> state);
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+
+//! Queue that turns reentrant emission into iteration.
+//!
+//! Every emitter owns one. The first emission runs directly and marks the
+//! trampoline as active. Emissions started while it runs, which by the
+//! Observer contract come from the same thread, are deferred and run in
+//! order once it has returned, so reentrant emission runs in constant
+//! stack space and never overlaps an emission in progress. Emissions into
+//! other emitters are not affected.
+class Trampoline
+{
+public:
+   typedef std::function<void()> Action;
+
+   Trampoline();
+
+   Trampoline(const Trampoline&) = delete;
+   Trampoline& operator=(const Trampoline&) = delete;
+
+   //! Returns true while an action of this trampoline runs.
+   bool isActive() const;
+
+   //! Queues action to run after the current action. Must only be called
+   //! while isActive().
+   void defer(Action action);
+
+   //! Runs f and then every action deferred while the queue drains. If an
+   //! action throws, the actions still queued on this trampoline are
+   //! dropped.
+   template<class F>
+   void run(F&& f)
+   {
+      m_isActive = true;
+      try
+      {
+         f();
+         drain();
+      }
+      catch(...)
+      {
+         abort();
+         throw;
+      }
+      m_isActive = false;
+   }
+
+private:
+   void drain();
+
+   void abort();
+
+   bool m_isActive;
+   std::deque<Action> m_queue;
+};
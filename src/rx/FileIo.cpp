@@ -0,0 +1,638 @@
+#include "rx/FileIo.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+std::system_error lastError(const char* what)
+{
+   return std::system_error(errno, std::generic_category(), what);
+}
+
+//! user_data of the no-op that stops the completion thread.
+const std::uint64_t STOP_REQUEST = 0;
+
+
+//! The completion thread currently running UringCore::run(), if any.
+thread_local const void* t_reapingCore = nullptr;
+
+
+//! io_uring driven through the raw syscalls. Submission is serialized by a
+//! mutex, completions are reaped by one thread that blocks in
+//! io_uring_enter.
+class UringCore
+{
+public:
+   static constexpr unsigned THREAD_COUNT = 1;
+
+   explicit UringCore(unsigned queueDepth)
+         : m_ringFd(-1),
+           m_sqRing(MAP_FAILED),
+           m_cqRing(MAP_FAILED),
+           m_sqes(MAP_FAILED),
+           m_queued(0),
+           m_inFlight(0),
+           m_syscalls(0),
+           m_bytes(0)
+   {
+      io_uring_params params;
+      std::memset(&params, 0, sizeof(params));
+      m_ringFd = int(syscall(__NR_io_uring_setup, queueDepth, &params));
+      if (m_ringFd < 0)
+      {
+         throw lastError("io_uring_setup");
+      }
+      probe();
+
+      m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+      m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      bool isSingleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+      if (isSingleMmap)
+      {
+         m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+      }
+
+      m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+      m_cqRing = isSingleMmap
+                 ? m_sqRing
+                 : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+      m_sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe),
+                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_ringFd, IORING_OFF_SQES);
+      if (m_sqRing == MAP_FAILED || m_cqRing == MAP_FAILED || m_sqes == MAP_FAILED)
+      {
+         auto error = lastError("mmap io_uring");
+         release();
+         throw error;
+      }
+
+      auto sq = static_cast<char*>(m_sqRing);
+      m_sqHead = reinterpret_cast<std::atomic<unsigned>*>(sq + params.sq_off.head);
+      m_sqTail = reinterpret_cast<std::atomic<unsigned>*>(sq + params.sq_off.tail);
+      m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+      m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+      m_sqEntries = params.sq_entries;
+
+      auto cq = static_cast<char*>(m_cqRing);
+      m_cqHead = reinterpret_cast<std::atomic<unsigned>*>(cq + params.cq_off.head);
+      m_cqTail = reinterpret_cast<std::atomic<unsigned>*>(cq + params.cq_off.tail);
+      m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+      m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+   }
+
+   ~UringCore()
+   {
+      release();
+   }
+
+   void stop()
+   {
+      std::vector<Failure> failed;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+
+         // Submitted and withdrawn requests no longer occupy the submission
+         // ring, so once it is flushed there is room for the stop request.
+         flush();
+         auto sqe = nextSqe();
+         sqe->opcode = IORING_OP_NOP;
+         sqe->user_data = STOP_REQUEST;
+         pushSqe();
+         flush();
+         failed.swap(m_failed);
+      }
+      complete(failed);
+   }
+
+   void queue(FileIo::Request& request)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_inFlight + m_queued < m_sqEntries)
+      {
+         prepare(request);
+      }
+      else
+      {
+         m_backlog.push_back(&request);
+      }
+   }
+
+   void submit()
+   {
+      // Handlers that reissue requests run on the completion thread, which
+      // submits once after the whole batch of completions instead.
+      if (t_reapingCore == this)
+      {
+         return;
+      }
+
+      std::vector<Failure> failed;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         flush();
+         failed.swap(m_failed);
+      }
+      complete(failed);
+   }
+
+   bool isUring() const
+   {
+      return true;
+   }
+
+   FileIo::Stats getStats() const
+   {
+      return FileIo::Stats{ m_syscalls.load(std::memory_order_relaxed),
+                            m_bytes.load(std::memory_order_relaxed) };
+   }
+
+   void run()
+   {
+      t_reapingCore = this;
+      std::vector<io_uring_cqe> completed;
+      std::vector<Failure> failed;
+      bool isStopped = false;
+
+      while (!isStopped)
+      {
+         m_syscalls.fetch_add(1, std::memory_order_relaxed);
+         int result = int(syscall(__NR_io_uring_enter, m_ringFd, 0, 1,
+                                  IORING_ENTER_GETEVENTS, nullptr, 0));
+         if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+         {
+            std::terminate();
+         }
+
+         completed.clear();
+         auto head = m_cqHead->load(std::memory_order_relaxed);
+         auto tail = m_cqTail->load(std::memory_order_acquire);
+         for (; head != tail; ++head)
+         {
+            completed.push_back(m_cqes[head & m_cqMask]);
+         }
+         m_cqHead->store(head, std::memory_order_release);
+
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& cqe : completed)
+            {
+               if (cqe.user_data != STOP_REQUEST)
+               {
+                  --m_inFlight;
+               }
+            }
+            while (!m_backlog.empty() && m_inFlight + m_queued < m_sqEntries)
+            {
+               prepare(*m_backlog.front());
+               m_backlog.pop_front();
+            }
+            flush();
+            failed.swap(m_failed);
+         }
+         complete(failed);
+
+         for (auto& cqe : completed)
+         {
+            if (cqe.user_data == STOP_REQUEST)
+            {
+               isStopped = true;
+               continue;
+            }
+            if (cqe.res > 0)
+            {
+               m_bytes.fetch_add(std::uint64_t(cqe.res), std::memory_order_relaxed);
+            }
+            auto& request = *reinterpret_cast<FileIo::Request*>(cqe.user_data);
+            request.m_handler->onIoCompleted(request, cqe.res);
+         }
+
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            flush();
+            failed.swap(m_failed);
+         }
+         complete(failed);
+      }
+      t_reapingCore = nullptr;
+   }
+
+private:
+   //! A request the kernel refused, with the negated errno to complete it
+   //! with.
+   typedef std::pair<FileIo::Request*, long> Failure;
+
+   //! Kernels before 5.6 have io_uring but neither the probe nor
+   //! IORING_OP_READ and IORING_OP_WRITE, on which every request would
+   //! fail; treat them as having no io_uring at all.
+   void probe()
+   {
+      const unsigned OP_COUNT = 256;
+      std::vector<io_uring_probe_op> buffer(
+            OP_COUNT + sizeof(io_uring_probe) / sizeof(io_uring_probe_op));
+      auto probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+      if (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_PROBE,
+                  probe, OP_COUNT) < 0)
+      {
+         auto error = lastError("io_uring_register");
+         release();
+         throw error;
+      }
+
+      for (unsigned opcode : { IORING_OP_READ, IORING_OP_WRITE })
+      {
+         if (opcode >= probe->ops_len
+             || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+         {
+            release();
+            throw std::system_error(
+                  std::make_error_code(std::errc::operation_not_supported),
+                  "io_uring read and write");
+         }
+      }
+   }
+
+   //! Returns the cleared entry at the tail of the submission ring. Must
+   //! be called with m_mutex held, as must pushSqe().
+   io_uring_sqe* nextSqe()
+   {
+      auto tail = m_sqTail->load(std::memory_order_relaxed);
+      auto sqe = &static_cast<io_uring_sqe*>(m_sqes)[tail & m_sqMask];
+      std::memset(sqe, 0, sizeof(*sqe));
+      return sqe;
+   }
+
+   //! Publishes the entry returned by nextSqe().
+   void pushSqe()
+   {
+      auto tail = m_sqTail->load(std::memory_order_relaxed);
+      auto index = tail & m_sqMask;
+      m_sqArray[index] = index;
+      m_sqTail->store(tail + 1, std::memory_order_release);
+      ++m_queued;
+   }
+
+   //! Must be called with m_mutex held.
+   void prepare(FileIo::Request& request)
+   {
+      auto sqe = nextSqe();
+      sqe->opcode = request.m_isWrite ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->fd = request.m_fd;
+      sqe->addr = reinterpret_cast<std::uint64_t>(request.m_data);
+      sqe->len = unsigned(request.m_length);
+      sqe->off = request.m_offset;
+      sqe->user_data = reinterpret_cast<std::uint64_t>(&request);
+      pushSqe();
+   }
+
+   //! Must be called with m_mutex held. If the kernel refuses the queued
+   //! requests they are withdrawn from the ring and, with the backlog,
+   //! moved to m_failed, to be completed once the mutex has been released.
+   void flush()
+   {
+      while (m_queued > 0)
+      {
+         m_syscalls.fetch_add(1, std::memory_order_relaxed);
+         int submitted = int(syscall(__NR_io_uring_enter, m_ringFd, m_queued,
+                                     0, 0, nullptr, 0));
+         if (submitted < 0)
+         {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+            {
+               continue;
+            }
+            withdraw(-long(errno));
+            return;
+         }
+         m_queued -= unsigned(submitted);
+         m_inFlight += unsigned(submitted);
+      }
+   }
+
+   //! Must be called with m_mutex held. The kernel only consumes entries
+   //! in io_uring_enter, which is only called to submit under m_mutex, so
+   //! moving the tail back to the head takes the queued entries back.
+   void withdraw(long result)
+   {
+      auto head = m_sqHead->load(std::memory_order_acquire);
+      auto tail = m_sqTail->load(std::memory_order_relaxed);
+      auto sqes = static_cast<io_uring_sqe*>(m_sqes);
+      for (auto i = head; i != tail; ++i)
+      {
+         auto& sqe = sqes[m_sqArray[i & m_sqMask]];
+         if (sqe.user_data != STOP_REQUEST)
+         {
+            m_failed.emplace_back(
+                  reinterpret_cast<FileIo::Request*>(sqe.user_data), result);
+         }
+      }
+      m_sqTail->store(head, std::memory_order_release);
+      m_queued = 0;
+
+      for (auto request : m_backlog)
+      {
+         m_failed.emplace_back(request, result);
+      }
+      m_backlog.clear();
+   }
+
+   //! Must be called without m_mutex held, as handlers may queue again.
+   void complete(std::vector<Failure>& failed)
+   {
+      for (auto& failure : failed)
+      {
+         failure.first->m_handler->onIoCompleted(*failure.first, failure.second);
+      }
+      failed.clear();
+   }
+
+   void release()
+   {
+      if (m_sqes != MAP_FAILED)
+      {
+         munmap(m_sqes, m_sqEntries * sizeof(io_uring_sqe));
+      }
+      if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing)
+      {
+         munmap(m_cqRing, m_cqRingSize);
+      }
+      if (m_sqRing != MAP_FAILED)
+      {
+         munmap(m_sqRing, m_sqRingSize);
+      }
+      if (m_ringFd >= 0)
+      {
+         close(m_ringFd);
+      }
+   }
+
+   int m_ringFd;
+   void* m_sqRing;
+   void* m_cqRing;
+   void* m_sqes;
+   std::size_t m_sqRingSize;
+   std::size_t m_cqRingSize;
+
+   std::atomic<unsigned>* m_sqHead;
+   std::atomic<unsigned>* m_sqTail;
+   unsigned m_sqMask;
+   unsigned* m_sqArray;
+   unsigned m_sqEntries;
+
+   std::atomic<unsigned>* m_cqHead;
+   std::atomic<unsigned>* m_cqTail;
+   unsigned m_cqMask;
+   io_uring_cqe* m_cqes;
+
+   std::mutex m_mutex;
+   unsigned m_queued;
+   unsigned m_inFlight;
+   std::deque<FileIo::Request*> m_backlog;
+   std::vector<Failure> m_failed;
+
+   std::atomic<std::uint64_t> m_syscalls;
+   std::atomic<std::uint64_t> m_bytes;
+};
+
+
+//! pread and pwrite on a pool of threads.
+class ThreadPoolCore
+{
+public:
+   ThreadPoolCore()
+         : m_isStopped(false),
+           m_syscalls(0),
+           m_bytes(0)
+   {
+   }
+
+   void stop()
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_isStopped = true;
+      }
+      m_condition.notify_all();
+   }
+
+   void queue(FileIo::Request& request)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_queued.push_back(&request);
+   }
+
+   void submit()
+   {
+      bool isNotEmpty;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         for (auto request : m_queued)
+         {
+            m_ready.push_back(request);
+         }
+         isNotEmpty = !m_queued.empty();
+         m_queued.clear();
+      }
+      if (isNotEmpty)
+      {
+         m_condition.notify_all();
+      }
+   }
+
+   bool isUring() const
+   {
+      return false;
+   }
+
+   FileIo::Stats getStats() const
+   {
+      return FileIo::Stats{ m_syscalls.load(std::memory_order_relaxed),
+                            m_bytes.load(std::memory_order_relaxed) };
+   }
+
+   void run()
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      for (;;)
+      {
+         m_condition.wait(lock, [this]() {
+            return m_isStopped || !m_ready.empty();
+         });
+         if (m_ready.empty())
+         {
+            return;
+         }
+
+         auto& request = *m_ready.front();
+         m_ready.pop_front();
+         lock.unlock();
+
+         m_syscalls.fetch_add(1, std::memory_order_relaxed);
+         long result = request.m_isWrite
+               ? long(pwrite(request.m_fd, request.m_data, request.m_length,
+                             off_t(request.m_offset)))
+               : long(pread(request.m_fd, request.m_data, request.m_length,
+                            off_t(request.m_offset)));
+         if (result < 0)
+         {
+            result = -errno;
+         }
+         else
+         {
+            m_bytes.fetch_add(std::uint64_t(result), std::memory_order_relaxed);
+         }
+         request.m_handler->onIoCompleted(request, result);
+
+         lock.lock();
+      }
+   }
+
+   std::mutex m_mutex;
+   std::condition_variable m_condition;
+   std::vector<FileIo::Request*> m_queued;
+   std::deque<FileIo::Request*> m_ready;
+   bool m_isStopped;
+   std::atomic<std::uint64_t> m_syscalls;
+   std::atomic<std::uint64_t> m_bytes;
+};
+
+
+//! Runs the threads of a core. The threads share ownership of the core,
+//! so the last FileIo handle may be dropped by a handler running on one of
+//! them; that thread is detached and lets go of the core when it exits.
+template<class Core>
+class CoreState : public FileIo::State
+{
+public:
+   CoreState(std::shared_ptr<Core> core, unsigned threadCount)
+         : m_core(std::move(core))
+   {
+      auto core_ptr = m_core;
+      for (unsigned i = 0; i < threadCount; i++)
+      {
+         m_threads.emplace_back([core_ptr]() { core_ptr->run(); });
+      }
+   }
+
+   ~CoreState()
+   {
+      m_core->stop();
+      for (auto& thread : m_threads)
+      {
+         if (thread.get_id() == std::this_thread::get_id())
+         {
+            thread.detach();
+         }
+         else
+         {
+            thread.join();
+         }
+      }
+   }
+
+   void queue(FileIo::Request& request) override
+   {
+      m_core->queue(request);
+   }
+
+   void submit() override
+   {
+      m_core->submit();
+   }
+
+   bool isUring() const override
+   {
+      return m_core->isUring();
+   }
+
+   FileIo::Stats getStats() const override
+   {
+      return m_core->getStats();
+   }
+
+private:
+   std::shared_ptr<Core> m_core;
+   std::vector<std::thread> m_threads;
+};
+
+}
+
+
+FileIo FileIo::create(unsigned queueDepth)
+{
+   try
+   {
+      return createUring(queueDepth);
+   }
+   catch (const std::system_error&)
+   {
+      return createThreadPool();
+   }
+}
+
+
+FileIo FileIo::createUring(unsigned queueDepth)
+{
+   return FileIo(std::make_shared<CoreState<UringCore>>(
+         std::make_shared<UringCore>(queueDepth), UringCore::THREAD_COUNT));
+}
+
+
+FileIo FileIo::createThreadPool(unsigned threadCount)
+{
+   return FileIo(std::make_shared<CoreState<ThreadPoolCore>>(
+         std::make_shared<ThreadPoolCore>(), threadCount));
+}
+
+
+FileIo FileIo::getDefault()
+{
+   static FileIo fileIo = create();
+   return fileIo;
+}
+
+
+void FileIo::queue(Request& request) const
+{
+   m_state->queue(request);
+}
+
+
+void FileIo::submit() const
+{
+   m_state->submit();
+}
+
+
+bool FileIo::isUring() const
+{
+   return m_state->isUring();
+}
+
+
+FileIo::Stats FileIo::getStats() const
+{
+   return m_state->getStats();
+}
+
+
+FileIo::FileIo(std::shared_ptr<State> state)
+   : m_state(std::move(state))
+{
+}
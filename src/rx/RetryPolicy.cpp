@@ -0,0 +1,73 @@
+#include "rx/RetryPolicy.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+//! Uniform in [0, 1). Every thread has its own generator, so that
+//! thousands of sources failing at once do not contend on one.
+double uniformRandom()
+{
+   thread_local std::minstd_rand generator(std::random_device{}());
+   return std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+}
+
+}
+
+
+RetryPolicy::RetryPolicy(Decide decide)
+   : m_decide(std::move(decide))
+{
+}
+
+
+RetryPolicy RetryPolicy::immediate(std::size_t maxRetries)
+{
+   return RetryPolicy([maxRetries](std::exception_ptr, std::size_t attempt) {
+      Optional<Duration> delay;
+      if (attempt <= maxRetries)
+      {
+         delay.set(Duration::zero());
+      }
+      return delay;
+   });
+}
+
+
+RetryPolicy RetryPolicy::exponentialBackoff(std::size_t maxRetries,
+                                            Duration initialDelay,
+                                            Duration maxDelay,
+                                            double multiplier,
+                                            double jitter)
+{
+   jitter = std::min(std::max(jitter, 0.0), 1.0);
+
+   return RetryPolicy([=](std::exception_ptr, std::size_t attempt) {
+      Optional<Duration> delay;
+      if (attempt > maxRetries)
+      {
+         return delay;
+      }
+
+      // Computed in floating point, where a long series of failures
+      // saturates at maxDelay instead of overflowing.
+      double ticks = initialDelay.count();
+      for (std::size_t i = 1; i < attempt && ticks < maxDelay.count(); ++i)
+      {
+         ticks *= multiplier;
+      }
+      ticks = std::min(ticks, double(maxDelay.count()));
+      ticks *= 1.0 - jitter * uniformRandom();
+
+      delay.set(Duration(Duration::rep(ticks)));
+      return delay;
+   });
+}
+
+
+Optional<RetryPolicy::Duration> RetryPolicy::next(std::exception_ptr error,
+                                                  std::size_t attempt) const
+{
+   return m_decide(std::move(error), attempt);
+}
@@ -0,0 +1,117 @@
+#include "rx/Scheduler.hpp"
+
+Timer::Timer()
+   : m_state(nullptr)
+{
+}
+
+
+Timer::Timer(std::shared_ptr<Timer::State> state)
+   : m_state(std::move(state))
+{
+}
+
+
+void Timer::arm(TimePoint due) const
+{
+   if (m_state)
+   {
+      m_state->arm(due);
+   }
+}
+
+
+void Timer::cancel() const
+{
+   if (m_state)
+   {
+      m_state->cancel();
+   }
+}
+
+
+bool Timer::isArmed() const
+{
+   return m_state && m_state->isArmed();
+}
+
+
+void Timer::dispose() const
+{
+   if (m_state)
+   {
+      m_state->dispose();
+   }
+}
+
+
+Subscription Timer::getSubscription() const
+{
+   auto shared_state = m_state;
+   return Subscription([shared_state]() {
+      if (shared_state)
+      {
+         shared_state->dispose();
+      }
+   });
+}
+
+
+Scheduler::Scheduler(std::shared_ptr<Scheduler::State> state)
+   : m_state(std::move(state))
+{
+}
+
+
+Scheduler::TimePoint Scheduler::now() const
+{
+   return m_state->now();
+}
+
+
+Timer Scheduler::createTimer(Action action) const
+{
+   return m_state->createTimer(std::move(action));
+}
+
+
+Subscription Scheduler::schedule(Action action) const
+{
+   return m_state->schedule(std::move(action));
+}
+
+
+Subscription Scheduler::schedule(TimePoint due, Action action) const
+{
+   auto timer = m_state->createTimer(std::move(action));
+   timer.arm(due);
+   return timer.getSubscription();
+}
+
+
+Subscription Scheduler::schedulePeriodically(TimePoint firstDue,
+                                             Duration period,
+                                             Action action) const
+{
+   // The action re-arms its own timer, which needs a handle to it. The
+   // cycle this creates is broken when the timer is disposed.
+   auto timer = std::make_shared<Timer>();
+   auto due = firstDue;
+
+   *timer = m_state->createTimer([timer, due, period, action]() mutable {
+      due += period;
+      timer->arm(due);
+      action();
+   });
+
+   timer->arm(firstDue);
+   return timer->getSubscription();
+}
+
+
+Subscription Scheduler::State::schedule(Action action)
+{
+   auto timer = createTimer(std::move(action));
+   timer.arm(now());
+   return timer.getSubscription();
+}
@@ -7,7 +7,7 @@ Subscription::Subscription()
 
 
 Subscription::Subscription(Subscription::UnsubscribeFunc unsubscribe)
-   : m_state(std::make_shared<State>(std::move(unsubscribe)))
+   : m_state(std::allocate_shared<State>(PoolAllocator<State>(), std::move(unsubscribe)))
 {
 }
 
@@ -48,8 +48,14 @@ Subscription::Subscription(std::unique_ptr<Subscription::State> state)
 }
 
 
+Subscription::Subscription(std::shared_ptr<Subscription::State> state)
+   : m_state(std::move(state))
+{
+}
+
+
 SubscriptionList::SubscriptionList()
-   : Subscription(std::unique_ptr<State>(new State()))
+   : Subscription(std::allocate_shared<State>(PoolAllocator<State>()))
 {
 }
 
@@ -0,0 +1,107 @@
+#include "rx/internal/MappedFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::system_error lastError(const std::string& what)
+{
+   return std::system_error(errno, std::generic_category(), what);
+}
+
+std::size_t pageSize()
+{
+   static const std::size_t size = std::size_t(sysconf(_SC_PAGESIZE));
+   return size;
+}
+
+}
+
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string& path)
+{
+   int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+   {
+      throw lastError("open " + path);
+   }
+
+   struct stat status;
+   if (fstat(fd, &status) != 0)
+   {
+      auto error = lastError("fstat " + path);
+      ::close(fd);
+      throw error;
+   }
+
+   // mmap rejects empty mappings, an empty file maps to no data.
+   auto size = std::size_t(status.st_size);
+   const char* data = nullptr;
+   if (size > 0)
+   {
+      auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address == MAP_FAILED)
+      {
+         auto error = lastError("mmap " + path);
+         ::close(fd);
+         throw error;
+      }
+      data = static_cast<const char*>(address);
+   }
+
+   // The mapping holds its own reference to the file.
+   ::close(fd);
+   return std::shared_ptr<const MappedFile>(new MappedFile(data, size));
+}
+
+
+MappedFile::MappedFile(const char* data, std::size_t size)
+   : m_data(data),
+     m_size(size)
+{
+}
+
+
+MappedFile::~MappedFile()
+{
+   if (m_data)
+   {
+      munmap(const_cast<char*>(m_data), m_size);
+   }
+}
+
+
+std::string_view MappedFile::data() const
+{
+   return std::string_view(m_data, m_size);
+}
+
+
+void MappedFile::adviseSequential() const
+{
+   if (m_data)
+   {
+      madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+   }
+}
+
+
+void MappedFile::prefetch(std::size_t offset, std::size_t length) const
+{
+   if (!m_data || offset >= m_size)
+   {
+      return;
+   }
+
+   // madvise wants a page aligned start.
+   auto begin = offset - offset % pageSize();
+   auto end = std::min(offset + length, m_size);
+   madvise(const_cast<char*>(m_data) + begin, end - begin, MADV_WILLNEED);
+}
@@ -0,0 +1,56 @@
+#include "rx/internal/ObjectPool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Registry
+{
+   std::mutex m_mutex;
+   std::vector<void (*)()> m_releases;
+   std::atomic<std::size_t> m_allocations{ 0 };
+};
+
+//! Never destroyed, pools may be used during static destruction.
+Registry& registry()
+{
+   static Registry* registry = new Registry();
+   return *registry;
+}
+
+}
+
+
+void ObjectPools::releaseIdle()
+{
+   std::vector<void (*)()> releases;
+   {
+      std::lock_guard<std::mutex> lock(registry().m_mutex);
+      releases = registry().m_releases;
+   }
+   for (auto release : releases)
+   {
+      release();
+   }
+}
+
+
+std::size_t ObjectPools::getAllocationCount()
+{
+   return registry().m_allocations.load(std::memory_order_relaxed);
+}
+
+
+void ObjectPools::registerPool(void (*release)())
+{
+   std::lock_guard<std::mutex> lock(registry().m_mutex);
+   registry().m_releases.push_back(release);
+}
+
+
+void ObjectPools::countAllocation()
+{
+   registry().m_allocations.fetch_add(1, std::memory_order_relaxed);
+}
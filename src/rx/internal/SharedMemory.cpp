@@ -0,0 +1,132 @@
+#include "rx/internal/SharedMemory.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+std::system_error lastError(const std::string& what)
+{
+   return std::system_error(errno, std::generic_category(), what);
+}
+
+void* mapFd(int fd, std::size_t size, const std::string& name)
+{
+   auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (data == MAP_FAILED)
+   {
+      auto error = lastError("mmap " + name);
+      ::close(fd);
+      throw error;
+   }
+   ::close(fd);
+   return data;
+}
+
+}
+
+
+std::shared_ptr<SharedMemory> SharedMemory::create(const std::string& name,
+                                                   std::size_t size)
+{
+   shm_unlink(name.c_str());
+   int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+   {
+      throw lastError("shm_open " + name);
+   }
+   if (ftruncate(fd, off_t(size)) != 0)
+   {
+      auto error = lastError("ftruncate " + name);
+      ::close(fd);
+      shm_unlink(name.c_str());
+      throw error;
+   }
+
+   auto data = mapFd(fd, size, name);
+   return std::shared_ptr<SharedMemory>(new SharedMemory(name, data, size, true));
+}
+
+
+std::shared_ptr<SharedMemory> SharedMemory::open(const std::string& name)
+{
+   int fd = shm_open(name.c_str(), O_RDWR, 0);
+   if (fd < 0)
+   {
+      throw lastError("shm_open " + name);
+   }
+
+   struct stat status;
+   if (fstat(fd, &status) != 0)
+   {
+      auto error = lastError("fstat " + name);
+      ::close(fd);
+      throw error;
+   }
+
+   auto size = std::size_t(status.st_size);
+   auto data = mapFd(fd, size, name);
+   return std::shared_ptr<SharedMemory>(new SharedMemory(name, data, size, false));
+}
+
+
+SharedMemory::SharedMemory(std::string name, void* data, std::size_t size,
+                           bool isOwner)
+   : m_name(std::move(name)),
+     m_data(data),
+     m_size(size),
+     m_isOwner(isOwner)
+{
+}
+
+
+SharedMemory::~SharedMemory()
+{
+   munmap(m_data, m_size);
+   if (m_isOwner)
+   {
+      shm_unlink(m_name.c_str());
+   }
+}
+
+
+void* SharedMemory::data() const
+{
+   return m_data;
+}
+
+
+std::size_t SharedMemory::size() const
+{
+   return m_size;
+}
+
+
+void SharedMemory::futexWait(std::atomic<std::uint32_t>& word,
+                             std::uint32_t expected,
+                             std::chrono::milliseconds timeout)
+{
+   timespec relative;
+   relative.tv_sec = time_t(timeout.count() / 1000);
+   relative.tv_nsec = long(timeout.count() % 1000) * 1000000;
+
+   // Not FUTEX_PRIVATE_FLAG: the word is shared between processes.
+   syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT,
+           expected, &relative, nullptr, 0);
+}
+
+
+void SharedMemory::futexWakeAll(std::atomic<std::uint32_t>& word)
+{
+   syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE,
+           INT_MAX, nullptr, nullptr, 0);
+}
@@ -0,0 +1,337 @@
+#include "rx/schedulers/EpollScheduler.hpp"
+#include "rx/schedulers/TimingWheel.hpp"
+#include "rx/internal/FlatHashMap.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+//! epoll data of the eventfd, watches count up from 1.
+const std::uint64_t WAKEUP_ID = 0;
+
+const int MAX_EVENTS = 256;
+
+std::system_error lastError(const char* what)
+{
+   return std::system_error(errno, std::generic_category(), what);
+}
+
+class EpollCore;
+
+//! The core whose loop runs on this thread, if any.
+thread_local const EpollCore* t_loop = nullptr;
+
+struct Watch
+{
+   Watch(int fd, EpollScheduler::FdHandler handler, std::function<void()> onStopped)
+         : m_fd(fd),
+           m_handler(std::move(handler)),
+           m_onStopped(std::move(onStopped)),
+           m_isCancelled(false)
+   {
+   }
+
+   const int m_fd;
+   const EpollScheduler::FdHandler m_handler;
+   const std::function<void()> m_onStopped;
+   std::atomic<bool> m_isCancelled;
+
+   //! Held while the handler runs, so that unwatching from another thread
+   //! can wait for it.
+   std::mutex m_dispatchMutex;
+};
+
+//! What the loop thread shares. Kept apart from the scheduler state so
+//! that the last handle may be dropped by an action on the loop thread,
+//! which then finishes its loop on the core it owns. The fds are closed
+//! once the loop and every watch are done with the core.
+class EpollCore : public std::enable_shared_from_this<EpollCore>
+{
+public:
+   typedef Scheduler::Clock Clock;
+   typedef Scheduler::TimePoint TimePoint;
+
+   EpollCore()
+         : m_epollFd(epoll_create1(EPOLL_CLOEXEC)),
+           m_wakeupFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+           m_nextId(WAKEUP_ID + 1),
+           m_isStopped(false)
+   {
+      if (m_epollFd < 0 || m_wakeupFd < 0)
+      {
+         auto error = lastError("epoll scheduler");
+         closeFds();
+         throw error;
+      }
+
+      epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.u64 = WAKEUP_ID;
+      if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeupFd, &event) != 0)
+      {
+         auto error = lastError("epoll_ctl");
+         closeFds();
+         throw error;
+      }
+   }
+
+   ~EpollCore()
+   {
+      closeFds();
+   }
+
+   void start(Scheduler::Duration resolution)
+   {
+      std::weak_ptr<EpollCore> weak_core = shared_from_this();
+      m_wheel = TimingWheel::create(resolution, Clock::now(), [weak_core]() {
+         if (auto core = weak_core.lock())
+         {
+            core->wakeup();
+         }
+      });
+   }
+
+   void stop()
+   {
+      m_isStopped.store(true, std::memory_order_release);
+      wakeup();
+   }
+
+   Timer createTimer(Scheduler::Action action)
+   {
+      return m_wheel->createTimer(std::move(action));
+   }
+
+   std::uint64_t watch(const std::shared_ptr<Watch>& watch, std::uint32_t events)
+   {
+      std::uint64_t id;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         id = m_nextId++;
+         bool isCreated;
+         m_watches.findOrCreate(id, [&watch]() { return watch; }, isCreated);
+      }
+
+      epoll_event event{};
+      event.events = events | EPOLLET;
+      event.data.u64 = id;
+      if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, watch->m_fd, &event) != 0)
+      {
+         auto error = lastError("epoll_ctl");
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_watches.erase(id);
+         throw error;
+      }
+      return id;
+   }
+
+   //! Once this returns the handler of watch is not running and will not
+   //! run again, unless it is the loop thread itself that unwatches.
+   void unwatch(Watch& watch, std::uint64_t id)
+   {
+      if (!watch.m_isCancelled.exchange(true, std::memory_order_acq_rel))
+      {
+         // The fd may already be closed, which has removed it from the
+         // epoll set anyway.
+         epoll_ctl(m_epollFd, EPOLL_CTL_DEL, watch.m_fd, nullptr);
+
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_watches.erase(id);
+      }
+
+      if (t_loop != this)
+      {
+         std::lock_guard<std::mutex> wait(watch.m_dispatchMutex);
+      }
+   }
+
+   void run()
+   {
+      t_loop = this;
+      epoll_event events[MAX_EVENTS];
+
+      while (!m_isStopped.load(std::memory_order_acquire))
+      {
+         m_wheel->advance(Clock::now());
+
+         int timeout = -1;
+         auto next = m_wheel->nextExpiry();
+         if (next != TimePoint::max())
+         {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+                  next - Clock::now());
+            timeout = int(std::max<std::chrono::milliseconds::rep>(
+                  remaining.count(), 0));
+         }
+
+         int count = epoll_wait(m_epollFd, events, MAX_EVENTS, timeout);
+         for (int i = 0; i < count; i++)
+         {
+            if (events[i].data.u64 == WAKEUP_ID)
+            {
+               std::uint64_t value;
+               auto read = ::read(m_wakeupFd, &value, sizeof(value));
+               (void)read;
+               continue;
+            }
+            dispatch(events[i].data.u64, events[i].events);
+         }
+      }
+      t_loop = nullptr;
+   }
+
+private:
+   void wakeup()
+   {
+      std::uint64_t one = 1;
+      auto written = write(m_wakeupFd, &one, sizeof(one));
+      (void)written;
+   }
+
+   void dispatch(std::uint64_t id, std::uint32_t events)
+   {
+      std::shared_ptr<Watch> watch;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (auto found = m_watches.find(id))
+         {
+            watch = *found;
+         }
+      }
+      if (!watch)
+      {
+         return;
+      }
+
+      std::lock_guard<std::mutex> lock(watch->m_dispatchMutex);
+      if (!watch->m_isCancelled.load(std::memory_order_acquire)
+          && !watch->m_handler(events))
+      {
+         unwatch(*watch, id);
+         if (watch->m_onStopped)
+         {
+            watch->m_onStopped();
+         }
+      }
+   }
+
+   void closeFds()
+   {
+      if (m_epollFd >= 0)
+      {
+         close(m_epollFd);
+      }
+      if (m_wakeupFd >= 0)
+      {
+         close(m_wakeupFd);
+      }
+   }
+
+   const int m_epollFd;
+   const int m_wakeupFd;
+   std::shared_ptr<TimingWheel> m_wheel;
+
+   std::mutex m_mutex;
+   FlatHashMap<std::uint64_t, std::shared_ptr<Watch>> m_watches;
+   std::uint64_t m_nextId;
+
+   std::atomic<bool> m_isStopped;
+};
+
+}
+
+
+class EpollScheduler::State : public Scheduler::State,
+                              public std::enable_shared_from_this<EpollScheduler::State>
+{
+public:
+   State(Duration resolution)
+         : m_core(std::make_shared<EpollCore>())
+   {
+      m_core->start(resolution);
+      auto core = m_core;
+      m_thread = std::thread([core]() {
+         core->run();
+      });
+   }
+
+   ~State()
+   {
+      m_core->stop();
+
+      // The last handle may be dropped by an action running on the loop
+      // thread itself, which cannot join itself.
+      if (m_thread.get_id() == std::this_thread::get_id())
+      {
+         m_thread.detach();
+      }
+      else
+      {
+         m_thread.join();
+      }
+   }
+
+   TimePoint now() const override
+   {
+      return Clock::now();
+   }
+
+   Timer createTimer(Action action) override
+   {
+      return m_core->createTimer(std::move(action));
+   }
+
+   Subscription watch(int fd, std::uint32_t events, FdHandler handler,
+                      std::function<void()> onStopped)
+   {
+      auto watch = std::make_shared<Watch>(fd, std::move(handler), std::move(onStopped));
+      auto id = m_core->watch(watch, events);
+
+      // Keeps the loop running for as long as the watch is.
+      auto shared_state = shared_from_this();
+      return Subscription([shared_state, watch, id]() {
+         shared_state->m_core->unwatch(*watch, id);
+      });
+   }
+
+private:
+   std::shared_ptr<EpollCore> m_core;
+   std::thread m_thread;
+};
+
+
+EpollScheduler EpollScheduler::create(Duration resolution)
+{
+   return EpollScheduler(std::make_shared<State>(resolution));
+}
+
+
+EpollScheduler EpollScheduler::getDefault()
+{
+   static EpollScheduler scheduler = create();
+   return scheduler;
+}
+
+
+Subscription EpollScheduler::watch(int fd, std::uint32_t events,
+                                   FdHandler handler,
+                                   std::function<void()> onStopped) const
+{
+   return static_cast<State&>(*m_state).watch(fd, events, std::move(handler),
+                                              std::move(onStopped));
+}
+
+
+EpollScheduler::EpollScheduler(std::shared_ptr<State> state)
+   : Scheduler(std::move(state))
+{
+}
@@ -0,0 +1,70 @@
+#include "rx/schedulers/TestScheduler.hpp"
+#include "rx/schedulers/TimingWheel.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+class TestScheduler::State : public Scheduler::State
+{
+public:
+   State(Duration resolution)
+         : m_wheel(TimingWheel::create(resolution, TimePoint())),
+           m_now()
+   {
+   }
+
+   TimePoint now() const override
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_now;
+   }
+
+   Timer createTimer(Action action) override
+   {
+      return m_wheel->createTimer(std::move(action));
+   }
+
+   void advanceTimeTo(TimePoint target)
+   {
+      // Step from one tick with work to the next so that now() reads the
+      // time of the tick whose actions are running.
+      while (now() < target)
+      {
+         auto next = std::min(target, m_wheel->nextExpiry());
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_now = next;
+         }
+         m_wheel->advance(next);
+      }
+   }
+
+private:
+   std::shared_ptr<TimingWheel> m_wheel;
+   mutable std::mutex m_mutex;
+   TimePoint m_now;
+};
+
+
+TestScheduler TestScheduler::create(Duration resolution)
+{
+   return TestScheduler(std::make_shared<State>(resolution));
+}
+
+
+void TestScheduler::advanceTimeBy(Duration delta) const
+{
+   advanceTimeTo(now() + delta);
+}
+
+
+void TestScheduler::advanceTimeTo(TimePoint t) const
+{
+   std::static_pointer_cast<State>(m_state)->advanceTimeTo(t);
+}
+
+
+TestScheduler::TestScheduler(std::shared_ptr<State> state)
+   : Scheduler(std::move(state))
+{
+}
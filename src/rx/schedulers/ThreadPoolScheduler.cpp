@@ -0,0 +1,176 @@
+#include "rx/schedulers/ThreadPoolScheduler.hpp"
+#include "rx/schedulers/TimingWheelScheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+//! What the pool threads share. Kept apart from the scheduler state so
+//! that the last handle may be dropped by an action on a pool thread.
+struct RunQueue
+{
+   RunQueue()
+         : m_isStopped(false)
+   {
+   }
+
+   void post(Scheduler::Action action)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_actions.push_back(std::move(action));
+      }
+      m_condition.notify_one();
+   }
+
+   void stop()
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_isStopped = true;
+         m_actions.clear();
+      }
+      m_condition.notify_all();
+   }
+
+   void run()
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      for (;;)
+      {
+         m_condition.wait(lock, [this]() {
+            return m_isStopped || !m_actions.empty();
+         });
+         if (m_isStopped)
+         {
+            return;
+         }
+
+         auto action = std::move(m_actions.front());
+         m_actions.pop_front();
+         lock.unlock();
+         action();
+         action = nullptr;
+         lock.lock();
+      }
+   }
+
+   std::mutex m_mutex;
+   std::condition_variable m_condition;
+   std::deque<Scheduler::Action> m_actions;
+   bool m_isStopped;
+};
+
+}
+
+
+class ThreadPoolScheduler::State : public Scheduler::State
+{
+public:
+   State(std::size_t threadCount)
+         : m_queue(std::make_shared<RunQueue>()),
+           m_timers(TimingWheelScheduler::getDefault())
+   {
+      for (std::size_t i = 0; i < threadCount; ++i)
+      {
+         auto queue = m_queue;
+         m_threads.emplace_back([queue]() {
+            queue->run();
+         });
+      }
+   }
+
+   ~State()
+   {
+      m_queue->stop();
+
+      // The last handle may be dropped by an action running on one of the
+      // pool threads, which cannot join itself.
+      for (auto& thread : m_threads)
+      {
+         if (thread.get_id() == std::this_thread::get_id())
+         {
+            thread.detach();
+         }
+         else
+         {
+            thread.join();
+         }
+      }
+   }
+
+   TimePoint now() const override
+   {
+      return Clock::now();
+   }
+
+   Timer createTimer(Action action) override
+   {
+      std::weak_ptr<RunQueue> weak_queue = m_queue;
+      return m_timers.createTimer([weak_queue, action]() {
+         if (auto queue = weak_queue.lock())
+         {
+            queue->post(action);
+         }
+      });
+   }
+
+   Subscription schedule(Action action) override
+   {
+      auto isCancelled = std::make_shared<std::atomic<bool>>(false);
+      m_queue->post([isCancelled, action]() {
+         if (!isCancelled->load(std::memory_order_acquire))
+         {
+            action();
+         }
+      });
+      return Subscription([isCancelled]() {
+         isCancelled->store(true, std::memory_order_release);
+      });
+   }
+
+   std::size_t getThreadCount() const
+   {
+      return m_threads.size();
+   }
+
+private:
+   std::shared_ptr<RunQueue> m_queue;
+   TimingWheelScheduler m_timers;
+   std::vector<std::thread> m_threads;
+};
+
+
+ThreadPoolScheduler ThreadPoolScheduler::create(std::size_t threadCount)
+{
+   if (threadCount == 0)
+   {
+      threadCount = std::max(1u, std::thread::hardware_concurrency());
+   }
+   return ThreadPoolScheduler(std::make_shared<State>(threadCount));
+}
+
+
+ThreadPoolScheduler ThreadPoolScheduler::getDefault()
+{
+   static ThreadPoolScheduler scheduler = create();
+   return scheduler;
+}
+
+
+std::size_t ThreadPoolScheduler::getThreadCount() const
+{
+   return static_cast<State&>(*m_state).getThreadCount();
+}
+
+
+ThreadPoolScheduler::ThreadPoolScheduler(std::shared_ptr<State> state)
+   : Scheduler(std::move(state))
+{
+}
@@ -0,0 +1,410 @@
+#include "rx/schedulers/TimingWheel.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace {
+
+const std::uint64_t SLOT_MASK = TimingWheel::SLOTS - 1;
+
+const std::uint64_t MAX_DELTA =
+      (std::uint64_t(1) << (TimingWheel::LEVEL_BITS * TimingWheel::LEVELS)) - 1;
+
+std::uint64_t levelSpan(int level)
+{
+   return std::uint64_t(1) << (TimingWheel::LEVEL_BITS * level);
+}
+
+}
+
+
+class TimingWheel::TimerState
+      : public Timer::State,
+        public TimingWheel::Link,
+        public std::enable_shared_from_this<TimingWheel::TimerState>
+{
+public:
+   TimerState(std::weak_ptr<TimingWheel> wheel, Action action)
+         : m_wheel(std::move(wheel)),
+           m_action(std::move(action)),
+           m_expiry(0),
+           m_firing(false),
+           m_disposed(false)
+   {
+   }
+
+   void arm(TimePoint due) override
+   {
+      if (auto wheel = m_wheel.lock())
+      {
+         wheel->arm(*this, due);
+      }
+   }
+
+   void cancel() override
+   {
+      if (auto wheel = m_wheel.lock())
+      {
+         wheel->cancel(*this);
+      }
+   }
+
+   bool isArmed() const override
+   {
+      if (auto wheel = m_wheel.lock())
+      {
+         std::lock_guard<std::mutex> lock(wheel->m_mutex);
+         return isLinked();
+      }
+      return false;
+   }
+
+   void dispose() override
+   {
+      if (auto wheel = m_wheel.lock())
+      {
+         wheel->dispose(*this);
+      }
+      else
+      {
+         m_action = nullptr;
+      }
+   }
+
+   std::weak_ptr<TimingWheel> m_wheel;
+   Action m_action;
+   std::uint64_t m_expiry;
+
+   //! Keeps the timer alive while it is armed or firing, so that an armed
+   //! timer fires even if nobody holds on to its handle.
+   std::shared_ptr<TimerState> m_self;
+   bool m_firing;
+   bool m_disposed;
+};
+
+
+std::shared_ptr<TimingWheel> TimingWheel::create(Duration resolution,
+                                                 TimePoint origin,
+                                                 WakeupFunc onWakeup)
+{
+   return std::shared_ptr<TimingWheel>(
+         new TimingWheel(resolution, origin, std::move(onWakeup)));
+}
+
+
+TimingWheel::TimingWheel(Duration resolution, TimePoint origin,
+                         WakeupFunc onWakeup)
+   : m_resolution(resolution),
+     m_origin(origin),
+     m_onWakeup(std::move(onWakeup)),
+     m_tick(0),
+     m_plannedTick(std::numeric_limits<std::uint64_t>::max()),
+     m_count(0)
+{
+   for (auto& level : m_slots)
+   {
+      for (auto& slot : level)
+      {
+         initList(slot);
+      }
+   }
+   initList(m_expired);
+}
+
+
+TimingWheel::~TimingWheel()
+{
+   std::vector<std::shared_ptr<TimerState>> released;
+
+   auto releaseList = [&released](Link& head) {
+      while (!isEmpty(head))
+      {
+         auto& timer = static_cast<TimerState&>(*head.m_next);
+         auto next = timer.m_next;
+         head.m_next = next;
+         next->m_prev = &head;
+         timer.m_prev = timer.m_next = nullptr;
+         released.push_back(std::move(timer.m_self));
+      }
+   };
+
+   for (auto& level : m_slots)
+   {
+      for (auto& slot : level)
+      {
+         releaseList(slot);
+      }
+   }
+   releaseList(m_expired);
+}
+
+
+Timer TimingWheel::createTimer(Action action)
+{
+   return Timer(std::make_shared<TimerState>(shared_from_this(),
+                                             std::move(action)));
+}
+
+
+void TimingWheel::advance(TimePoint now)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   auto target = now > m_origin ? std::uint64_t((now - m_origin) / m_resolution)
+                                : std::uint64_t(0);
+
+   while (m_tick < target)
+   {
+      if (m_count == 0)
+      {
+         m_tick = target;
+         break;
+      }
+
+      ++m_tick;
+
+      for (int level = 1; level < LEVELS; ++level)
+      {
+         if ((m_tick & (levelSpan(level) - 1)) != 0)
+         {
+            break;
+         }
+         cascade(level, int((m_tick >> (LEVEL_BITS * level)) & SLOT_MASK));
+      }
+
+      auto& slot = m_slots[0][m_tick & SLOT_MASK];
+      if (!isEmpty(slot))
+      {
+         m_expired.m_next = slot.m_next;
+         m_expired.m_prev = slot.m_prev;
+         m_expired.m_next->m_prev = &m_expired;
+         m_expired.m_prev->m_next = &m_expired;
+         initList(slot);
+      }
+
+      while (!isEmpty(m_expired))
+      {
+         auto& timer = static_cast<TimerState&>(*m_expired.m_next);
+         unlink(timer);
+         timer.m_firing = true;
+         auto self = std::move(timer.m_self);
+
+         lock.unlock();
+         self->m_action();
+
+         Action released;
+         lock.lock();
+         self->m_firing = false;
+         if (self->m_disposed)
+         {
+            released.swap(self->m_action);
+         }
+
+         lock.unlock();
+         released = nullptr;
+         self.reset();
+         lock.lock();
+      }
+   }
+}
+
+
+bool TimingWheel::empty() const
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_count == 0;
+}
+
+
+TimingWheel::TimePoint TimingWheel::nextExpiry() const
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   if (m_count == 0)
+   {
+      m_plannedTick = std::numeric_limits<std::uint64_t>::max();
+      return TimePoint::max();
+   }
+
+   // Level 0 holds everything due before the next level 1 boundary, so
+   // the scan stops there at the latest; a cascade may be due at that tick.
+   auto tick = m_tick + 1;
+   while ((tick & SLOT_MASK) != 0 && isEmpty(m_slots[0][tick & SLOT_MASK]))
+   {
+      ++tick;
+   }
+
+   m_plannedTick = tick;
+   return toTimePoint(tick);
+}
+
+
+TimingWheel::Duration TimingWheel::getResolution() const
+{
+   return m_resolution;
+}
+
+
+void TimingWheel::arm(TimerState& timer, TimePoint due)
+{
+   bool wakeup = false;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (timer.m_disposed)
+      {
+         return;
+      }
+
+      if (timer.isLinked())
+      {
+         unlink(timer);
+      }
+      else if (!timer.m_self)
+      {
+         timer.m_self = timer.shared_from_this();
+      }
+
+      // The current tick has already been processed, so the earliest a
+      // timer can fire is the next one.
+      timer.m_expiry = std::max(toTick(due), m_tick + 1);
+      insert(timer);
+
+      if (timer.m_expiry < m_plannedTick)
+      {
+         m_plannedTick = timer.m_expiry;
+         wakeup = true;
+      }
+   }
+
+   if (wakeup && m_onWakeup)
+   {
+      m_onWakeup();
+   }
+}
+
+
+void TimingWheel::cancel(TimerState& timer)
+{
+   std::shared_ptr<TimerState> self;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (timer.isLinked())
+      {
+         unlink(timer);
+      }
+      self = std::move(timer.m_self);
+   }
+}
+
+
+void TimingWheel::dispose(TimerState& timer)
+{
+   std::shared_ptr<TimerState> self;
+   Action released;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      timer.m_disposed = true;
+      if (timer.isLinked())
+      {
+         unlink(timer);
+      }
+      self = std::move(timer.m_self);
+
+      // A firing action is released by advance() once it has returned.
+      if (!timer.m_firing)
+      {
+         released.swap(timer.m_action);
+      }
+   }
+}
+
+
+std::uint64_t TimingWheel::toTick(TimePoint t) const
+{
+   if (t <= m_origin)
+   {
+      return 0;
+   }
+
+   auto elapsed = t - m_origin;
+   auto tick = std::uint64_t(elapsed / m_resolution);
+   if (elapsed % m_resolution != Duration::zero())
+   {
+      ++tick;
+   }
+   return tick;
+}
+
+
+TimingWheel::TimePoint TimingWheel::toTimePoint(std::uint64_t tick) const
+{
+   return m_origin + m_resolution * tick;
+}
+
+
+void TimingWheel::insert(TimerState& timer)
+{
+   auto delta = timer.m_expiry - m_tick;
+
+   int level = 0;
+   while (level < LEVELS - 1 && delta >= levelSpan(level + 1))
+   {
+      ++level;
+   }
+
+   // Timers beyond the span of the wheel park in the farthest slot of the
+   // top level and are placed again, with their real expiry, when it
+   // cascades.
+   auto expiry = delta > MAX_DELTA ? m_tick + MAX_DELTA : timer.m_expiry;
+   auto slot = (expiry >> (LEVEL_BITS * level)) & SLOT_MASK;
+
+   pushBack(m_slots[level][slot], timer);
+   ++m_count;
+}
+
+
+void TimingWheel::unlink(TimerState& timer)
+{
+   timer.m_prev->m_next = timer.m_next;
+   timer.m_next->m_prev = timer.m_prev;
+   timer.m_prev = timer.m_next = nullptr;
+   --m_count;
+}
+
+
+void TimingWheel::cascade(int level, int slot)
+{
+   auto& head = m_slots[level][slot];
+   while (!isEmpty(head))
+   {
+      auto& timer = static_cast<TimerState&>(*head.m_next);
+      unlink(timer);
+      insert(timer);
+   }
+}
+
+
+void TimingWheel::initList(Link& head)
+{
+   head.m_prev = &head;
+   head.m_next = &head;
+}
+
+
+void TimingWheel::pushBack(Link& head, Link& link)
+{
+   link.m_prev = head.m_prev;
+   link.m_next = &head;
+   head.m_prev->m_next = &link;
+   head.m_prev = &link;
+}
+
+
+bool TimingWheel::isEmpty(const Link& head)
+{
+   return head.m_next == &head;
+}
@@ -0,0 +1,151 @@
+#include "rx/schedulers/TimingWheelScheduler.hpp"
+#include "rx/schedulers/TimingWheel.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+//! What the wheel thread shares. Kept apart from the scheduler state so
+//! that the last handle may be dropped by an action on the wheel thread,
+//! which then finishes its loop on the core it owns.
+struct WheelCore : std::enable_shared_from_this<WheelCore>
+{
+   typedef Scheduler::Clock Clock;
+   typedef Scheduler::TimePoint TimePoint;
+
+   WheelCore()
+         : m_isStopped(false),
+           m_isWakeupPending(false)
+   {
+   }
+
+   void start(Scheduler::Duration resolution)
+   {
+      std::weak_ptr<WheelCore> weak_core = shared_from_this();
+      m_wheel = TimingWheel::create(resolution, Clock::now(), [weak_core]() {
+         if (auto core = weak_core.lock())
+         {
+            core->wakeup();
+         }
+      });
+   }
+
+   void stop()
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_isStopped = true;
+      }
+      m_condition.notify_one();
+   }
+
+   void wakeup()
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_isWakeupPending = true;
+      }
+      m_condition.notify_one();
+   }
+
+   void run()
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_isStopped)
+      {
+         lock.unlock();
+         m_wheel->advance(Clock::now());
+         auto next = m_wheel->nextExpiry();
+         lock.lock();
+
+         auto isAwoken = [this]() {
+            return m_isStopped || m_isWakeupPending;
+         };
+
+         if (next == TimePoint::max())
+         {
+            m_condition.wait(lock, isAwoken);
+         }
+         else
+         {
+            m_condition.wait_until(lock, next, isAwoken);
+         }
+         m_isWakeupPending = false;
+      }
+   }
+
+   std::shared_ptr<TimingWheel> m_wheel;
+   std::mutex m_mutex;
+   std::condition_variable m_condition;
+   bool m_isStopped;
+   bool m_isWakeupPending;
+};
+
+}
+
+
+class TimingWheelScheduler::State : public Scheduler::State
+{
+public:
+   State(Duration resolution)
+         : m_core(std::make_shared<WheelCore>())
+   {
+      m_core->start(resolution);
+      auto core = m_core;
+      m_thread = std::thread([core]() {
+         core->run();
+      });
+   }
+
+   ~State()
+   {
+      m_core->stop();
+
+      // The last handle may be dropped by an action running on the wheel
+      // thread itself, which cannot join itself.
+      if (m_thread.get_id() == std::this_thread::get_id())
+      {
+         m_thread.detach();
+      }
+      else
+      {
+         m_thread.join();
+      }
+   }
+
+   TimePoint now() const override
+   {
+      return Clock::now();
+   }
+
+   Timer createTimer(Action action) override
+   {
+      return m_core->m_wheel->createTimer(std::move(action));
+   }
+
+private:
+   std::shared_ptr<WheelCore> m_core;
+   std::thread m_thread;
+};
+
+
+TimingWheelScheduler TimingWheelScheduler::create(Duration resolution)
+{
+   return TimingWheelScheduler(std::make_shared<State>(resolution));
+}
+
+
+TimingWheelScheduler TimingWheelScheduler::getDefault()
+{
+   static TimingWheelScheduler scheduler = create();
+   return scheduler;
+}
+
+
+TimingWheelScheduler::TimingWheelScheduler(std::shared_ptr<State> state)
+   : Scheduler(std::move(state))
+{
+}
@@ -0,0 +1,36 @@
+#include "rx/schedulers/Trampoline.hpp"
+
+Trampoline::Trampoline()
+      : m_isActive(false)
+{
+}
+
+
+bool Trampoline::isActive() const
+{
+   return m_isActive;
+}
+
+
+void Trampoline::defer(Action action)
+{
+   m_queue.push_back(std::move(action));
+}
+
+
+void Trampoline::drain()
+{
+   while (!m_queue.empty())
+   {
+      auto action = std::move(m_queue.front());
+      m_queue.pop_front();
+      action();
+   }
+}
+
+
+void Trampoline::abort()
+{
+   m_queue.clear();
+   m_isActive = false;
+}
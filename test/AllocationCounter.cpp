@@ -0,0 +1,39 @@
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local std::size_t t_allocations = 0;
+
+}
+
+
+std::size_t getHeapAllocationCount()
+{
+   return t_allocations;
+}
+
+
+void* operator new(std::size_t size)
+{
+   ++t_allocations;
+   if (auto p = std::malloc(size == 0 ? 1 : size))
+   {
+      return p;
+   }
+   throw std::bad_alloc();
+}
+
+
+void operator delete(void* p) noexcept
+{
+   std::free(p);
+}
+
+
+void operator delete(void* p, std::size_t) noexcept
+{
+   std::free(p);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+//! Calls the calling thread has made to the global operator new so far.
+//! Counted by the replacement operator new of the test executable.
+std::size_t getHeapAllocationCount();
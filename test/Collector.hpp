@@ -0,0 +1,84 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include "rx/Observable.hpp"
+
+//! Collects what an Observable emits on other threads and lets the test
+//! wait for the end of the stream.
+template<class T>
+class Collector
+{
+public:
+   //! For subscriptions the test sets up itself with getObserver().
+   Collector()
+         : m_isError(false)
+   {
+      m_done = m_promise.get_future().share();
+   }
+
+   //! Subscribes to observable and waits for it to terminate.
+   explicit Collector(const Observable<T>& observable)
+         : Collector()
+   {
+      m_subscription = observable.subscribe(getObserver());
+      waitForCompletion();
+   }
+
+   Collector(const Collector&) = delete;
+   Collector& operator=(const Collector&) = delete;
+
+   //! Refers to this collector, which must outlive the subscription.
+   Observer<T> getObserver()
+   {
+      return Observer<T>(
+         // onNext
+         [this](const T& t) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_values.push_back(t);
+         },
+         // onCompleted
+         [this]() {
+            m_promise.set_value();
+         },
+         // onError
+         [this](std::exception_ptr) {
+            m_isError.store(true, std::memory_order_release);
+            m_promise.set_value();
+         });
+   }
+
+   //! Returns false if the stream failed.
+   bool waitForCompletion()
+   {
+      EXPECT_EQ(std::future_status::ready,
+                m_done.wait_for(std::chrono::seconds(10)));
+      return !isError();
+   }
+
+   std::vector<T> getValues()
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_values;
+   }
+
+   bool isError() const
+   {
+      return m_isError.load(std::memory_order_acquire);
+   }
+
+private:
+   std::mutex m_mutex;
+   std::vector<T> m_values;
+   std::promise<void> m_promise;
+   std::shared_future<void> m_done;
+   std::atomic<bool> m_isError;
+   Subscription m_subscription;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "rx/Observable.hpp"
+
+//! Subscribes to provided Observable and stores all
+//! values that the Observable emits.
+template<class T>
+class Recorder
+{
+public:
+   template<class U>
+   static Recorder<U> create(Observable<U> o)
+   {
+      return Recorder<U>(o);
+   }
+
+   const std::vector<T>& toVector() const
+   {
+      return m_state->m_recording;
+   }
+
+   bool isCompleted() const
+   {
+      return m_state->m_isCompleted;
+   }
+
+   void unsubscribe()
+   {
+      m_state->m_compositeSubscription.unsubscribe();
+   }
+
+private:
+   Recorder(Observable<T> o)
+         : m_state(std::make_shared<State>())
+   {
+      auto shared_state = m_state;
+      auto subscription = o.subscribe(Observer<T>(
+         // onNext
+         [shared_state](const T& t)
+         {
+            if (!shared_state->m_isCompleted)
+            {
+               shared_state->m_recording.push_back(t);
+            }
+         },
+         // onCompleted
+         [shared_state]()
+         {
+            shared_state->m_isCompleted = true;
+         }));
+
+      m_state->m_compositeSubscription.add(subscription);
+   }
+
+   void add(const T& t)
+   {
+      m_state->m_recording.push_back(t);
+   }
+
+   struct State
+   {
+      State()
+            : m_isCompleted(false),
+              m_recording()
+      {
+      }
+      bool m_isCompleted;
+      std::vector<T> m_recording;
+      SubscriptionList m_compositeSubscription;
+   };
+
+   std::shared_ptr<State> m_state;
+};
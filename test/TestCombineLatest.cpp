@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "rx/operators/CombineLatest.hpp"
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "Recorder.hpp"
+
+#include <iostream>
+#include <thread>
+
+namespace {
+
+TEST(combineLatest, combinesLatestElements)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<std::string>::create();
+   auto recorder = Recorder<std::string>::create(
+         combineLatest(a, b, [](const int& x, const std::string& y) {
+            return std::to_string(x) + y;
+         }));
+
+   a.onNext(1);
+   a.onNext(2);
+   ASSERT_TRUE(recorder.toVector().empty());
+
+   b.onNext("a");
+   a.onNext(3);
+   b.onNext("b");
+
+   std::vector<std::string> expected{ "2a", "3a", "3b" };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(combineLatest, completesWhenAllSourcesComplete)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         combineLatest(a, b, [](int x, int y) { return x + y; }));
+
+   a.onNext(1);
+   b.onNext(10);
+   a.onCompleted();
+   ASSERT_FALSE(recorder.isCompleted());
+
+   b.onNext(20);
+   b.onCompleted();
+
+   std::vector<int> expected{ 11, 21 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(combineLatest, completesIfSourceCompletesEmpty)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         combineLatest(a, b, [](int x, int y) { return x + y; }));
+
+   a.onNext(1);
+   b.onCompleted();
+
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(combineLatest, combinerIsNeverCalledConcurrently)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   std::atomic<int> active(0);
+   std::atomic<bool> isOverlapping(false);
+   int last = 0;
+
+   combineLatest(a, b, [&](int x, int y) {
+      if (active.fetch_add(1) != 0)
+      {
+         isOverlapping = true;
+      }
+      active.fetch_sub(1);
+      return x + y;
+   }).subscribe([&last](const int& x) {
+      last = x;
+   });
+
+   const int COUNT = 100000;
+   std::thread producer([&a]() {
+      for (int i = 1; i <= COUNT; i++)
+      {
+         a.onNext(i);
+      }
+   });
+   for (int i = 1; i <= COUNT; i++)
+   {
+      b.onNext(i);
+   }
+   producer.join();
+
+   // Once both producers are done, one more element drains the final
+   // value of both sources on this thread.
+   a.onNext(COUNT);
+   ASSERT_FALSE(isOverlapping);
+   ASSERT_EQ(2 * COUNT, last);
+}
+
+// Performance measurements
+TEST(combineLatest, combineLatestPerf)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   combineLatest(a, b, [](int x, int y) { return x + y; }).subscribe([](const int&) {
+      // do nothing
+   });
+
+   auto start = std::chrono::system_clock::now();
+   auto CYCLE_COUNT = 1e6;
+
+   for (int i = 0; i < CYCLE_COUNT; i++)
+   {
+      a.onNext(i);
+      b.onNext(i);
+   }
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "combineLatest duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
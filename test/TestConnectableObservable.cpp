@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+#include "rx/operators/Range.hpp"
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "Recorder.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+//! Counts the subscriptions to source and the elements it emits.
+template<class T>
+Observable<T> counted(Observable<T> source, std::shared_ptr<int> subscriptions,
+                      std::shared_ptr<int> elements = std::make_shared<int>(0))
+{
+   return Observable<T>::create([source, subscriptions, elements](Subscriber<T> s) {
+      ++*subscriptions;
+      auto o = s.getObserver();
+      Subscriber<T> inner(Observer<T>(
+         [o, elements](const T& t) {
+            ++*elements;
+            o.onNext(t);
+         },
+         [o]() { o.onCompleted(); },
+         [o](std::exception_ptr e) { o.onError(e); }));
+      s.add(inner.getSubscription());
+      source.unsafeSubscribe(inner);
+   });
+}
+
+TEST(publish, subscribesOnceOnConnect)
+{
+   auto subscriptions = std::make_shared<int>(0);
+   auto published = counted(range(1, 3), subscriptions).publish();
+
+   auto first = Recorder<int>::create(published);
+   auto second = Recorder<int>::create(published);
+   ASSERT_EQ(0, *subscriptions);
+   ASSERT_TRUE(first.toVector().empty());
+
+   published.connect();
+
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(1, *subscriptions);
+   ASSERT_EQ(expected, first.toVector());
+   ASSERT_EQ(expected, second.toVector());
+   ASSERT_TRUE(first.isCompleted());
+   ASSERT_TRUE(second.isCompleted());
+}
+
+TEST(publish, disconnectStopsElements)
+{
+   auto s = Subject<int>::create();
+   auto published = s.publish();
+   auto recorder = Recorder<int>::create(published);
+
+   auto connection = published.connect();
+   s.onNext(1);
+   connection.unsubscribe();
+   s.onNext(2);
+
+   ASSERT_EQ(std::vector<int>{ 1 }, recorder.toVector());
+}
+
+TEST(share, connectsForFirstAndDisconnectsAfterLastSubscriber)
+{
+   auto s = Subject<int>::create();
+   auto subscriptions = std::make_shared<int>(0);
+   auto elements = std::make_shared<int>(0);
+   auto shared = counted(Observable<int>(s), subscriptions, elements).share();
+
+   auto first = Recorder<int>::create(shared);
+   s.onNext(1);
+   auto second = Recorder<int>::create(shared);
+   s.onNext(2);
+
+   ASSERT_EQ(1, *subscriptions);
+   ASSERT_EQ(2, *elements);
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, first.toVector());
+   ASSERT_EQ(std::vector<int>{ 2 }, second.toVector());
+
+   first.unsubscribe();
+   s.onNext(3);
+   second.unsubscribe();
+   s.onNext(4);
+   ASSERT_EQ(3, *elements);
+
+   // A new subscriber connects again.
+   auto third = Recorder<int>::create(shared);
+   s.onNext(5);
+   ASSERT_EQ(2, *subscriptions);
+   ASSERT_EQ(std::vector<int>{ 5 }, third.toVector());
+}
+
+TEST(share, reconnectsAfterSourceCompleted)
+{
+   auto subscriptions = std::make_shared<int>(0);
+   auto shared = counted(range(1, 2), subscriptions).share();
+
+   auto first = Recorder<int>::create(shared);
+   auto second = Recorder<int>::create(shared);
+
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(2, *subscriptions);
+   ASSERT_EQ(expected, first.toVector());
+   ASSERT_EQ(expected, second.toVector());
+   ASSERT_TRUE(second.isCompleted());
+}
+
+//! A source that subscribers may join and leave from any thread; emit()
+//! passes an element to every subscriber still subscribed.
+class ThreadSafeSource
+{
+public:
+   ThreadSafeSource()
+         : m_state(std::make_shared<State>())
+   {
+   }
+
+   Observable<int> asObservable() const
+   {
+      auto state = m_state;
+      return Observable<int>::create([state](Subscriber<int> s) {
+         std::lock_guard<std::mutex> lock(state->m_mutex);
+         auto id = state->m_nextId++;
+         state->m_subscribers.emplace_back(id, s.getObserver());
+         s.add(Subscription([state, id]() {
+            std::lock_guard<std::mutex> lock(state->m_mutex);
+            auto& subscribers = state->m_subscribers;
+            for (auto it = subscribers.begin(); it != subscribers.end(); ++it)
+            {
+               if (it->first == id)
+               {
+                  subscribers.erase(it);
+                  break;
+               }
+            }
+         }));
+      });
+   }
+
+   void emit(int x) const
+   {
+      std::vector<std::pair<int, Observer<int>>> subscribers;
+      {
+         std::lock_guard<std::mutex> lock(m_state->m_mutex);
+         subscribers = m_state->m_subscribers;
+      }
+      for (auto& s : subscribers)
+      {
+         s.second.onNext(x);
+      }
+   }
+
+private:
+   struct State
+   {
+      State()
+            : m_nextId(0)
+      {
+      }
+
+      std::mutex m_mutex;
+      int m_nextId;
+      std::vector<std::pair<int, Observer<int>>> m_subscribers;
+   };
+
+   std::shared_ptr<State> m_state;
+};
+
+TEST(share, subscriberJoiningWhileLastLeavesIsConnected)
+{
+   ThreadSafeSource source;
+   auto shared = source.asObservable().share();
+   std::atomic<int> starved(0);
+
+   // A subscriber may also have to wait for the other thread to finish
+   // connecting, but one left on a disconnected connection never receives.
+   auto churn = [&source, &shared, &starved]() {
+      for (int i = 0; i < 2000; ++i)
+      {
+         std::atomic<int> received(0);
+         auto subscription = shared.subscribe([&received](const int&) {
+            ++received;
+         });
+         auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+         while (received.load() == 0 && std::chrono::steady_clock::now() < deadline)
+         {
+            source.emit(i);
+            std::this_thread::yield();
+         }
+         if (received.load() == 0)
+         {
+            ++starved;
+         }
+         subscription.unsubscribe();
+      }
+   };
+
+   std::thread other(churn);
+   churn();
+   other.join();
+
+   ASSERT_EQ(0, starved.load());
+}
+
+// Performance measurements
+TEST(share, sharePerf)
+{
+   // Five subscribers to one pipeline, which only runs once.
+   auto mapped = std::make_shared<long>(0);
+   auto published = range(1, 1e6).map([mapped](const int& x) {
+      ++*mapped;
+      return x * 2;
+   }).publish();
+
+   long sum = 0;
+   std::vector<Subscription> subscriptions;
+   for (int i = 0; i < 5; ++i)
+   {
+      subscriptions.push_back(published.subscribe([&sum](const int& x) {
+         sum += x;
+      }));
+   }
+
+   auto start = std::chrono::system_clock::now();
+   published.connect();
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   ASSERT_EQ(1000000, *mapped);
+   ASSERT_EQ(5 * 1000000L * 1000001L, sum);
+   std::cout << "share duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
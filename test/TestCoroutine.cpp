@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include "rx/operators/Range.hpp"
+#include "rx/Coroutine.hpp"
+#include "rx/Subject.hpp"
+#include "Recorder.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+//! Coroutine that starts eagerly and destroys itself when done.
+struct Task
+{
+   struct promise_type
+   {
+      Task get_return_object() { return Task(); }
+      std::suspend_never initial_suspend() const noexcept { return {}; }
+      std::suspend_never final_suspend() const noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+   };
+};
+
+AsyncGenerator<int> countTo(int n)
+{
+   for (int i = 1; i <= n; i++)
+   {
+      co_yield i;
+   }
+}
+
+TEST(AsyncGenerator, yieldsIntoObservable)
+{
+   auto observable = fromAsyncGenerator([]() { return countTo(3); });
+
+   auto recorder = Recorder<int>::create(observable);
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+
+   // Every subscription runs its own coroutine.
+   auto second = Recorder<int>::create(observable);
+   ASSERT_EQ(expected, second.toVector());
+}
+
+TEST(AsyncGenerator, stopsAfterUnsubscribe)
+{
+   int produced = 0;
+   auto observable = fromAsyncGenerator([&produced]() -> AsyncGenerator<int> {
+      for (int i = 0;; i++)
+      {
+         produced++;
+         co_yield i;
+      }
+   });
+
+   // Unsubscribes from within onNext, while subscribe is still running.
+   auto subscription = std::make_shared<Subscription>();
+   Subscriber<int> subscriber(Observer<int>([subscription](const int& x) {
+      if (x == 2)
+      {
+         subscription->unsubscribe();
+      }
+   }));
+   *subscription = subscriber.getSubscription();
+   observable.unsafeSubscribe(subscriber);
+
+   ASSERT_EQ(3, produced);
+}
+
+TEST(AsyncGenerator, resumesFromAwaitedSource)
+{
+   auto s = Subject<int>::create();
+   auto observable = fromAsyncGenerator([s]() -> AsyncGenerator<int> {
+      auto stream = awaitEach(Observable<int>(s));
+      while (co_await stream.next())
+      {
+         co_yield stream.current() * 10;
+      }
+   });
+
+   auto recorder = Recorder<int>::create(observable);
+   s.onNext(1);
+   s.onNext(2);
+   s.onCompleted();
+
+   std::vector<int> expected{ 10, 20 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+// Coroutine lambdas keep their captures in the lambda object, which does
+// not outlive a suspension, so the consumers are free functions.
+Task collect(Observable<int> source, std::vector<int>& received, bool& isDone)
+{
+   auto stream = awaitEach(source);
+   while (co_await stream.next())
+   {
+      received.push_back(stream.current());
+   }
+   isDone = true;
+}
+
+Task collectUntil(Observable<int> source, int last, std::vector<int>& received)
+{
+   auto stream = awaitEach(source);
+   while (co_await stream.next())
+   {
+      received.push_back(stream.current());
+      if (stream.current() == last)
+      {
+         break;
+      }
+   }
+}
+
+Task catchError(Observable<int> source, bool& isCaught)
+{
+   auto stream = awaitEach(source);
+   try
+   {
+      while (co_await stream.next())
+      {
+      }
+   }
+   catch (const std::runtime_error&)
+   {
+      isCaught = true;
+   }
+}
+
+Task sum(Observable<int> source, long& result)
+{
+   auto stream = awaitEach(source);
+   while (co_await stream.next())
+   {
+      result += stream.current();
+   }
+}
+
+TEST(ObservableStream, awaitsSynchronousSource)
+{
+   std::vector<int> received;
+   bool isDone = false;
+
+   collect(range(1, 5), received, isDone);
+
+   std::vector<int> expected{ 1, 2, 3, 4, 5 };
+   ASSERT_EQ(expected, received);
+   ASSERT_TRUE(isDone);
+}
+
+TEST(ObservableStream, suspendsBetweenElements)
+{
+   auto s = Subject<int>::create();
+   std::vector<int> received;
+   bool isDone = false;
+
+   collect(s, received, isDone);
+
+   ASSERT_TRUE(received.empty());
+   s.onNext(1);
+   s.onNext(2);
+   ASSERT_EQ(std::vector<int>({ 1, 2 }), received);
+   ASSERT_FALSE(isDone);
+   s.onCompleted();
+   ASSERT_TRUE(isDone);
+}
+
+TEST(ObservableStream, rethrowsError)
+{
+   auto s = Subject<int>::create();
+   bool isCaught = false;
+
+   catchError(s, isCaught);
+
+   s.onError(std::make_exception_ptr(std::runtime_error("failed")));
+   ASSERT_TRUE(isCaught);
+}
+
+TEST(ObservableStream, leavingEarlyUnsubscribes)
+{
+   auto s = Subject<int>::create();
+   std::vector<int> received;
+
+   collectUntil(s, 2, received);
+
+   s.onNext(1);
+   s.onNext(2);
+   s.onNext(3);
+   ASSERT_EQ(std::vector<int>({ 1, 2 }), received);
+}
+
+TEST(ObservableStream, awaitEachPerf)
+{
+   auto start = std::chrono::steady_clock::now();
+
+   long result = 0;
+   sum(range(1, 1000000), result);
+
+   auto end = std::chrono::steady_clock::now();
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+   std::cout << "awaitEach duration: " << duration.count() << " milliseconds" << std::endl;
+
+   ASSERT_EQ(500000500000L, result);
+}
+
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "rx/operators/From.hpp"
+#include "rx/operators/Range.hpp"
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "Recorder.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+TEST(distinct, dropsElementsSeenBefore)
+{
+   std::vector<int> source{ 1, 2, 1, 3, 2, 4, 1 };
+   auto recorder = Recorder<int>::create(from(source).distinct());
+
+   std::vector<int> expected{ 1, 2, 3, 4 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(distinct, comparesKeys)
+{
+   std::vector<std::string> source{ "a", "bb", "c", "ddd", "ee" };
+   auto recorder = Recorder<std::string>::create(from(source).distinct(
+         [](const std::string& s) { return s.size(); }));
+
+   std::vector<std::string> expected{ "a", "bb", "ddd" };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(distinct, forgetsLeastRecentlySeenKeys)
+{
+   auto s = Subject<int>::create();
+   auto report = std::make_shared<DistinctReport>();
+   auto recorder = Recorder<int>::create(
+         s.distinct([](const int& x) { return x; }, 4, report));
+
+   for (int x : { 1, 2, 3, 4 })
+   {
+      s.onNext(x);
+   }
+   // Seeing 1 again makes it the most recent key.
+   s.onNext(1);
+   ASSERT_EQ(4u, report->getKeyCount());
+
+   // 5 does not fit and evicts the keys not seen among the last two
+   // elements, which are all but 1.
+   s.onNext(5);
+   ASSERT_LE(report->getKeyCount(), 4u);
+   ASSERT_EQ(3u, report->getEvictionCount());
+
+   s.onNext(1);
+   s.onNext(2);
+
+   std::vector<int> expected{ 1, 2, 3, 4, 5, 2 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(distinct, reportsKeysAndMemory)
+{
+   auto s = Subject<int>::create();
+   auto report = std::make_shared<DistinctReport>();
+   auto recorder = Recorder<int>::create(
+         s.distinct([](const int& x) { return x; }, 0, report));
+
+   auto initialMemory = report->getMemoryUsage();
+   ASSERT_EQ(0u, report->getKeyCount());
+   ASSERT_GT(initialMemory, 0u);
+
+   for (int x = 0; x < 1000; ++x)
+   {
+      s.onNext(x % 100);
+   }
+   ASSERT_EQ(100u, report->getKeyCount());
+   ASSERT_GT(report->getMemoryUsage(), initialMemory);
+   ASSERT_EQ(0u, report->getEvictionCount());
+
+   s.onCompleted();
+   ASSERT_EQ(0u, report->getKeyCount());
+   ASSERT_EQ(initialMemory, report->getMemoryUsage());
+}
+
+TEST(distinctUntilChanged, dropsRepeatedElements)
+{
+   std::vector<int> source{ 1, 1, 2, 2, 2, 1, 3, 3 };
+   auto recorder = Recorder<int>::create(from(source).distinctUntilChanged());
+
+   std::vector<int> expected{ 1, 2, 1, 3 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(distinctUntilChanged, usesComparator)
+{
+   std::vector<int> source{ 1, 3, 2, 4, 7, 9, 8 };
+   auto recorder = Recorder<int>::create(from(source).distinctUntilChanged(
+         [](const int& a, const int& b) { return a % 2 == b % 2; }));
+
+   std::vector<int> expected{ 1, 2, 7, 8 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+// Performance measurements
+TEST(distinct, distinctPerf)
+{
+   auto start = std::chrono::system_clock::now();
+   long sum = 0;
+
+   range(1, 1e6).distinct([](const int& x) { return x % 100000; }, 50000).subscribe(
+         [&sum](const int& x) {
+            sum += x;
+         });
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   ASSERT_GT(sum, 0);
+   std::cout << "distinct duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
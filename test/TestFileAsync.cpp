@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "rx/operators/FileAsync.hpp"
+#include "rx/operators/From.hpp"
+#include "rx/Observable.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+
+using std::chrono::seconds;
+
+std::string createTempPath()
+{
+   char path[] = "/tmp/RxTestXXXXXX";
+   ::close(mkstemp(path));
+   return path;
+}
+
+std::string readFile(const std::string& path)
+{
+   std::ifstream in(path, std::ios::binary);
+   return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::vector<FileIo> engines()
+{
+   std::vector<FileIo> result{ FileIo::createThreadPool() };
+   try
+   {
+      result.push_back(FileIo::createUring());
+   }
+   catch (const std::system_error&)
+   {
+      std::cout << "io_uring not available, testing the thread pool only" << std::endl;
+   }
+   return result;
+}
+
+//! Reads path with fromFileAsync and reassembles the blocks by offset.
+std::string readAsync(const std::string& path, std::size_t blockSize,
+                      unsigned inFlight, FileIo io)
+{
+   std::mutex mutex;
+   std::map<std::uint64_t, std::string> blocks;
+   std::promise<void> completed;
+
+   fromFileAsync(path, blockSize, inFlight, io).subscribe(Observer<FileBlock>(
+         [&mutex, &blocks](const FileBlock& block) {
+            std::lock_guard<std::mutex> lock(mutex);
+            blocks[block.m_offset] = std::string(block.m_data);
+         },
+         [&completed]() { completed.set_value(); }));
+
+   EXPECT_EQ(std::future_status::ready,
+             completed.get_future().wait_for(seconds(10)));
+
+   std::lock_guard<std::mutex> lock(mutex);
+   std::string result;
+   for (auto& block : blocks)
+   {
+      EXPECT_EQ(result.size(), block.first);
+      result += block.second;
+   }
+   return result;
+}
+
+//! Writes buffers with writeFileAsync and returns the bytes reported.
+std::uint64_t writeAsync(const std::vector<IoBuffer>& buffers,
+                         const std::string& path, FileIo io)
+{
+   std::promise<std::uint64_t> written;
+   writeFileAsync(from(buffers), path, 4, io).subscribe(
+         [&written](const std::uint64_t& bytes) {
+            written.set_value(bytes);
+         });
+
+   auto future = written.get_future();
+   EXPECT_EQ(std::future_status::ready, future.wait_for(seconds(10)));
+   return future.get();
+}
+
+TEST(FileAsync, readsWholeFile)
+{
+   std::string content;
+   for (int i = 0; i < 100000; i++)
+   {
+      content += char('a' + i % 26);
+   }
+   auto path = createTempPath();
+   std::ofstream(path, std::ios::binary) << content;
+
+   for (auto& io : engines())
+   {
+      ASSERT_EQ(content, readAsync(path, 4096, 4, io));
+   }
+   std::remove(path.c_str());
+}
+
+TEST(FileAsync, readsEmptyFile)
+{
+   auto path = createTempPath();
+   for (auto& io : engines())
+   {
+      ASSERT_EQ("", readAsync(path, 4096, 4, io));
+   }
+   std::remove(path.c_str());
+}
+
+TEST(FileAsync, missingFileIsAnError)
+{
+   std::promise<void> failed;
+   fromFileAsync("/nonexistent/file").subscribe(Observer<FileBlock>(
+         [](const FileBlock&) {},
+         nullptr,
+         [&failed](std::exception_ptr) { failed.set_value(); }));
+
+   ASSERT_EQ(std::future_status::ready,
+             failed.get_future().wait_for(seconds(5)));
+}
+
+TEST(FileAsync, writesBuffersInOrder)
+{
+   std::vector<IoBuffer> buffers;
+   std::string expected;
+   for (int i = 0; i < 100; i++)
+   {
+      auto text = std::to_string(i) + ",";
+      buffers.emplace_back(text.begin(), text.end());
+      expected += text;
+   }
+
+   for (auto& io : engines())
+   {
+      auto path = createTempPath();
+      ASSERT_EQ(expected.size(), writeAsync(buffers, path, io));
+      ASSERT_EQ(expected, readFile(path));
+      std::remove(path.c_str());
+   }
+}
+
+TEST(FileAsync, fileAsyncPerf)
+{
+   const std::size_t BLOCK_SIZE = 1 << 16;
+   const int BLOCK_COUNT = 512;
+   std::vector<IoBuffer> buffers(BLOCK_COUNT, IoBuffer(BLOCK_SIZE, 'x'));
+   const double megabytes = double(BLOCK_SIZE) * BLOCK_COUNT / (1 << 20);
+
+   for (auto& io : engines())
+   {
+      auto name = io.isUring() ? "io_uring" : "thread pool";
+      auto path = createTempPath();
+
+      auto before = io.getStats();
+      auto start = std::chrono::steady_clock::now();
+      writeAsync(buffers, path, io);
+      auto written = std::chrono::steady_clock::now();
+      auto afterWrite = io.getStats();
+      auto content = readAsync(path, BLOCK_SIZE, 8, io);
+      auto read = std::chrono::steady_clock::now();
+      auto afterRead = io.getStats();
+
+      auto writeDuration = std::chrono::duration_cast<std::chrono::milliseconds>(written - start);
+      auto readDuration = std::chrono::duration_cast<std::chrono::milliseconds>(read - written);
+      std::cout << name << " write duration: " << writeDuration.count() << " milliseconds, "
+                << (afterWrite.m_syscalls - before.m_syscalls) / megabytes << " syscalls per MB"
+                << std::endl;
+      std::cout << name << " read duration: " << readDuration.count() << " milliseconds, "
+                << (afterRead.m_syscalls - afterWrite.m_syscalls) / megabytes << " syscalls per MB"
+                << std::endl;
+
+      ASSERT_EQ(BLOCK_SIZE * BLOCK_COUNT, content.size());
+      std::remove(path.c_str());
+   }
+}
+
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "rx/internal/FlatHashMap.hpp"
+
+#include <map>
+#include <random>
+
+namespace {
+
+//! Sends every key to the same bucket to exercise probing and erasing.
+struct CollidingHash
+{
+   std::size_t operator()(int) const
+   {
+      return 7;
+   }
+};
+
+TEST(FlatHashMap, findOrCreate)
+{
+   FlatHashMap<int, int> map;
+   bool isCreated = false;
+
+   map.findOrCreate(1, []() { return 10; }, isCreated);
+   ASSERT_TRUE(isCreated);
+
+   auto& value = map.findOrCreate(1, []() { return 20; }, isCreated);
+   ASSERT_FALSE(isCreated);
+   ASSERT_EQ(10, value);
+   ASSERT_EQ(1u, map.size());
+   ASSERT_EQ(nullptr, map.find(2));
+}
+
+TEST(FlatHashMap, eraseKeepsProbeChainsIntact)
+{
+   FlatHashMap<int, int, CollidingHash> map;
+   bool isCreated = false;
+
+   for (int i = 0; i < 8; i++)
+   {
+      map.findOrCreate(i, [i]() { return i; }, isCreated);
+   }
+
+   ASSERT_TRUE(map.erase(3));
+   ASSERT_FALSE(map.erase(3));
+
+   for (int i = 0; i < 8; i++)
+   {
+      if (i == 3)
+      {
+         ASSERT_EQ(nullptr, map.find(i));
+      }
+      else
+      {
+         ASSERT_NE(nullptr, map.find(i));
+         ASSERT_EQ(i, *map.find(i));
+      }
+   }
+}
+
+TEST(FlatHashMap, removeIfShrinks)
+{
+   FlatHashMap<int, int> map;
+   bool isCreated = false;
+
+   for (int i = 0; i < 1000; i++)
+   {
+      map.findOrCreate(i, [i]() { return i; }, isCreated);
+   }
+   auto capacity = map.capacity();
+
+   ASSERT_EQ(990u, map.removeIf([](const int& k, const int&) { return k >= 10; }));
+   ASSERT_EQ(10u, map.size());
+   ASSERT_LT(map.capacity(), capacity);
+   ASSERT_EQ(9, *map.find(9));
+}
+
+TEST(FlatHashMap, matchesStdMap)
+{
+   FlatHashMap<int, int> map;
+   std::map<int, int> reference;
+   std::mt19937 rng(1);
+   bool isCreated = false;
+
+   for (int i = 0; i < 100000; i++)
+   {
+      int key = rng() % 2000;
+      if (rng() % 3 == 0)
+      {
+         ASSERT_EQ(reference.erase(key) == 1, map.erase(key));
+      }
+      else
+      {
+         map.findOrCreate(key, [i]() { return i; }, isCreated);
+         reference.insert(std::make_pair(key, i));
+      }
+   }
+
+   ASSERT_EQ(reference.size(), map.size());
+   for (auto& entry : reference)
+   {
+      ASSERT_NE(nullptr, map.find(entry.first));
+      ASSERT_EQ(entry.second, *map.find(entry.first));
+   }
+}
+
+}
@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+#include "rx/operators/FromFd.hpp"
+#include "rx/Observable.hpp"
+#include "rx/schedulers/EpollScheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+class Pipe
+{
+public:
+   Pipe()
+   {
+      if (pipe(m_fds) != 0)
+      {
+         throw std::system_error(errno, std::generic_category(), "pipe");
+      }
+   }
+
+   ~Pipe()
+   {
+      closeWriteEnd();
+      close(m_fds[0]);
+   }
+
+   int readEnd() const
+   {
+      return m_fds[0];
+   }
+
+   void write(const std::string& data) const
+   {
+      auto written = ::write(m_fds[1], data.data(), data.size());
+      ASSERT_EQ(ssize_t(data.size()), written);
+   }
+
+   void closeWriteEnd()
+   {
+      if (m_fds[1] >= 0)
+      {
+         close(m_fds[1]);
+         m_fds[1] = -1;
+      }
+   }
+
+private:
+   int m_fds[2];
+};
+
+TEST(EpollScheduler, firesTimersOnLoopThread)
+{
+   auto scheduler = EpollScheduler::create();
+   std::promise<std::thread::id> fired;
+
+   auto start = scheduler.now();
+   scheduler.schedule(start + milliseconds(20), [&fired]() {
+      fired.set_value(std::this_thread::get_id());
+   });
+
+   auto future = fired.get_future();
+   ASSERT_EQ(std::future_status::ready, future.wait_for(seconds(5)));
+   ASSERT_TRUE(std::this_thread::get_id() != future.get());
+   ASSERT_GE(scheduler.now(), start + milliseconds(20));
+}
+
+TEST(EpollScheduler, lastHandleMayBeDroppedOnLoopThread)
+{
+   auto holder = std::make_shared<std::unique_ptr<EpollScheduler>>(
+         new EpollScheduler(EpollScheduler::create()));
+   std::promise<void> dropped;
+
+   auto& scheduler = **holder;
+   scheduler.schedule(scheduler.now() + milliseconds(5), [holder, &dropped]() {
+      holder->reset();
+      dropped.set_value();
+   });
+
+   auto future = dropped.get_future();
+   ASSERT_EQ(std::future_status::ready, future.wait_for(seconds(5)));
+   // Lets the detached loop thread finish its loop.
+   std::this_thread::sleep_for(milliseconds(20));
+}
+
+TEST(EpollScheduler, handlerReturningFalseStopsWatch)
+{
+   auto scheduler = EpollScheduler::create();
+   int fd = eventfd(0, EFD_NONBLOCK);
+   std::atomic<int> calls(0);
+   std::promise<void> stopped;
+
+   auto subscription = scheduler.watch(fd, EPOLLIN,
+         [&calls](std::uint32_t) {
+            ++calls;
+            return false;
+         },
+         [&stopped]() {
+            stopped.set_value();
+         });
+
+   std::uint64_t value = 1;
+   ASSERT_EQ(ssize_t(sizeof(value)), write(fd, &value, sizeof(value)));
+   ASSERT_EQ(std::future_status::ready, stopped.get_future().wait_for(seconds(5)));
+
+   // Further events are not reported.
+   ASSERT_EQ(ssize_t(sizeof(value)), write(fd, &value, sizeof(value)));
+   std::this_thread::sleep_for(milliseconds(20));
+   ASSERT_EQ(1, calls.load());
+   close(fd);
+}
+
+TEST(EpollScheduler, unwatchWaitsForRunningHandler)
+{
+   auto scheduler = EpollScheduler::create();
+   int fd = eventfd(0, EFD_NONBLOCK);
+   std::atomic<bool> isReturned(false);
+   std::promise<void> entered;
+
+   auto subscription = scheduler.watch(fd, EPOLLIN, [&isReturned, &entered](std::uint32_t) {
+      entered.set_value();
+      std::this_thread::sleep_for(milliseconds(50));
+      isReturned = true;
+      return true;
+   });
+
+   std::uint64_t value = 1;
+   ASSERT_EQ(ssize_t(sizeof(value)), write(fd, &value, sizeof(value)));
+   ASSERT_EQ(std::future_status::ready, entered.get_future().wait_for(seconds(5)));
+
+   subscription.unsubscribe();
+   ASSERT_TRUE(isReturned.load());
+   close(fd);
+}
+
+TEST(fromFd, readsChunksUntilEndOfFile)
+{
+   auto scheduler = EpollScheduler::create();
+   Pipe pipe;
+
+   std::mutex mutex;
+   std::string received;
+   std::promise<void> completed;
+
+   fromFd(pipe.readEnd(), FdMode::READ, scheduler).subscribe(Observer<FdEvent>(
+         [&mutex, &received](const FdEvent& event) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.append(event.m_data);
+         },
+         [&completed]() { completed.set_value(); }));
+
+   pipe.write("hello ");
+   pipe.write("world");
+   pipe.closeWriteEnd();
+
+   ASSERT_EQ(std::future_status::ready,
+             completed.get_future().wait_for(seconds(5)));
+   std::lock_guard<std::mutex> lock(mutex);
+   ASSERT_EQ("hello world", received);
+}
+
+TEST(fromFd, readinessOfEventFd)
+{
+   auto scheduler = EpollScheduler::create();
+   int fd = eventfd(0, EFD_NONBLOCK);
+   std::promise<std::uint64_t> counted;
+
+   auto subscription = fromFd(fd, FdMode::READINESS, scheduler).subscribe(
+         [fd, &counted](const FdEvent& event) {
+            ASSERT_TRUE(event.m_events & EPOLLIN);
+            std::uint64_t value;
+            ASSERT_EQ(ssize_t(sizeof(value)), read(fd, &value, sizeof(value)));
+            counted.set_value(value);
+         });
+
+   std::uint64_t value = 3;
+   ASSERT_EQ(ssize_t(sizeof(value)), write(fd, &value, sizeof(value)));
+
+   auto future = counted.get_future();
+   ASSERT_EQ(std::future_status::ready, future.wait_for(seconds(5)));
+   ASSERT_EQ(3u, future.get());
+
+   subscription.unsubscribe();
+   close(fd);
+}
+
+TEST(fromFd, oneLoopServesManyFds)
+{
+   const int PIPE_COUNT = 200;
+   auto scheduler = EpollScheduler::create();
+   std::vector<std::unique_ptr<Pipe>> pipes;
+
+   std::mutex mutex;
+   int completedCount = 0;
+   std::promise<void> allCompleted;
+
+   for (int i = 0; i < PIPE_COUNT; i++)
+   {
+      pipes.emplace_back(new Pipe());
+      fromFd(pipes.back()->readEnd(), FdMode::READ, scheduler).subscribe(
+            Observer<FdEvent>(
+               [](const FdEvent&) {},
+               [&mutex, &completedCount, &allCompleted, PIPE_COUNT]() {
+                  std::lock_guard<std::mutex> lock(mutex);
+                  if (++completedCount == PIPE_COUNT)
+                  {
+                     allCompleted.set_value();
+                  }
+               }));
+   }
+
+   for (auto& pipe : pipes)
+   {
+      pipe->write("x");
+      pipe->closeWriteEnd();
+   }
+
+   ASSERT_EQ(std::future_status::ready,
+             allCompleted.get_future().wait_for(seconds(5)));
+}
+
+TEST(fromFd, unsubscribeStopsReading)
+{
+   auto scheduler = EpollScheduler::create();
+   Pipe pipe;
+
+   std::mutex mutex;
+   std::string received;
+   std::promise<void> first;
+
+   auto subscription = fromFd(pipe.readEnd(), FdMode::READ, scheduler).subscribe(
+         [&mutex, &received, &first](const FdEvent& event) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.append(event.m_data);
+            first.set_value();
+         });
+
+   pipe.write("a");
+   ASSERT_EQ(std::future_status::ready, first.get_future().wait_for(seconds(5)));
+
+   subscription.unsubscribe();
+   pipe.write("b");
+
+   // Give the loop thread a chance to misbehave.
+   std::this_thread::sleep_for(milliseconds(20));
+   std::lock_guard<std::mutex> lock(mutex);
+   ASSERT_EQ("a", received);
+}
+
+}
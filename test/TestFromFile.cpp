@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "rx/operators/FromFile.hpp"
+#include "rx/Observable.hpp"
+#include "Recorder.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+
+//! Temporary file that is removed again when the test ends.
+class TempFile
+{
+public:
+   explicit TempFile(const std::string& content)
+   {
+      char path[] = "/tmp/RxTestXXXXXX";
+      int fd = mkstemp(path);
+      m_path = path;
+      ::close(fd);
+
+      std::ofstream out(m_path, std::ios::binary);
+      out << content;
+   }
+
+   ~TempFile()
+   {
+      std::remove(m_path.c_str());
+   }
+
+   const std::string& path() const
+   {
+      return m_path;
+   }
+
+private:
+   std::string m_path;
+};
+
+std::vector<std::string> toStrings(Observable<std::string_view> observable)
+{
+   std::vector<std::string> result;
+   observable.subscribe([&result](const std::string_view& record) {
+      result.emplace_back(record);
+   });
+   return result;
+}
+
+TEST(fromFile, lines)
+{
+   TempFile file("first\nsecond\n\nlast");
+
+   std::vector<std::string> expected{ "first", "second", "", "last" };
+   ASSERT_EQ(expected, toStrings(fromFileLines(file.path())));
+}
+
+TEST(fromFile, emptyFile)
+{
+   TempFile file("");
+
+   auto recorder = Recorder<std::string_view>::create(fromFileLines(file.path()));
+   ASSERT_TRUE(recorder.toVector().empty());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(fromFile, fixedSizeRecords)
+{
+   TempFile file("aaabbbccc");
+
+   std::vector<std::string> expected{ "aaa", "bbb", "ccc" };
+   ASSERT_EQ(expected, toStrings(fromFileRecords(file.path(), 3)));
+}
+
+TEST(fromFile, lengthPrefixedRecords)
+{
+   std::string content;
+   for (std::string record : { "one", "", "three" })
+   {
+      std::uint32_t length = std::uint32_t(record.size());
+      content.append(reinterpret_cast<const char*>(&length), sizeof(length));
+      content += record;
+   }
+   TempFile file(content);
+
+   std::vector<std::string> expected{ "one", "", "three" };
+   ASSERT_EQ(expected, toStrings(fromFileLengthPrefixed(file.path())));
+}
+
+TEST(fromFile, truncatedRecordIsAnError)
+{
+   TempFile file("aaabb");
+
+   std::vector<std::string> received;
+   bool isFailed = false;
+   fromFileRecords(file.path(), 3).subscribe(Observer<std::string_view>(
+         [&received](const std::string_view& record) {
+            received.emplace_back(record);
+         },
+         nullptr,
+         [&isFailed](std::exception_ptr) { isFailed = true; }));
+
+   ASSERT_EQ(std::vector<std::string>({ "aaa" }), received);
+   ASSERT_TRUE(isFailed);
+}
+
+TEST(fromFile, missingFileIsAnError)
+{
+   bool isFailed = false;
+   fromFileLines("/nonexistent/file").subscribe(Observer<std::string_view>(
+         [](const std::string_view&) {},
+         nullptr,
+         [&isFailed](std::exception_ptr) { isFailed = true; }));
+
+   ASSERT_TRUE(isFailed);
+}
+
+TEST(fromFile, batchesPerChunk)
+{
+   // Three chunks worth of 16 byte records.
+   std::string content(3 * FROM_FILE_CHUNK_SIZE, 'x');
+   TempFile file(content);
+
+   std::vector<std::size_t> sizes;
+   fromFileBatches(file.path(), FixedSizeSplitter(16)).subscribe(
+         [&sizes](const std::span<const std::string_view>& batch) {
+            sizes.push_back(batch.size());
+         });
+
+   std::vector<std::size_t> expected(3, FROM_FILE_CHUNK_SIZE / 16);
+   ASSERT_EQ(expected, sizes);
+}
+
+TEST(fromFile, fromFileLinesPerf)
+{
+   std::string content;
+   for (int i = 0; i < 1000000; i++)
+   {
+      content += "line number " + std::to_string(i) + "\n";
+   }
+   TempFile file(content);
+
+   auto start = std::chrono::steady_clock::now();
+
+   std::size_t bytes = 0;
+   fromFileLines(file.path()).subscribe([&bytes](const std::string_view& line) {
+      bytes += line.size() + 1;
+   });
+
+   auto end = std::chrono::steady_clock::now();
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+   std::cout << "fromFileLines duration: " << duration.count() << " milliseconds" << std::endl;
+
+   ASSERT_EQ(content.size(), bytes);
+}
+
+}
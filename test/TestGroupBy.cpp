@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "rx/operators/Range.hpp"
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "Recorder.hpp"
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace {
+
+TEST(groupBy, routesElementsByKey)
+{
+   std::map<int, Recorder<int>> groups;
+   range(1,6).groupBy([](const int& x) { return x % 3; }).subscribe(
+         [&groups](const GroupedObservable<int, int>& g) {
+            groups.insert(std::make_pair(g.getKey(), Recorder<int>::create(g)));
+         });
+
+   ASSERT_EQ(3u, groups.size());
+   std::vector<int> expected{ 3, 6 };
+   ASSERT_EQ(expected, groups.at(0).toVector());
+   expected = { 1, 4 };
+   ASSERT_EQ(expected, groups.at(1).toVector());
+   expected = { 2, 5 };
+   ASSERT_EQ(expected, groups.at(2).toVector());
+   ASSERT_TRUE(groups.at(0).isCompleted());
+}
+
+TEST(groupBy, unsubscribedGroupIsReopened)
+{
+   auto s = Subject<int>::create();
+   std::vector<Recorder<int>> groups;
+   s.groupBy([](const int& x) { return x % 2; }).subscribe(
+         [&groups](const GroupedObservable<int, int>& g) {
+            groups.push_back(Recorder<int>::create(g));
+         });
+
+   s.onNext(1);
+   groups[0].unsubscribe();
+   s.onNext(3);
+
+   ASSERT_EQ(2u, groups.size());
+   ASSERT_EQ(std::vector<int>{ 1 }, groups[0].toVector());
+   ASSERT_EQ(std::vector<int>{ 3 }, groups[1].toVector());
+}
+
+// Performance measurements
+TEST(groupBy, groupByPerf)
+{
+   auto start = std::chrono::system_clock::now();
+   long sum = 0;
+
+   range(1,1e6).groupBy([](const int& x) { return x % 100000; }).subscribe(
+         [&sum](const GroupedObservable<int, int>& g) {
+            g.subscribe([&sum](const int& x) {
+               sum += x;
+            });
+         });
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "groupBy duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+TEST(groupBy, groupByChurnPerf)
+{
+   // 100000 groups stay open while every further key opens a group that
+   // is unsubscribed right away.
+   auto start = std::chrono::system_clock::now();
+   std::vector<Subscription> live;
+
+   range(0,1e6).groupBy([](const int& x) { return x; }).subscribe(
+         [&live](const GroupedObservable<int, int>& g) {
+            auto subscription = g.subscribe([](const int&) {});
+            if (g.getKey() < 100000)
+            {
+               live.push_back(subscription);
+            }
+            else
+            {
+               subscription.unsubscribe();
+            }
+         });
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   ASSERT_EQ(100000u, live.size());
+   std::cout << "groupBy churn duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
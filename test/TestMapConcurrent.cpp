@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "rx/Observable.hpp"
+#include "rx/operators/Range.hpp"
+#include "rx/schedulers/ThreadPoolScheduler.hpp"
+#include "Collector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+TEST(ThreadPoolScheduler, runsActionsConcurrently)
+{
+   auto scheduler = ThreadPoolScheduler::create(4);
+   ASSERT_EQ(4u, scheduler.getThreadCount());
+
+   // Every action waits for all four to have started, which only works
+   // out if they run at the same time.
+   std::mutex mutex;
+   std::condition_variable condition;
+   std::set<std::thread::id> threads;
+   int finished = 0;
+
+   for (int i = 0; i < 4; ++i)
+   {
+      scheduler.schedule([&]() {
+         std::unique_lock<std::mutex> lock(mutex);
+         threads.insert(std::this_thread::get_id());
+         condition.notify_all();
+         condition.wait_for(lock, seconds(10), [&]() { return threads.size() == 4; });
+         ++finished;
+         condition.notify_all();
+      });
+   }
+
+   std::unique_lock<std::mutex> lock(mutex);
+   ASSERT_TRUE(condition.wait_for(lock, seconds(10), [&]() { return finished == 4; }));
+   ASSERT_EQ(4u, threads.size());
+   ASSERT_EQ(0u, threads.count(std::this_thread::get_id()));
+}
+
+TEST(ThreadPoolScheduler, runsTimersOnPool)
+{
+   auto scheduler = ThreadPoolScheduler::create(2);
+   std::promise<std::thread::id> fired;
+
+   auto start = scheduler.now();
+   scheduler.schedule(start + milliseconds(10), [&fired]() {
+      fired.set_value(std::this_thread::get_id());
+   });
+
+   auto future = fired.get_future();
+   ASSERT_EQ(std::future_status::ready, future.wait_for(seconds(5)));
+   ASSERT_TRUE(std::this_thread::get_id() != future.get());
+   ASSERT_GE(scheduler.now(), start + milliseconds(10));
+}
+
+TEST(mapConcurrent, emitsInSourceOrder)
+{
+   auto scheduler = ThreadPoolScheduler::create(4);
+   auto observable = range(1, 200).mapConcurrent([](const int& x) {
+      // Later elements tend to finish first.
+      std::this_thread::sleep_for(std::chrono::microseconds((200 - x) % 7 * 100));
+      return x * 10;
+   }, 8, scheduler);
+
+   Collector<int> collector(observable);
+
+   std::vector<int> expected;
+   for (int x = 1; x <= 200; ++x)
+   {
+      expected.push_back(x * 10);
+   }
+   ASSERT_FALSE(collector.isError());
+   ASSERT_EQ(expected, collector.getValues());
+}
+
+TEST(mapConcurrent, boundsElementsInFlight)
+{
+   auto scheduler = ThreadPoolScheduler::create(8);
+   std::atomic<int> inFlight(0);
+   std::atomic<int> maxInFlight(0);
+
+   auto observable = range(1, 100).mapConcurrent([&](const int& x) {
+      auto current = ++inFlight;
+      auto observed = maxInFlight.load();
+      while (current > observed && !maxInFlight.compare_exchange_weak(observed, current))
+      {
+      }
+      std::this_thread::sleep_for(milliseconds(1));
+      --inFlight;
+      return x;
+   }, 3, scheduler);
+
+   Collector<int> collector(observable);
+   ASSERT_EQ(100u, collector.getValues().size());
+   ASSERT_LE(maxInFlight.load(), 3);
+   ASSERT_GT(maxInFlight.load(), 1);
+}
+
+TEST(mapConcurrent, emitsErrorInOrder)
+{
+   auto scheduler = ThreadPoolScheduler::create(4);
+   auto observable = range(1, 100).mapConcurrent([](const int& x) {
+      if (x == 50)
+      {
+         throw std::runtime_error("50");
+      }
+      return x;
+   }, 8, scheduler);
+
+   Collector<int> collector(observable);
+   auto values = collector.getValues();
+   ASSERT_TRUE(collector.isError());
+   ASSERT_EQ(49u, values.size());
+   ASSERT_EQ(49, values.back());
+}
+
+TEST(mapConcurrent, stopsAfterUnsubscribe)
+{
+   auto scheduler = ThreadPoolScheduler::create(2);
+   std::atomic<int> transformed(0);
+   std::mutex mutex;
+   std::vector<int> received;
+
+   auto subscription = std::make_shared<Subscription>();
+   Subscriber<int> subscriber(Observer<int>(
+      [&mutex, &received, subscription](const int& x) {
+         std::lock_guard<std::mutex> lock(mutex);
+         received.push_back(x);
+         if (received.size() == 5)
+         {
+            subscription->unsubscribe();
+         }
+      }));
+   *subscription = subscriber.getSubscription();
+
+   // The source is held up until the subscriber has gone.
+   range(1, 1000000).mapConcurrent([&transformed](const int& x) {
+      ++transformed;
+      return x;
+   }, 4, scheduler).unsafeSubscribe(subscriber);
+
+   std::this_thread::sleep_for(milliseconds(20));
+   std::lock_guard<std::mutex> lock(mutex);
+   ASSERT_EQ(5u, received.size());
+   ASSERT_LE(transformed.load(), 5 + 4);
+}
+
+TEST(mapConcurrent, PerformanceTest)
+{
+   const int count = 1000;
+   auto scheduler = ThreadPoolScheduler::create(32);
+   auto blockingCall = [](const int& x) {
+      std::this_thread::sleep_for(milliseconds(1));
+      return x;
+   };
+
+   auto start = std::chrono::steady_clock::now();
+   Collector<int> collector(range(1, count).mapConcurrent(blockingCall, 32, scheduler));
+   auto end = std::chrono::steady_clock::now();
+
+   ASSERT_EQ(std::size_t(count), collector.getValues().size());
+   std::cout << "mapConcurrent duration: "
+             << std::chrono::duration_cast<milliseconds>(end - start).count()
+             << " milliseconds" << std::endl;
+}
+
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "rx/internal/ObjectPool.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Payload
+{
+   explicit Payload(int value)
+         : m_value(value)
+   {
+   }
+
+   int m_value;
+   char m_padding[40];
+};
+
+TEST(ObjectPool, reusesFreedBlocks)
+{
+   auto first = std::allocate_shared<Payload>(PoolAllocator<Payload>(), 1);
+   auto address = first.get();
+   first.reset();
+
+   auto allocations = ObjectPools::getAllocationCount();
+   auto second = std::allocate_shared<Payload>(PoolAllocator<Payload>(), 2);
+   ASSERT_EQ(address, second.get());
+   ASSERT_EQ(2, second->m_value);
+   ASSERT_EQ(allocations, ObjectPools::getAllocationCount());
+}
+
+TEST(ObjectPool, blocksFreedOnAnotherThreadComeBack)
+{
+   std::vector<std::shared_ptr<Payload>> payloads;
+   for (int round = 0; round < 10; ++round)
+   {
+      for (int i = 0; i < 1000; ++i)
+      {
+         payloads.push_back(std::allocate_shared<Payload>(PoolAllocator<Payload>(), i));
+      }
+      if (round == 1)
+      {
+         ObjectPools::releaseIdle();
+      }
+
+      // Freed on a thread that never allocates, which hands them to the
+      // shared freelist as its cache fills up and when it exits.
+      std::thread([&payloads]() { payloads.clear(); }).join();
+   }
+
+   // The shared freelist holds all of a round, later rounds reuse them.
+   auto allocations = ObjectPools::getAllocationCount();
+   for (int i = 0; i < 1000; ++i)
+   {
+      payloads.push_back(std::allocate_shared<Payload>(PoolAllocator<Payload>(), i));
+   }
+   ASSERT_EQ(allocations, ObjectPools::getAllocationCount());
+   std::thread([&payloads]() { payloads.clear(); }).join();
+}
+
+TEST(ObjectPool, releaseIdleFreesSharedBlocks)
+{
+   std::vector<std::shared_ptr<Payload>> payloads;
+   for (int i = 0; i < 1000; ++i)
+   {
+      payloads.push_back(std::allocate_shared<Payload>(PoolAllocator<Payload>(), i));
+   }
+   std::thread([&payloads]() { payloads.clear(); }).join();
+   ObjectPools::releaseIdle();
+
+   // The calling thread's own cache is not enough for all of them.
+   auto allocations = ObjectPools::getAllocationCount();
+   for (int i = 0; i < 1000; ++i)
+   {
+      payloads.push_back(std::allocate_shared<Payload>(PoolAllocator<Payload>(), i));
+   }
+   ASSERT_LT(allocations, ObjectPools::getAllocationCount());
+}
+
+}
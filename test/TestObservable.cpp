@@ -2,82 +2,14 @@
 #include "rx/operators/Range.hpp"
 #include "rx/Observable.hpp"
 #include "rx/Subject.hpp"
+#include "Recorder.hpp"
 
 #include <iostream>
 #include <chrono>
+#include <memory>
 
 namespace {
 
-//! Subscribes to provided Observable and stores all
-//! values that the Observable emits.
-template<class T>
-class Recorder
-{
-public:
-   template<class U>
-   static Recorder<U> create(Observable<U> o)
-   {
-      return Recorder<U>(o);
-   }
-
-   const std::vector<T>& toVector() const
-   {
-      return m_state->m_recording;
-   }
-
-   bool isCompleted() const
-   {
-      return m_state->m_isCompleted;
-   }
-
-   void unsubscribe()
-   {
-      m_state->m_compositeSubscription.unsubscribe();
-   }
-
-private:
-   Recorder(Observable<T> o)
-         : m_state(std::make_shared<State>())
-   {
-      auto shared_state = m_state;
-      auto subscription = o.subscribe(Observer<T>(
-         // onNext
-         [shared_state](const T& t)
-         {
-            if (!shared_state->m_isCompleted)
-            {
-               shared_state->m_recording.push_back(t);
-            }
-         },
-         // onCompleted
-         [shared_state]()
-         {
-            shared_state->m_isCompleted = true;
-         }));
-
-      m_state->m_compositeSubscription.add(subscription);
-   }
-
-   void add(const T& t)
-   {
-      m_state->m_recording.push_back(t);
-   }
-
-   struct State
-   {
-      State()
-            : m_isCompleted(false),
-              m_recording()
-      {
-      }
-      bool m_isCompleted;
-      std::vector<T> m_recording;
-      SubscriptionList m_compositeSubscription;
-   };
-
-   std::shared_ptr<State> m_state;
-};
-
 TEST(Observable, subscribe)
 {
    // We'll use a subject to avoid boilerplate code
@@ -216,6 +148,115 @@ TEST(Observable, map)
    ASSERT_EQ(expected, recorder.toVector());
 }
 
+TEST(Observable, buffer)
+{
+   auto observable = range(1,5).buffer(2);
+
+   auto recorder = Recorder<std::vector<int>>::create(observable);
+   std::vector<std::vector<int>> expected{ { 1, 2 }, { 3, 4 }, { 5 } };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(Observable, bufferReusesStorage)
+{
+   std::vector<const int*> storage;
+   range(1,100).buffer(10).subscribe([&storage](const std::vector<int>& v) {
+      storage.push_back(v.data());
+   });
+
+   ASSERT_EQ(10u, storage.size());
+   for (auto p : storage)
+   {
+      ASSERT_EQ(storage.front(), p);
+   }
+}
+
+TEST(Observable, concatMap)
+{
+   auto observable = range(1,3)
+         .concatMap([](const int& x) {
+            return range(x * 10, x * 10 + 1);
+         });
+
+   auto recorder = Recorder<int>::create(observable);
+   std::vector<int> expected{ 10, 11, 20, 21, 30, 31 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(Observable, concatMapWaitsForAsyncInner)
+{
+   auto first = Subject<int>::create();
+   auto second = Subject<int>::create();
+   auto observable = range(1,2)
+         .concatMap([first, second](const int& x) -> Observable<int> {
+            if (x == 1)
+            {
+               return first;
+            }
+            return second;
+         });
+
+   auto recorder = Recorder<int>::create(observable);
+   second.onNext(20);
+   first.onNext(10);
+   first.onCompleted();
+   second.onNext(21);
+   second.onCompleted();
+
+   std::vector<int> expected{ 10, 21 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(Observable, concatMapRunsInConstantStack)
+{
+   // One nested frame per synchronous inner would overflow the stack.
+   long count = 0;
+   range(1,1000000)
+         .concatMap([](const int& x) {
+            return range(x, x);
+         })
+         .subscribe([&count](const int&) {
+            count++;
+         });
+
+   ASSERT_EQ(1000000, count);
+}
+
+TEST(Observable, concat)
+{
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(concat(range(1,2), s, range(5,5)));
+
+   s.onNext(3);
+   s.onNext(4);
+   ASSERT_FALSE(recorder.isCompleted());
+   s.onCompleted();
+
+   std::vector<int> expected{ 1, 2, 3, 4, 5 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(Observable, concatMayBeUnsubscribedFromOnCompleted)
+{
+   auto subscription = std::make_shared<Subscription>();
+   bool isCompleted = false;
+   Subscriber<int> subscriber(Observer<int>(
+      [](const int&) {},
+      [subscription, &isCompleted]() {
+         isCompleted = true;
+         subscription->unsubscribe();
+      }));
+   *subscription = subscriber.getSubscription();
+
+   concat(range(1,2), range(3,3)).unsafeSubscribe(subscriber);
+
+   ASSERT_TRUE(isCompleted);
+}
+
 TEST(Observable, mapPerformance)
 {
    auto start = std::chrono::system_clock::now();
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include "rx/Observable.hpp"
+#include "rx/operators/Range.hpp"
+#include "rx/schedulers/ThreadPoolScheduler.hpp"
+#include "Collector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using std::chrono::seconds;
+
+TEST(parallel, runsStagesOnRailsAndJoins)
+{
+   auto observable = range(1, 1000)
+         .parallel(4)
+         .map([](const int& x) { return 2 * x; })
+         .filter([](const int& x) { return x % 3 == 0; })
+         .sequential();
+
+   Collector<int> collector(observable);
+   auto values = collector.getValues();
+   std::sort(values.begin(), values.end());
+
+   std::vector<int> expected;
+   for (int x = 1; x <= 1000; ++x)
+   {
+      if (2 * x % 3 == 0)
+      {
+         expected.push_back(2 * x);
+      }
+   }
+   ASSERT_FALSE(collector.isError());
+   ASSERT_EQ(expected, values);
+}
+
+TEST(parallel, orderedKeepsSourceOrder)
+{
+   auto observable = range(1, 10000)
+         .parallel(3)
+         .filter([](const int& x) { return x % 7 != 0; })
+         .map([](const int& x) { return x * 0.5; })
+         .ordered();
+
+   Collector<double> collector(observable);
+
+   std::vector<double> expected;
+   for (int x = 1; x <= 10000; ++x)
+   {
+      if (x % 7 != 0)
+      {
+         expected.push_back(x * 0.5);
+      }
+   }
+   ASSERT_EQ(expected, collector.getValues());
+}
+
+TEST(parallel, runsRailsOnScheduler)
+{
+   std::mutex mutex;
+   std::set<std::thread::id> threads;
+
+   auto observable = range(1, 100)
+         .parallel(4)
+         .runOn(ThreadPoolScheduler::create(2))
+         .map([&mutex, &threads](const int& x) {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+            return x;
+         })
+         .sequential();
+
+   Collector<int> collector(observable);
+   ASSERT_EQ(100u, collector.getValues().size());
+   ASSERT_GE(2u, threads.size());
+   ASSERT_EQ(0u, threads.count(std::this_thread::get_id()));
+}
+
+TEST(parallel, orderedRailsShareOneThread)
+{
+   // Rails whose output is full give the thread up rather than wait for
+   // the rail the merge loop needs next.
+   auto observable = range(1, 100000)
+         .parallel(4)
+         .runOn(ThreadPoolScheduler::create(1))
+         .ordered();
+
+   Collector<int> collector(observable);
+   auto values = collector.getValues();
+   ASSERT_EQ(100000u, values.size());
+   for (std::size_t i = 0; i < values.size(); ++i)
+   {
+      ASSERT_EQ(int(i) + 1, values[i]);
+   }
+}
+
+TEST(parallel, keepsOrderOfEachKey)
+{
+   auto observable = range(1, 10000)
+         .parallel(4, [](const int& x) { return x % 10; })
+         .map([](const int& x) { return std::make_pair(x % 10, x); })
+         .sequential();
+
+   Collector<std::pair<int, int>> collector(observable);
+   auto values = collector.getValues();
+   ASSERT_EQ(10000u, values.size());
+
+   std::map<int, int> last;
+   for (const auto& value : values)
+   {
+      ASSERT_LT(last[value.first], value.second);
+      last[value.first] = value.second;
+   }
+
+   ASSERT_THROW(range(1, 2).parallel(2, [](const int& x) { return x; }).ordered(),
+                std::logic_error);
+}
+
+TEST(parallel, passesErrorOfStageOn)
+{
+   auto observable = range(1, 1000)
+         .parallel(2)
+         .map([](const int& x) {
+            if (x == 500)
+            {
+               throw std::runtime_error("500");
+            }
+            return x;
+         })
+         .ordered();
+
+   Collector<int> collector(observable);
+   ASSERT_TRUE(collector.isError());
+   ASSERT_GE(499u, collector.getValues().size());
+}
+
+TEST(parallel, passesErrorOfSourceOnAfterElements)
+{
+   auto source = Observable<int>::create([](Subscriber<int> s) {
+      auto o = s.getObserver();
+      o.onNext(1);
+      o.onNext(2);
+      o.onNext(3);
+      o.onError(std::make_exception_ptr(std::runtime_error("source")));
+   });
+
+   Collector<int> collector(source.parallel(2).ordered());
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, collector.getValues());
+   ASSERT_TRUE(collector.isError());
+}
+
+TEST(parallel, stopsAfterUnsubscribe)
+{
+   std::mutex mutex;
+   std::vector<int> received;
+   std::promise<void> unsubscribed;
+
+   auto subscription = std::make_shared<Subscription>();
+   Subscriber<int> subscriber(Observer<int>(
+      [&mutex, &received, &unsubscribed, subscription](const int& x) {
+         std::lock_guard<std::mutex> lock(mutex);
+         received.push_back(x);
+         if (received.size() == 10)
+         {
+            subscription->unsubscribe();
+            unsubscribed.set_value();
+         }
+      }));
+   *subscription = subscriber.getSubscription();
+
+   auto future = unsubscribed.get_future();
+   range(1, 1000000).parallel(2).ordered().unsafeSubscribe(subscriber);
+   ASSERT_EQ(std::future_status::ready, future.wait_for(seconds(10)));
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   std::lock_guard<std::mutex> lock(mutex);
+   ASSERT_EQ(10u, received.size());
+}
+
+TEST(parallel, PerformanceTest)
+{
+   // About two microseconds of work per element.
+   auto work = [](const int& x) {
+      auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(2);
+      long sum = x;
+      while (std::chrono::steady_clock::now() < until)
+      {
+         sum = sum * 31 + 7;
+      }
+      return sum;
+   };
+
+   for (std::size_t rails : { 1u, 4u })
+   {
+      auto start = std::chrono::steady_clock::now();
+      Collector<long> collector(range(1, 200000).parallel(rails).map(work).sequential());
+      auto end = std::chrono::steady_clock::now();
+
+      ASSERT_EQ(200000u, collector.getValues().size());
+      std::cout << "parallel(" << rails << ") duration: "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                << " milliseconds" << std::endl;
+   }
+}
+
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "rx/Pipeline.hpp"
+#include "rx/Observable.hpp"
+#include "rx/operators/Range.hpp"
+#include "Recorder.hpp"
+
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+TEST(Pipeline, runsChainInOrder)
+{
+   std::vector<int> received;
+   pipeline::range(1, 10)
+         | pipeline::map([](int x) { return x * x; })
+         | pipeline::filter([](int x) { return x % 2 == 0; })
+         | pipeline::sink([&received](int x) { received.push_back(x); });
+
+   std::vector<int> expected{ 4, 16, 36, 64, 100 };
+   ASSERT_EQ(expected, received);
+}
+
+TEST(Pipeline, rangeIncludesBothEnds)
+{
+   auto count = [](int first, int last) {
+      return pipeline::range(first, last)
+            | pipeline::fold(0, [](int n, int) { return n + 1; });
+   };
+
+   ASSERT_EQ(1, count(5, 5));
+   ASSERT_EQ(0, count(6, 5));
+   ASSERT_EQ(3, count(INT_MAX - 2, INT_MAX));
+}
+
+TEST(Pipeline, takeStopsSource)
+{
+   int mapped = 0;
+   std::vector<int> received;
+   pipeline::range(1, 1000000)
+         | pipeline::map([&mapped](int x) { ++mapped; return x; })
+         | pipeline::filter([](int x) { return x % 3 == 0; })
+         | pipeline::take(3)
+         | pipeline::sink([&received](int x) { received.push_back(x); });
+
+   std::vector<int> expected{ 3, 6, 9 };
+   ASSERT_EQ(expected, received);
+   ASSERT_EQ(9, mapped);
+
+   int taken = 0;
+   pipeline::range(1, 10)
+         | pipeline::take(0)
+         | pipeline::sink([&taken](int) { ++taken; });
+   ASSERT_EQ(0, taken);
+}
+
+TEST(Pipeline, expressionCanBeRunRepeatedly)
+{
+   std::vector<int> values{ 1, 2, 3, 4 };
+   auto doubled = pipeline::from(values)
+         | pipeline::map([](int x) { return 2 * x; })
+         | pipeline::take(3);
+
+   auto sum = [](int a, int b) { return a + b; };
+   ASSERT_EQ(12, doubled | pipeline::fold(0, sum));
+   ASSERT_EQ(12, doubled | pipeline::fold(0, sum));
+}
+
+TEST(Pipeline, toObservableEmitsAndCompletes)
+{
+   auto observable = (pipeline::range(1, 6)
+         | pipeline::filter([](int x) { return x % 2 == 1; })
+         | pipeline::map([](int x) { return x * 1.5; })).toObservable();
+
+   auto recorder = Recorder<double>::create(observable);
+   std::vector<double> expected{ 1.5, 4.5, 7.5 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+
+   // Every subscription runs the expression again.
+   auto second = Recorder<double>::create(observable);
+   ASSERT_EQ(expected, second.toVector());
+}
+
+TEST(Pipeline, toObservableStopsAfterUnsubscribe)
+{
+   auto observable = pipeline::range(1, 1000000).toObservable();
+
+   std::vector<int> received;
+   auto subscription = std::make_shared<Subscription>();
+   Subscriber<int> subscriber(Observer<int>([&received, subscription](const int& x) {
+      received.push_back(x);
+      if (x == 3)
+      {
+         subscription->unsubscribe();
+      }
+   }));
+   *subscription = subscriber.getSubscription();
+   observable.unsafeSubscribe(subscriber);
+
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, received);
+}
+
+TEST(Pipeline, toObservablePassesExceptionToOnError)
+{
+   auto observable = (pipeline::range(1, 5)
+         | pipeline::map([](int x) {
+              if (x == 3)
+              {
+                 throw std::runtime_error("three");
+              }
+              return x;
+           })).toObservable();
+
+   std::vector<int> received;
+   bool isError = false;
+   observable.subscribe(Observer<int>(
+      [&received](const int& x) {
+         received.push_back(x);
+      },
+      nullptr,
+      [&isError](std::exception_ptr) {
+         isError = true;
+      }));
+
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, received);
+   ASSERT_TRUE(isError);
+}
+
+TEST(Pipeline, PerformanceTest)
+{
+   const int count = 100000000;
+   auto square = [](int x) { return long(x) * x; };
+   auto isEven = [](long x) { return x % 2 == 0; };
+
+   auto start = std::chrono::steady_clock::now();
+   long pipelineSum = pipeline::range(1, count)
+         | pipeline::map(square)
+         | pipeline::filter(isEven)
+         | pipeline::fold(0L, [](long a, long b) { return a + b; });
+   auto end = std::chrono::steady_clock::now();
+   std::cout << "Pipeline duration: "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+             << " milliseconds" << std::endl;
+
+   long observableSum = 0;
+   start = std::chrono::steady_clock::now();
+   range(1, count).map(square).subscribe([&observableSum, isEven](const long& x) {
+      if (isEven(x))
+      {
+         observableSum += x;
+      }
+   });
+   end = std::chrono::steady_clock::now();
+   std::cout << "Observable duration: "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+             << " milliseconds" << std::endl;
+
+   ASSERT_EQ(observableSum, pipelineSum);
+}
+
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "rx/operators/Range.hpp"
+#include "rx/Observable.hpp"
+#include "rx/schedulers/TestScheduler.hpp"
+#include "Recorder.hpp"
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using std::chrono::milliseconds;
+
+std::vector<int> sequence(int first, int last)
+{
+   std::vector<int> values;
+   for (int x = first; x <= last; ++x)
+   {
+      values.push_back(x);
+   }
+   return values;
+}
+
+TEST(ReplaySubject, replaysEveryElementToLateSubscribers)
+{
+   auto s = ReplaySubject<int>::create();
+   s.onNext(1);
+   s.onNext(2);
+   auto first = Recorder<int>::create(s);
+   s.onNext(3);
+   auto second = Recorder<int>::create(s);
+   s.onCompleted();
+   auto third = Recorder<int>::create(s);
+
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, first.toVector());
+   ASSERT_EQ(expected, second.toVector());
+   ASSERT_EQ(expected, third.toVector());
+   ASSERT_TRUE(first.isCompleted());
+   ASSERT_TRUE(third.isCompleted());
+}
+
+TEST(ReplaySubject, replaysLastElementsAcrossChunks)
+{
+   auto s = ReplaySubject<int>::createWithSize(70);
+   for (int x = 1; x <= 200; ++x)
+   {
+      s.onNext(x);
+   }
+   auto recorder = Recorder<int>::create(s);
+   s.onNext(201);
+
+   ASSERT_EQ(sequence(131, 201), recorder.toVector());
+}
+
+TEST(ReplaySubject, replaysElementsOfWindow)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = ReplaySubject<int>::createWithTime(milliseconds(8), scheduler);
+
+   s.onNext(1);
+   scheduler.advanceTimeBy(milliseconds(5));
+   s.onNext(2);
+   scheduler.advanceTimeBy(milliseconds(5));
+   s.onNext(3);
+   scheduler.advanceTimeBy(milliseconds(2));
+
+   auto recorder = Recorder<int>::create(s);
+   std::vector<int> expected{ 2, 3 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(ReplaySubject, lateSubscribersOnOtherThreadsGetEveryElementInOrder)
+{
+   const int count = 200000;
+   auto s = ReplaySubject<int>::create();
+
+   std::thread producer([s]() {
+      for (int x = 1; x <= count; ++x)
+      {
+         s.onNext(x);
+      }
+      s.onCompleted();
+   });
+
+   std::vector<std::thread> consumers;
+   std::vector<std::promise<bool>> results(4);
+   for (int i = 0; i < 4; ++i)
+   {
+      consumers.emplace_back([s, &results, i]() {
+         std::this_thread::sleep_for(std::chrono::microseconds(500 * i));
+         auto next = std::make_shared<int>(1);
+         auto isInOrder = std::make_shared<bool>(true);
+         auto& result = results[i];
+         s.subscribe(Observer<int>(
+            [next, isInOrder](const int& x) {
+               *isInOrder = *isInOrder && x == (*next)++;
+            },
+            [next, isInOrder, &result]() {
+               result.set_value(*isInOrder && *next == count + 1);
+            }));
+      });
+   }
+
+   for (auto& result : results)
+   {
+      auto future = result.get_future();
+      ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(10)));
+      ASSERT_TRUE(future.get());
+   }
+   producer.join();
+   for (auto& consumer : consumers)
+   {
+      consumer.join();
+   }
+}
+
+TEST(cache, subscribesToSourceOnce)
+{
+   auto subscriptions = std::make_shared<int>(0);
+   auto source = Observable<int>::create([subscriptions](Subscriber<int> s) {
+      ++*subscriptions;
+      range(1, 100).unsafeSubscribe(s);
+   });
+   auto cached = source.cache();
+   ASSERT_EQ(0, *subscriptions);
+
+   auto first = Recorder<int>::create(cached);
+   auto second = Recorder<int>::create(cached);
+
+   ASSERT_EQ(1, *subscriptions);
+   ASSERT_EQ(sequence(1, 100), first.toVector());
+   ASSERT_EQ(sequence(1, 100), second.toVector());
+   ASSERT_TRUE(second.isCompleted());
+}
+
+TEST(replay, replaysLastCountElements)
+{
+   auto replayed = range(1, 10).replay(3);
+   auto first = Recorder<int>::create(replayed);
+   auto second = Recorder<int>::create(replayed);
+
+   ASSERT_EQ(sequence(1, 10), first.toVector());
+   ASSERT_EQ(sequence(8, 10), second.toVector());
+}
+
+// Performance measurements
+TEST(cache, cachePerf)
+{
+   auto cached = range(1, 1e6).cache();
+   long sum = 0;
+
+   auto start = std::chrono::system_clock::now();
+   for (int i = 0; i < 5; ++i)
+   {
+      cached.subscribe([&sum](const int& x) {
+         sum += x;
+      });
+   }
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   ASSERT_EQ(5 * 1000000L * 1000001L / 2, sum);
+   std::cout << "cache duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
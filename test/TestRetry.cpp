@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "rx/Observable.hpp"
+#include "rx/schedulers/TestScheduler.hpp"
+#include "Recorder.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using std::chrono::milliseconds;
+
+//! Emits the number of the attempt and fails, until the attempt given
+//! completes.
+Observable<int> failUntil(std::shared_ptr<int> attempts, int successfulAttempt)
+{
+   return Observable<int>::create([attempts, successfulAttempt](Subscriber<int> s) {
+      auto attempt = ++*attempts;
+      auto o = s.getObserver();
+      o.onNext(attempt);
+      if (attempt < successfulAttempt)
+      {
+         o.onError(std::make_exception_ptr(std::runtime_error("flaky")));
+      }
+      else
+      {
+         o.onCompleted();
+      }
+   });
+}
+
+TEST(retry, resubscribesAfterError)
+{
+   auto attempts = std::make_shared<int>(0);
+   auto recorder = Recorder<int>::create(failUntil(attempts, 3).retry(5));
+
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(retry, givesUpAfterCount)
+{
+   auto attempts = std::make_shared<int>(0);
+   bool isError = false;
+   failUntil(attempts, 100).retry(2).subscribe(Observer<int>(
+      [](const int&) {},
+      []() {},
+      [&isError](std::exception_ptr) { isError = true; }));
+
+   ASSERT_EQ(3, *attempts);
+   ASSERT_TRUE(isError);
+}
+
+TEST(retry, doesNotNestSynchronousAttempts)
+{
+   auto attempts = std::make_shared<int>(0);
+   auto recorder = Recorder<int>::create(failUntil(attempts, 200000).retry(200000));
+
+   ASSERT_EQ(200000u, recorder.toVector().size());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(retryWhen, backsOffOnScheduler)
+{
+   auto scheduler = TestScheduler::create();
+   auto attempts = std::make_shared<int>(0);
+   auto policy = RetryPolicy::exponentialBackoff(
+         5, milliseconds(10), milliseconds(1000), 2.0, 0.0);
+
+   auto recorder = Recorder<int>::create(
+         failUntil(attempts, 3).retryWhen(policy, scheduler));
+   ASSERT_EQ(1, *attempts);
+
+   scheduler.advanceTimeBy(milliseconds(9));
+   ASSERT_EQ(1, *attempts);
+   scheduler.advanceTimeBy(milliseconds(1));
+   ASSERT_EQ(2, *attempts);
+
+   // The second retry waits twice as long.
+   scheduler.advanceTimeBy(milliseconds(19));
+   ASSERT_EQ(2, *attempts);
+   scheduler.advanceTimeBy(milliseconds(1));
+   ASSERT_EQ(3, *attempts);
+
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(retryWhen, stopsAfterUnsubscribe)
+{
+   auto scheduler = TestScheduler::create();
+   auto attempts = std::make_shared<int>(0);
+   auto policy = RetryPolicy::exponentialBackoff(
+         5, milliseconds(10), milliseconds(1000), 2.0, 0.0);
+
+   auto recorder = Recorder<int>::create(
+         failUntil(attempts, 3).retryWhen(policy, scheduler));
+   recorder.unsubscribe();
+
+   scheduler.advanceTimeBy(milliseconds(100));
+   ASSERT_EQ(1, *attempts);
+   ASSERT_FALSE(recorder.isCompleted());
+}
+
+TEST(RetryPolicy, exponentialBackoffIsBoundedAndJittered)
+{
+   auto policy = RetryPolicy::exponentialBackoff(
+         20, milliseconds(10), milliseconds(500), 2.0, 0.5);
+   std::exception_ptr error;
+
+   for (std::size_t attempt = 1; attempt <= 20; ++attempt)
+   {
+      auto ceiling = std::min(milliseconds(10 << (attempt - 1)), milliseconds(500));
+      auto delay = policy.next(error, attempt);
+      ASSERT_TRUE(delay.hasValue());
+      ASSERT_LE(delay.get(), Scheduler::Duration(ceiling));
+      ASSERT_GE(delay.get(), Scheduler::Duration(ceiling) / 2);
+   }
+   ASSERT_FALSE(policy.next(error, 21).hasValue());
+}
+
+// Performance measurements
+TEST(retryWhen, retryPerf)
+{
+   // Every source fails twice and comes back after a short backoff. All
+   // of them wait on the one thread of the default scheduler.
+   const int count = 10000;
+   auto policy = RetryPolicy::exponentialBackoff(
+         3, milliseconds(1), milliseconds(10));
+   std::atomic<int> completed(0);
+   std::promise<void> done;
+
+   auto start = std::chrono::system_clock::now();
+   std::vector<Subscription> subscriptions;
+   for (int i = 0; i < count; ++i)
+   {
+      auto attempts = std::make_shared<int>(0);
+      subscriptions.push_back(failUntil(attempts, 3).retryWhen(policy).subscribe(
+         Observer<int>(
+            [](const int&) {},
+            [&completed, &done]() {
+               if (++completed == count)
+               {
+                  done.set_value();
+               }
+            })));
+   }
+
+   ASSERT_EQ(std::future_status::ready,
+             done.get_future().wait_for(std::chrono::seconds(10)));
+   auto duration = std::chrono::duration_cast<milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "retryWhen duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include "rx/operators/Interval.hpp"
+#include "rx/Observable.hpp"
+#include "rx/schedulers/TestScheduler.hpp"
+#include "rx/schedulers/TimingWheelScheduler.hpp"
+#include "Recorder.hpp"
+
+#include <future>
+#include <thread>
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::hours;
+
+TEST(TestScheduler, firesInDeadlineOrder)
+{
+   auto scheduler = TestScheduler::create();
+   std::vector<int> fired;
+
+   auto start = scheduler.now();
+   scheduler.schedule(start + milliseconds(30), [&fired]() { fired.push_back(3); });
+   scheduler.schedule(start + milliseconds(10), [&fired]() { fired.push_back(1); });
+   scheduler.schedule(start + milliseconds(20), [&fired]() { fired.push_back(2); });
+
+   scheduler.advanceTimeBy(milliseconds(15));
+   ASSERT_EQ(std::vector<int>{ 1 }, fired);
+
+   scheduler.advanceTimeBy(milliseconds(15));
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, fired);
+}
+
+TEST(TestScheduler, coalescesTimersWithinOneTick)
+{
+   auto scheduler = TestScheduler::create(milliseconds(10));
+   std::vector<Scheduler::TimePoint> firedAt;
+
+   auto start = scheduler.now();
+   auto record = [&firedAt, &scheduler]() { firedAt.push_back(scheduler.now()); };
+   scheduler.schedule(start + milliseconds(11), record);
+   scheduler.schedule(start + milliseconds(19), record);
+   scheduler.schedule(start + milliseconds(20), record);
+
+   scheduler.advanceTimeBy(milliseconds(100));
+
+   ASSERT_EQ(3u, firedAt.size());
+   ASSERT_EQ(start + milliseconds(20), firedAt[0]);
+   ASSERT_EQ(start + milliseconds(20), firedAt[1]);
+   ASSERT_EQ(start + milliseconds(20), firedAt[2]);
+}
+
+TEST(TestScheduler, unsubscribeCancels)
+{
+   auto scheduler = TestScheduler::create();
+   bool isFired = false;
+
+   auto subscription = scheduler.schedule(scheduler.now() + milliseconds(10),
+                                          [&isFired]() { isFired = true; });
+   subscription.unsubscribe();
+   scheduler.advanceTimeBy(milliseconds(20));
+
+   ASSERT_FALSE(isFired);
+}
+
+TEST(TestScheduler, rearmMovesDeadline)
+{
+   auto scheduler = TestScheduler::create();
+   std::vector<Scheduler::TimePoint> firedAt;
+
+   auto start = scheduler.now();
+   auto timer = scheduler.createTimer([&firedAt, &scheduler]() {
+      firedAt.push_back(scheduler.now());
+   });
+   timer.arm(start + milliseconds(10));
+   timer.arm(start + milliseconds(500));
+
+   scheduler.advanceTimeBy(milliseconds(100));
+   ASSERT_TRUE(firedAt.empty());
+   ASSERT_TRUE(timer.isArmed());
+
+   scheduler.advanceTimeBy(milliseconds(400));
+   std::vector<Scheduler::TimePoint> expected{ start + milliseconds(500) };
+   ASSERT_EQ(expected, firedAt);
+   ASSERT_FALSE(timer.isArmed());
+}
+
+TEST(TestScheduler, firesBeyondWheelSpan)
+{
+   // 2^24 ticks of 1ms is about 4.6 hours, so this timer starts out parked
+   // in the top level and has to be cascaded down several times.
+   auto scheduler = TestScheduler::create();
+   Scheduler::TimePoint firedAt;
+
+   auto start = scheduler.now();
+   scheduler.schedule(start + hours(5) + milliseconds(3), [&]() {
+      firedAt = scheduler.now();
+   });
+
+   scheduler.advanceTimeBy(hours(6));
+   ASSERT_EQ(start + hours(5) + milliseconds(3), firedAt);
+}
+
+TEST(TestScheduler, periodicDoesNotDrift)
+{
+   auto scheduler = TestScheduler::create();
+   std::vector<Scheduler::TimePoint> firedAt;
+
+   auto start = scheduler.now();
+   auto subscription = scheduler.schedulePeriodically(
+         start + milliseconds(5), milliseconds(10), [&]() {
+            firedAt.push_back(scheduler.now());
+         });
+
+   scheduler.advanceTimeBy(milliseconds(30));
+   subscription.unsubscribe();
+   scheduler.advanceTimeBy(milliseconds(30));
+
+   std::vector<Scheduler::TimePoint> expected{
+      start + milliseconds(5), start + milliseconds(15), start + milliseconds(25) };
+   ASSERT_EQ(expected, firedAt);
+}
+
+TEST(interval, emitsEveryPeriod)
+{
+   auto scheduler = TestScheduler::create();
+   auto recorder = Recorder<long>::create(interval(milliseconds(10), scheduler));
+
+   scheduler.advanceTimeBy(milliseconds(35));
+
+   std::vector<long> expected{ 0, 1, 2 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_FALSE(recorder.isCompleted());
+}
+
+TEST(interval, unsubscribeStopsEmission)
+{
+   auto scheduler = TestScheduler::create();
+   auto recorder = Recorder<long>::create(interval(milliseconds(10), scheduler));
+
+   scheduler.advanceTimeBy(milliseconds(15));
+   recorder.unsubscribe();
+   scheduler.advanceTimeBy(milliseconds(50));
+
+   std::vector<long> expected{ 0 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(timer, emitsOnceAndCompletes)
+{
+   auto scheduler = TestScheduler::create();
+   auto recorder = Recorder<long>::create(timer(milliseconds(10), scheduler));
+
+   scheduler.advanceTimeBy(milliseconds(9));
+   ASSERT_TRUE(recorder.toVector().empty());
+
+   scheduler.advanceTimeBy(milliseconds(1));
+   ASSERT_EQ(std::vector<long>{ 0 }, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(TimingWheelScheduler, firesOnWheelThread)
+{
+   auto scheduler = TimingWheelScheduler::create();
+   std::promise<std::thread::id> fired;
+
+   auto start = scheduler.now();
+   scheduler.schedule(start + milliseconds(20), [&fired]() {
+      fired.set_value(std::this_thread::get_id());
+   });
+
+   auto future = fired.get_future();
+   ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(5)));
+   ASSERT_TRUE(std::this_thread::get_id() != future.get());
+   ASSERT_GE(scheduler.now(), start + milliseconds(20));
+}
+
+TEST(TimingWheelScheduler, lastHandleMayBeDroppedOnWheelThread)
+{
+   auto holder = std::make_shared<std::unique_ptr<TimingWheelScheduler>>(
+         new TimingWheelScheduler(TimingWheelScheduler::create()));
+   std::promise<void> dropped;
+
+   auto& scheduler = **holder;
+   scheduler.schedule(scheduler.now() + milliseconds(5), [holder, &dropped]() {
+      holder->reset();
+      dropped.set_value();
+   });
+
+   auto future = dropped.get_future();
+   ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(5)));
+   // Lets the detached wheel thread finish its loop.
+   std::this_thread::sleep_for(milliseconds(20));
+}
+
+// Performance measurements
+TEST(TimingWheel, armAndCancelPerf)
+{
+   auto scheduler = TestScheduler::create();
+   const int TIMER_COUNT = 100000;
+
+   std::vector<Timer> timers;
+   for (int i = 0; i < TIMER_COUNT; i++)
+   {
+      timers.push_back(scheduler.createTimer([]() {}));
+   }
+
+   auto start = std::chrono::system_clock::now();
+   auto now = scheduler.now();
+
+   for (int i = 0; i < TIMER_COUNT; i++)
+   {
+      timers[i].arm(now + milliseconds(i % 100000));
+   }
+   for (auto& t : timers)
+   {
+      t.cancel();
+   }
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "armAndCancelPerf duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
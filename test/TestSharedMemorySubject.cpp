@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include "rx/SharedMemorySubject.hpp"
+#include "Collector.hpp"
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+struct Quote
+{
+   int m_id;
+   double m_price;
+};
+
+std::string uniqueName(const std::string& test)
+{
+   return "/AltRxCpp-" + test + "-" + std::to_string(getpid());
+}
+
+TEST(SharedMemorySubject, deliversToSubscribersOfOtherMappings)
+{
+   auto name = uniqueName("deliver");
+   auto subject = SharedMemorySubject<Quote>::create(name, 64);
+   auto consumer = SharedMemorySubject<Quote>::open(name);
+
+   Collector<Quote> collector;
+   auto subscription = consumer.subscribe(collector.getObserver());
+
+   for (int i = 0; i < 1000; ++i)
+   {
+      subject.onNext(Quote{ i, i * 0.5 });
+      if (i % 32 == 0)
+      {
+         std::this_thread::sleep_for(milliseconds(1));
+      }
+   }
+   subject.onCompleted();
+
+   ASSERT_TRUE(collector.waitForCompletion());
+   auto values = collector.getValues();
+   ASSERT_FALSE(values.empty());
+   for (std::size_t i = 1; i < values.size(); ++i)
+   {
+      ASSERT_LT(values[i - 1].m_id, values[i].m_id);
+   }
+   ASSERT_EQ(999, values.back().m_id);
+   ASSERT_EQ(999 * 0.5, values.back().m_price);
+}
+
+TEST(SharedMemorySubject, slowReaderSkipsAheadWithoutBlockingWriter)
+{
+   auto name = uniqueName("slow");
+   auto subject = SharedMemorySubject<int>::create(name, 16);
+
+   Collector<int> collector;
+   auto observer = collector.getObserver();
+   auto subscription = subject.subscribe(Observer<int>(
+      [observer](const int& x) {
+         std::this_thread::sleep_for(milliseconds(1));
+         observer.onNext(x);
+      },
+      [observer]() {
+         observer.onCompleted();
+      }));
+
+   const int count = 10000;
+   auto start = std::chrono::steady_clock::now();
+   for (int i = 0; i < count; ++i)
+   {
+      subject.onNext(i);
+   }
+   auto publishTime = std::chrono::steady_clock::now() - start;
+   subject.onCompleted();
+
+   ASSERT_TRUE(collector.waitForCompletion());
+   auto values = collector.getValues();
+   ASSERT_LT(values.size(), std::size_t(count));
+   for (std::size_t i = 1; i < values.size(); ++i)
+   {
+      ASSERT_LT(values[i - 1], values[i]);
+   }
+   ASSERT_EQ(count - 1, values.back());
+   ASSERT_LT(publishTime, milliseconds(count));
+}
+
+TEST(SharedMemorySubject, stopsReadingAfterUnsubscribe)
+{
+   auto name = uniqueName("unsubscribe");
+   auto subject = SharedMemorySubject<int>::create(name, 16);
+
+   std::atomic<int> received(0);
+   std::promise<void> first;
+   auto subscription = subject.subscribe([&received, &first](const int&) {
+      if (++received == 1)
+      {
+         first.set_value();
+      }
+   });
+
+   subject.onNext(1);
+   ASSERT_EQ(std::future_status::ready, first.get_future().wait_for(seconds(10)));
+
+   // Unsubscribing joins the reader thread, nothing arrives afterwards.
+   subscription.unsubscribe();
+   subject.onNext(2);
+   subject.onNext(3);
+   ASSERT_EQ(1, received.load());
+}
+
+TEST(SharedMemorySubject, reportsPublisherError)
+{
+   auto name = uniqueName("error");
+   auto subject = SharedMemorySubject<int>::create(name, 16);
+
+   Collector<int> collector;
+   auto subscription = SharedMemorySubject<int>::open(name).subscribe(
+         collector.getObserver());
+
+   subject.onError(std::make_exception_ptr(std::runtime_error("failed")));
+   ASSERT_FALSE(collector.waitForCompletion());
+}
+
+TEST(SharedMemorySubject, rejectsRingOfOtherType)
+{
+   auto name = uniqueName("type");
+   auto subject = SharedMemorySubject<int>::create(name, 16);
+
+   ASSERT_THROW(SharedMemorySubject<Quote>::open(name), std::runtime_error);
+   ASSERT_THROW(SharedMemorySubject<int>::open(name + "-missing"),
+                std::system_error);
+}
+
+TEST(SharedMemorySubject, deliversToOtherProcess)
+{
+   auto name = uniqueName("process");
+   auto subject = SharedMemorySubject<int>::create(name, 1024);
+
+   int ready[2];
+   ASSERT_EQ(0, pipe(ready));
+
+   auto child = fork();
+   ASSERT_NE(-1, child);
+   if (child == 0)
+   {
+      // Exits with the number of elements received, or 255 on failure.
+      close(ready[0]);
+      std::promise<int> done;
+      int received = 0;
+      int last = -1;
+      auto subscription = SharedMemorySubject<int>::open(name).subscribe(Observer<int>(
+         [&received, &last](const int& x) {
+            received += x == last + 1 ? 1 : 0;
+            last = x;
+         },
+         [&done, &received]() {
+            done.set_value(received);
+         }));
+      char c = 0;
+      if (write(ready[1], &c, 1) != 1)
+      {
+         _exit(255);
+      }
+      auto future = done.get_future();
+      if (future.wait_for(seconds(10)) != std::future_status::ready)
+      {
+         _exit(255);
+      }
+      _exit(future.get());
+   }
+
+   close(ready[1]);
+   char c;
+   ASSERT_EQ(1, read(ready[0], &c, 1));
+   close(ready[0]);
+
+   for (int i = 0; i < 100; ++i)
+   {
+      subject.onNext(i);
+   }
+   subject.onCompleted();
+
+   int status = 0;
+   ASSERT_EQ(child, waitpid(child, &status, 0));
+   ASSERT_TRUE(WIFEXITED(status));
+   ASSERT_EQ(100, WEXITSTATUS(status));
+}
+
+TEST(SharedMemorySubject, PerformanceTest)
+{
+   auto name = uniqueName("performance");
+   auto subject = SharedMemorySubject<long>::create(name, 1 << 16);
+
+   long sum = 0;
+   std::promise<void> done;
+   auto subscription = SharedMemorySubject<long>::open(name).subscribe(Observer<long>(
+      [&sum](const long& x) {
+         sum += x;
+      },
+      [&done]() {
+         done.set_value();
+      }));
+
+   const long count = 10000000;
+   auto start = std::chrono::steady_clock::now();
+   for (long i = 0; i < count; ++i)
+   {
+      subject.onNext(i);
+   }
+   subject.onCompleted();
+   auto future = done.get_future();
+   ASSERT_EQ(std::future_status::ready, future.wait_for(seconds(30)));
+   auto end = std::chrono::steady_clock::now();
+
+   ASSERT_GT(sum, 0);
+   std::cout << "SharedMemorySubject duration: "
+             << std::chrono::duration_cast<milliseconds>(end - start).count()
+             << " milliseconds" << std::endl;
+}
+
+}
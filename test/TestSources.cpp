@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "rx/operators/From.hpp"
+#include "rx/operators/Generate.hpp"
+#include "rx/Observable.hpp"
+#include "Recorder.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+TEST(generate, emitsUntilCompleted)
+{
+   auto fibonacci = generate<int>(std::make_pair(0, 1),
+         [](std::pair<int, int>& state, GenerateEmitter<int>& emitter) {
+            if (state.first > 20)
+            {
+               emitter.onCompleted();
+               return;
+            }
+            emitter.onNext(state.first);
+            state = std::make_pair(state.second, state.first + state.second);
+         });
+
+   std::vector<int> expected{ 0, 1, 1, 2, 3, 5, 8, 13 };
+   auto recorder = Recorder<int>::create(fibonacci);
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+
+   // The state is per subscription.
+   auto second = Recorder<int>::create(fibonacci);
+   ASSERT_EQ(expected, second.toVector());
+}
+
+TEST(generate, stopsStepping)
+{
+   int steps = 0;
+   auto observable = generate<int>(0,
+         [&steps](int& state, GenerateEmitter<int>& emitter) {
+            steps++;
+            emitter.onNext(state++);
+         });
+
+   auto subscription = std::make_shared<Subscription>();
+   Subscriber<int> subscriber(Observer<int>([subscription](const int& x) {
+      if (x == 4)
+      {
+         subscription->unsubscribe();
+      }
+   }));
+   *subscription = subscriber.getSubscription();
+   observable.unsafeSubscribe(subscriber);
+
+   ASSERT_EQ(5, steps);
+}
+
+TEST(generate, stepExceptionIsForwarded)
+{
+   auto observable = generate<int>(0,
+         [](int& state, GenerateEmitter<int>& emitter) {
+            if (state == 2)
+            {
+               throw std::runtime_error("failed");
+            }
+            emitter.onNext(state++);
+         });
+
+   std::vector<int> received;
+   bool isFailed = false;
+   observable.subscribe(Observer<int>(
+         [&received](const int& x) { received.push_back(x); },
+         nullptr,
+         [&isFailed](std::exception_ptr) { isFailed = true; }));
+
+   ASSERT_EQ(std::vector<int>({ 0, 1 }), received);
+   ASSERT_TRUE(isFailed);
+}
+
+TEST(from, iteratorPair)
+{
+   std::list<int> values{ 1, 2, 3 };
+   auto recorder = Recorder<int>::create(from(values.begin(), values.end()));
+
+   ASSERT_EQ(std::vector<int>({ 1, 2, 3 }), recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(from, copiesLvalueContainer)
+{
+   std::vector<int> values{ 1, 2, 3 };
+   auto observable = from(values);
+   values.clear();
+
+   auto recorder = Recorder<int>::create(observable);
+   ASSERT_EQ(std::vector<int>({ 1, 2, 3 }), recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(from, takesOverRvalueContainer)
+{
+   std::vector<std::string> values{ "a", "b" };
+   auto data = values.data();
+   auto observable = from(std::move(values));
+
+   std::vector<const std::string*> addresses;
+   observable.subscribe([&addresses](const std::string& x) {
+      addresses.push_back(&x);
+   });
+
+   // The elements are emitted from the storage that was moved in.
+   ASSERT_EQ(std::vector<const std::string*>({ data, data + 1 }), addresses);
+}
+
+TEST(from, stopsAfterUnsubscribe)
+{
+   std::vector<int> values(10000);
+   std::iota(values.begin(), values.end(), 0);
+
+   int received = 0;
+   auto subscription = std::make_shared<Subscription>();
+   Subscriber<int> subscriber(Observer<int>([subscription, &received](const int& x) {
+      received++;
+      if (x == 10)
+      {
+         subscription->unsubscribe();
+      }
+   }));
+   *subscription = subscriber.getSubscription();
+   from(values).unsafeSubscribe(subscriber);
+
+   ASSERT_EQ(11, received);
+}
+
+TEST(from, fromBatches)
+{
+   std::vector<int> values{ 1, 2, 3, 4, 5 };
+   std::vector<std::vector<int>> batches;
+   bool isCompleted = false;
+
+   fromBatches(values, 2).subscribe(Observer<std::span<const int>>(
+         [&batches](const std::span<const int>& batch) {
+            batches.emplace_back(batch.begin(), batch.end());
+         },
+         [&isCompleted]() { isCompleted = true; }));
+
+   std::vector<std::vector<int>> expected{ { 1, 2 }, { 3, 4 }, { 5 } };
+   ASSERT_EQ(expected, batches);
+   ASSERT_TRUE(isCompleted);
+}
+
+TEST(from, fromBatchesRejectsZeroBatchSize)
+{
+   std::vector<int> values{ 1, 2, 3 };
+   ASSERT_THROW(fromBatches(values, 0), std::invalid_argument);
+}
+
+TEST(from, fromPerf)
+{
+   std::vector<int> values(10000000, 1);
+   auto observable = from(std::move(values));
+
+   auto start = std::chrono::steady_clock::now();
+
+   long sum = 0;
+   observable.subscribe([&sum](const int& x) {
+      sum += x;
+   });
+
+   auto end = std::chrono::steady_clock::now();
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+   std::cout << "from duration: " << duration.count() << " milliseconds" << std::endl;
+
+   ASSERT_EQ(10000000, sum);
+}
+
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "rx/internal/SpscLinkedArrayQueue.hpp"
+
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+TEST(SpscLinkedArrayQueue, keepsOrderAcrossSegments)
+{
+   SpscLinkedArrayQueue<std::string> queue(4);
+   ASSERT_TRUE(queue.isEmpty());
+
+   for (int round = 0; round < 3; ++round)
+   {
+      for (int i = 0; i < 10; ++i)
+      {
+         queue.offer(std::to_string(i));
+      }
+      for (int i = 0; i < 10; ++i)
+      {
+         ASSERT_FALSE(queue.isEmpty());
+         ASSERT_EQ(std::to_string(i), queue.front());
+         queue.pop();
+      }
+      ASSERT_TRUE(queue.isEmpty());
+   }
+}
+
+TEST(SpscLinkedArrayQueue, destroysElementsLeftBehind)
+{
+   auto element = std::make_shared<int>(1);
+   {
+      SpscLinkedArrayQueue<std::shared_ptr<int>> queue(2);
+      for (int i = 0; i < 5; ++i)
+      {
+         queue.offer(element);
+      }
+      queue.pop();
+      ASSERT_EQ(5, element.use_count());
+   }
+   ASSERT_EQ(1, element.use_count());
+}
+
+TEST(SpscLinkedArrayQueue, producerAndConsumerOnDifferentThreads)
+{
+   SpscLinkedArrayQueue<long> queue(16);
+   const long count = 1000000;
+
+   std::thread producer([&queue, count]() {
+      for (long i = 0; i < count; ++i)
+      {
+         queue.offer(i);
+      }
+   });
+
+   long expected = 0;
+   while (expected < count)
+   {
+      if (!queue.isEmpty())
+      {
+         ASSERT_EQ(expected, queue.front());
+         queue.pop();
+         ++expected;
+      }
+   }
+   producer.join();
+   ASSERT_TRUE(queue.isEmpty());
+}
+
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "AllocationCounter.hpp"
+#include "Recorder.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+TEST(Subject, reentrantOnNextIsDeliveredAfterCurrentEmission)
+{
+   auto s = Subject<int>::create();
+   std::vector<int> first;
+   std::vector<int> second;
+
+   s.subscribe([s, &first](const int& x) {
+      first.push_back(x);
+      if (x < 3)
+      {
+         s.onNext(x + 1);
+      }
+   });
+   s.subscribe([&second](const int& x) {
+      second.push_back(x);
+   });
+
+   s.onNext(1);
+
+   // Every subscriber sees 1 before anyone sees 2.
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, first);
+   ASSERT_EQ(expected, second);
+}
+
+TEST(Subject, reentrantOnCompletedKeepsOrder)
+{
+   auto s = Subject<int>::create();
+
+   s.subscribe([s](const int& x) {
+      s.onNext(x + 1);
+      s.onCompleted();
+   });
+   auto recorder = Recorder<int>::create(Observable<int>(s));
+
+   s.onNext(1);
+
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(Subject, reentrantEmissionRunsInConstantStack)
+{
+   // One nested frame per emission would overflow the stack.
+   auto s = Subject<int>::create();
+   int count = 0;
+
+   s.subscribe([s, &count](const int& x) {
+      count++;
+      if (x < 1000000)
+      {
+         s.onNext(x + 1);
+      }
+   });
+
+   s.onNext(1);
+   ASSERT_EQ(1000000, count);
+}
+
+TEST(Subject, observerMayUnsubscribeAnotherSubscriber)
+{
+   auto s = Subject<int>::create();
+   std::vector<int> first;
+   std::vector<int> third;
+   Subscription second;
+
+   s.subscribe([&first, &second](const int& x) {
+      first.push_back(x);
+      second.unsubscribe();
+   });
+   second = s.subscribe([](const int&) {
+      FAIL() << "unsubscribed before the element reached it";
+   });
+   s.subscribe([&third](const int& x) {
+      third.push_back(x);
+   });
+
+   s.onNext(1);
+   s.onNext(2);
+
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, first);
+   ASSERT_EQ(expected, third);
+}
+
+TEST(Subject, emissionIntoOtherSubjectIsDeliveredRightAway)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   std::vector<std::string> events;
+
+   a.subscribe([b](const int& x) {
+      b.onNext(x);
+   });
+   a.subscribe([&events](const int&) {
+      events.push_back("a");
+   });
+   b.subscribe([&events](const int&) {
+      events.push_back("b");
+   });
+
+   a.onNext(1);
+
+   std::vector<std::string> expected{ "b", "a" };
+   ASSERT_EQ(expected, events);
+}
+
+TEST(Subject, failingEmissionKeepsEmissionsDeferredByOtherSubjects)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+
+   Observable<int>(a).subscribe(Observer<int>(
+      [](const int&) {
+         throw std::runtime_error("failed");
+      },
+      nullptr,
+      [](std::exception_ptr e) {
+         std::rethrow_exception(e);
+      }));
+   b.subscribe([a, b](const int& x) {
+      if (x == 1)
+      {
+         b.onNext(2);
+         ASSERT_THROW(a.onNext(0), std::runtime_error);
+      }
+   });
+   auto recorder = Recorder<int>::create(Observable<int>(b));
+
+   b.onNext(1);
+
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+// Performance measurements
+TEST(Subject, subscribeChurnPerf)
+{
+   auto s = Subject<int>::create();
+   auto churn = [&s](int count) {
+      for (int i = 0; i < count; i++)
+      {
+         s.subscribe([](const int&) {}).unsubscribe();
+      }
+   };
+
+   // Once the pools are warm, subscribing takes no new blocks and nothing
+   // else allocates either.
+   churn(1000);
+   auto allocations = ObjectPools::getAllocationCount();
+   auto heapAllocations = getHeapAllocationCount();
+
+   auto start = std::chrono::system_clock::now();
+   churn(1e6);
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   ASSERT_EQ(allocations, ObjectPools::getAllocationCount());
+   ASSERT_EQ(heapAllocations, getHeapAllocationCount());
+   std::cout << "subscribeChurnPerf duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
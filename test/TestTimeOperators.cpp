@@ -0,0 +1,368 @@
+#include <gtest/gtest.h>
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "rx/schedulers/TestScheduler.hpp"
+#include "Recorder.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+using std::chrono::milliseconds;
+
+TEST(debounce, emitsLastElementOfBurst)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(s.debounce(milliseconds(10), scheduler));
+
+   s.onNext(1);
+   scheduler.advanceTimeBy(milliseconds(5));
+   s.onNext(2);
+   scheduler.advanceTimeBy(milliseconds(5));
+   s.onNext(3);
+   scheduler.advanceTimeBy(milliseconds(9));
+   ASSERT_TRUE(recorder.toVector().empty());
+
+   scheduler.advanceTimeBy(milliseconds(1));
+   ASSERT_EQ(std::vector<int>{ 3 }, recorder.toVector());
+
+   s.onNext(4);
+   scheduler.advanceTimeBy(milliseconds(20));
+   std::vector<int> expected{ 3, 4 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(debounce, completeEmitsPendingElement)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(s.debounce(milliseconds(10), scheduler));
+
+   s.onNext(1);
+   s.onCompleted();
+
+   ASSERT_EQ(std::vector<int>{ 1 }, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+
+   scheduler.advanceTimeBy(milliseconds(20));
+   ASSERT_EQ(std::vector<int>{ 1 }, recorder.toVector());
+}
+
+TEST(debounce, unsubscribeCancelsTimer)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(s.debounce(milliseconds(10), scheduler));
+
+   s.onNext(1);
+   recorder.unsubscribe();
+   scheduler.advanceTimeBy(milliseconds(20));
+
+   ASSERT_TRUE(recorder.toVector().empty());
+}
+
+TEST(throttleFirst, dropsElementsWithinWindow)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(s.throttleFirst(milliseconds(10), scheduler));
+
+   s.onNext(1);
+   s.onNext(2);
+   scheduler.advanceTimeBy(milliseconds(9));
+   s.onNext(3);
+   scheduler.advanceTimeBy(milliseconds(1));
+   s.onNext(4);
+   s.onNext(5);
+
+   std::vector<int> expected{ 1, 4 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(sample, emitsLatestElementEveryPeriod)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(s.sample(milliseconds(10), scheduler));
+
+   s.onNext(1);
+   s.onNext(2);
+   scheduler.advanceTimeBy(milliseconds(10));
+   scheduler.advanceTimeBy(milliseconds(10));
+   s.onNext(3);
+   scheduler.advanceTimeBy(milliseconds(5));
+   s.onNext(4);
+   s.onCompleted();
+
+   std::vector<int> expected{ 2, 4 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(buffer, emitsEveryTimespan)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<std::vector<int>>::create(
+         s.buffer(milliseconds(10), 0, scheduler));
+
+   s.onNext(1);
+   s.onNext(2);
+   scheduler.advanceTimeBy(milliseconds(10));
+   s.onNext(3);
+   scheduler.advanceTimeBy(milliseconds(5));
+   s.onCompleted();
+
+   std::vector<std::vector<int>> expected{ { 1, 2 }, { 3 } };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(buffer, emitsEarlyWhenMaxCountIsReached)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<std::vector<int>>::create(
+         s.buffer(milliseconds(10), 2, scheduler));
+
+   s.onNext(1);
+   s.onNext(2);
+   s.onNext(3);
+   ASSERT_EQ(1u, recorder.toVector().size());
+
+   scheduler.advanceTimeBy(milliseconds(10));
+
+   std::vector<std::vector<int>> expected{ { 1, 2 }, { 3 } };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(buffer, rejectsZeroCount)
+{
+   auto s = Subject<int>::create();
+   ASSERT_THROW(s.buffer(0), std::invalid_argument);
+}
+
+TEST(timeout, failsWhenNoElementArrivesInTime)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   std::vector<int> received;
+   bool isTimedOut = false;
+   s.timeout(milliseconds(10), scheduler).subscribe(Observer<int>(
+      [&received](const int& x) { received.push_back(x); },
+      []() {},
+      [&isTimedOut](std::exception_ptr e) {
+         try
+         {
+            std::rethrow_exception(e);
+         }
+         catch (const TimeoutException&)
+         {
+            isTimedOut = true;
+         }
+      }));
+
+   // Every element moves the deadline.
+   for (int i = 1; i <= 3; ++i)
+   {
+      scheduler.advanceTimeBy(milliseconds(6));
+      s.onNext(i);
+   }
+   scheduler.advanceTimeBy(milliseconds(9));
+   ASSERT_FALSE(isTimedOut);
+
+   scheduler.advanceTimeBy(milliseconds(1));
+   ASSERT_TRUE(isTimedOut);
+
+   s.onNext(4);
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, received);
+}
+
+TEST(timeout, switchesToFallback)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto fallback = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         s.timeout(milliseconds(10), fallback, scheduler));
+
+   s.onNext(1);
+   fallback.onNext(100);
+   scheduler.advanceTimeBy(milliseconds(10));
+
+   s.onNext(2);
+   fallback.onNext(101);
+   fallback.onCompleted();
+
+   std::vector<int> expected{ 1, 101 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(timeout, completeCancelsTimer)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto fallback = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         s.timeout(milliseconds(10), fallback, scheduler));
+
+   s.onNext(1);
+   s.onCompleted();
+   scheduler.advanceTimeBy(milliseconds(20));
+   fallback.onNext(100);
+
+   ASSERT_EQ(std::vector<int>{ 1 }, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(streamTimeout, failsAtDeadlineDespiteElements)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   std::vector<int> received;
+   bool isTimedOut = false;
+   s.streamTimeout(milliseconds(10), scheduler).subscribe(Observer<int>(
+      [&received](const int& x) { received.push_back(x); },
+      []() {},
+      [&isTimedOut](std::exception_ptr e) {
+         try
+         {
+            std::rethrow_exception(e);
+         }
+         catch (const TimeoutException&)
+         {
+            isTimedOut = true;
+         }
+      }));
+
+   // Elements do not move the deadline.
+   for (int i = 1; i <= 3; ++i)
+   {
+      scheduler.advanceTimeBy(milliseconds(3));
+      s.onNext(i);
+   }
+   ASSERT_FALSE(isTimedOut);
+
+   scheduler.advanceTimeBy(milliseconds(1));
+   ASSERT_TRUE(isTimedOut);
+
+   s.onNext(4);
+   std::vector<int> expected{ 1, 2, 3 };
+   ASSERT_EQ(expected, received);
+}
+
+TEST(streamTimeout, switchesToFallback)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto fallback = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         s.streamTimeout(milliseconds(10), fallback, scheduler));
+
+   s.onNext(1);
+   scheduler.advanceTimeBy(milliseconds(5));
+   s.onNext(2);
+   scheduler.advanceTimeBy(milliseconds(5));
+
+   s.onNext(3);
+   fallback.onNext(100);
+   fallback.onCompleted();
+
+   std::vector<int> expected{ 1, 2, 100 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(streamTimeout, completeBeforeDeadlineCancelsTimer)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto fallback = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         s.streamTimeout(milliseconds(10), fallback, scheduler));
+
+   s.onNext(1);
+   scheduler.advanceTimeBy(milliseconds(9));
+   s.onCompleted();
+   scheduler.advanceTimeBy(milliseconds(20));
+   fallback.onNext(100);
+
+   ASSERT_EQ(std::vector<int>{ 1 }, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+// Performance measurements
+TEST(debounce, onNextPerf)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(s.debounce(milliseconds(10), scheduler));
+
+   auto start = std::chrono::system_clock::now();
+   auto CYCLE_COUNT = 1e6;
+
+   for (int i = 0; i < CYCLE_COUNT; i++)
+   {
+      s.onNext(i);
+   }
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "debounce onNextPerf duration: " << duration.count() << " milliseconds" << std::endl;
+
+   scheduler.advanceTimeBy(milliseconds(10));
+   ASSERT_EQ(std::vector<int>{ 999999 }, recorder.toVector());
+}
+
+TEST(timeout, onNextPerf)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto recorder = Recorder<int>::create(s.timeout(milliseconds(10), scheduler));
+
+   auto start = std::chrono::system_clock::now();
+   auto CYCLE_COUNT = 1e6;
+
+   for (int i = 0; i < CYCLE_COUNT; i++)
+   {
+      s.onNext(i);
+   }
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "timeout onNextPerf duration: " << duration.count() << " milliseconds" << std::endl;
+   ASSERT_EQ(std::size_t(CYCLE_COUNT), recorder.toVector().size());
+}
+
+TEST(timeout, subscriptionPerf)
+{
+   // Many idle streams, each with its own timeout.
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+   auto errors = 0;
+   std::vector<Subscription> subscriptions;
+
+   auto start = std::chrono::system_clock::now();
+   for (int i = 0; i < 100000; i++)
+   {
+      subscriptions.push_back(s.timeout(milliseconds(10), scheduler).subscribe(
+         Observer<int>([](const int&) {}, []() {},
+                       [&errors](std::exception_ptr) { ++errors; })));
+   }
+   s.onNext(1);
+   scheduler.advanceTimeBy(milliseconds(10));
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "timeout subscriptionPerf duration: " << duration.count() << " milliseconds" << std::endl;
+   ASSERT_EQ(100000, errors);
+}
+
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "rx/operators/Range.hpp"
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "rx/UnicastSubject.hpp"
+#include "rx/schedulers/TestScheduler.hpp"
+#include "Recorder.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+using std::chrono::milliseconds;
+
+TEST(UnicastSubject, passesElementsThrough)
+{
+   auto s = UnicastSubject<int>::create();
+   auto recorder = Recorder<int>::create(s);
+   s.onNext(1);
+   s.onNext(2);
+   s.onCompleted();
+
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(UnicastSubject, buffersUntilSubscribed)
+{
+   auto s = UnicastSubject<int>::create();
+   s.onNext(1);
+   s.onNext(2);
+   s.onCompleted();
+
+   auto recorder = Recorder<int>::create(s);
+
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(UnicastSubject, rejectsSecondSubscriber)
+{
+   auto s = UnicastSubject<int>::create();
+   auto first = Recorder<int>::create(s);
+
+   bool isRejected = false;
+   s.subscribe(Observer<int>(nullptr, nullptr, [&isRejected](std::exception_ptr) {
+      isRejected = true;
+   }));
+   s.onNext(1);
+
+   ASSERT_TRUE(isRejected);
+   ASSERT_EQ(std::vector<int>{ 1 }, first.toVector());
+}
+
+TEST(UnicastSubject, unsubscribeStopsDelivery)
+{
+   auto s = UnicastSubject<int>::create();
+   auto recorder = Recorder<int>::create(s);
+   s.onNext(1);
+   recorder.unsubscribe();
+   s.onNext(2);
+
+   ASSERT_EQ(std::vector<int>{ 1 }, recorder.toVector());
+}
+
+TEST(window, splitsByCount)
+{
+   std::vector<std::vector<int>> windows;
+   range(1,5).window(2).subscribe([&windows](const Observable<int>& w) {
+      windows.push_back(std::vector<int>());
+      auto& current = windows.back();
+      w.subscribe([&current](const int& x) {
+         current.push_back(x);
+      });
+   });
+
+   std::vector<std::vector<int>> expected{ { 1, 2 }, { 3, 4 }, { 5 } };
+   ASSERT_EQ(expected, windows);
+}
+
+TEST(window, rejectsZeroCount)
+{
+   auto s = Subject<int>::create();
+   ASSERT_THROW(s.window(0), std::invalid_argument);
+}
+
+TEST(window, splitsByTime)
+{
+   auto scheduler = TestScheduler::create();
+   auto s = Subject<int>::create();
+
+   std::vector<Recorder<int>> windows;
+   s.window(milliseconds(10), scheduler).subscribe(
+         [&windows](const Observable<int>& w) {
+            windows.push_back(Recorder<int>::create(w));
+         });
+
+   s.onNext(1);
+   s.onNext(2);
+   scheduler.advanceTimeBy(milliseconds(10));
+   s.onNext(3);
+   s.onCompleted();
+
+   ASSERT_EQ(2u, windows.size());
+   std::vector<int> expected{ 1, 2 };
+   ASSERT_EQ(expected, windows[0].toVector());
+   ASSERT_TRUE(windows[0].isCompleted());
+   ASSERT_EQ(std::vector<int>{ 3 }, windows[1].toVector());
+   ASSERT_TRUE(windows[1].isCompleted());
+}
+
+// Performance measurements
+TEST(window, windowPerf)
+{
+   auto start = std::chrono::system_clock::now();
+
+   range(1,1e6).window(10).subscribe([](const Observable<int>& w) {
+      w.subscribe([](const int&) {
+         // do nothing
+      });
+   });
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "window duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "rx/operators/Range.hpp"
+#include "rx/operators/Zip.hpp"
+#include "rx/Observable.hpp"
+#include "rx/Subject.hpp"
+#include "Recorder.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+TEST(zip, pairsElementsInOrder)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<std::string>::create();
+   auto recorder = Recorder<std::string>::create(
+         zip(a, b, [](const int& x, const std::string& y) {
+            return std::to_string(x) + y;
+         }));
+
+   a.onNext(1);
+   a.onNext(2);
+   b.onNext("a");
+   ASSERT_EQ(std::vector<std::string>{ "1a" }, recorder.toVector());
+
+   b.onNext("b");
+   b.onNext("c");
+   std::vector<std::string> expected{ "1a", "2b" };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(zip, completesWhenShortestSourceIsDrained)
+{
+   auto a = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         zip(a, range(10, 11), range(20, 30), [](int x, int y, int z) {
+            return x + y + z;
+         }));
+
+   ASSERT_FALSE(recorder.isCompleted());
+   a.onNext(1);
+   a.onNext(2);
+
+   std::vector<int> expected{ 31, 34 };
+   ASSERT_EQ(expected, recorder.toVector());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(zip, sourceAheadOfPrefetchIsBuffered)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   auto recorder = Recorder<int>::create(
+         zipWithPrefetch(2, [](int x, int y) { return x * 10 + y; }, a, b));
+
+   for (int x = 1; x <= 5; x++)
+   {
+      a.onNext(x);
+   }
+   b.onNext(1);
+   b.onNext(2);
+   a.onNext(6);
+   for (int y = 3; y <= 6; y++)
+   {
+      b.onNext(y);
+   }
+
+   std::vector<int> expected{ 11, 22, 33, 44, 55, 66 };
+   ASSERT_EQ(expected, recorder.toVector());
+}
+
+TEST(zip, rejectsZeroPrefetch)
+{
+   auto a = Subject<int>::create();
+   ASSERT_THROW(zipWithPrefetch(0, [](int x, int y) { return x + y; }, a, a),
+                std::invalid_argument);
+}
+
+TEST(zip, synchronousSources)
+{
+   auto recorder = Recorder<int>::create(
+         zip(range(1, 1000), range(1, 1000), [](int x, int y) { return x + y; }));
+
+   auto values = recorder.toVector();
+   ASSERT_EQ(1000u, values.size());
+   ASSERT_EQ(2, values.front());
+   ASSERT_EQ(2000, values.back());
+   ASSERT_TRUE(recorder.isCompleted());
+}
+
+TEST(zip, sourcesOnDifferentThreads)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   std::atomic<long> sum(0);
+   std::atomic<int> count(0);
+
+   zipWithPrefetch(16, [](int x, int y) { return x * y; }, a, b)
+         .subscribe([&sum, &count](const int& x) {
+            sum += x;
+            count++;
+         });
+
+   const int COUNT = 100000;
+   std::thread producer([&a]() {
+      for (int i = 0; i < COUNT; i++)
+      {
+         a.onNext(1);
+      }
+   });
+   for (int i = 0; i < COUNT; i++)
+   {
+      b.onNext(2);
+   }
+   producer.join();
+
+   ASSERT_EQ(COUNT, count.load());
+   ASSERT_EQ(2L * COUNT, sum.load());
+}
+
+// Performance measurements
+TEST(zip, zipPerf)
+{
+   auto a = Subject<int>::create();
+   auto b = Subject<int>::create();
+   zip(a, b, [](int x, int y) { return x + y; }).subscribe([](const int&) {
+      // do nothing
+   });
+
+   auto start = std::chrono::system_clock::now();
+   auto CYCLE_COUNT = 1e6;
+
+   for (int i = 0; i < CYCLE_COUNT; i++)
+   {
+      a.onNext(i);
+      b.onNext(i);
+   }
+
+   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+       std::chrono::system_clock::now() - start);
+
+   std::cout << "zip duration: " << duration.count() << " milliseconds" << std::endl;
+}
+
+}